@@ -30,6 +30,44 @@
 /*! Macro to split a uint64 into 2 uint32 that the debug macro can handle. */
 #define PRINT_ULL(x)   ((uint32)(((x) >> 32) & 0xFFFFFFFFUL)),((uint32)((x) & 0xFFFFFFFFUL))
 
+/*! Number of event bits in a #rule_events_t. */
+#define RULES_ENGINE_NUM_EVENTS             (64)
+
+/*! Group in the event index for rules that are candidates on every event. */
+#define RULES_ENGINE_ALWAYS_GROUP           RULES_ENGINE_NUM_EVENTS
+
+/*! Number of groups in the event index, one per event bit plus the group
+    for rules that are candidates on every event. */
+#define RULES_ENGINE_EVENT_INDEX_GROUPS     (RULES_ENGINE_NUM_EVENTS + 1)
+
+/*! Number of words in a bitmap with one bit per rule. */
+#define RULES_ENGINE_BITMAP_WORDS(rules_count)  (((rules_count) + 31) / 32)
+
+/*! Number of the current pass through the rules of any rule set, used to
+    tell whether the cached value of a fact is still valid. 0 is never used
+    so a fact that has not been evaluated is never valid. Facts aren't
+    registered anywhere, so they can't be cleared when the number wraps; it
+    is 32 bits wide so a fact left cached would have to sit out 2^32 - 1
+    passes to be mistaken for current. */
+static uint32 rules_engine_pass;
+
+/*! Number of passes through the rules currently running, more than 1 if
+    a rule has started a nested pass. */
+static uint16 rules_engine_pass_depth;
+
+#ifdef RULES_ENGINE_TIMING_LOG_ENABLED
+/*! Counters of fact cache usage since boot. */
+static struct
+{
+    /*! Number of times a cached fact value was used. */
+    uint32 hits;
+    /*! Number of times a fact was evaluated. */
+    uint32 evaluations;
+    /*! Total time spent evaluating facts. */
+    uint32 evaluation_us;
+} rules_engine_fact_stats;
+#endif
+
 
 /*! \brief Current rule status */
 typedef enum
@@ -82,6 +120,20 @@ struct rule_set_tag
     /*! MessageId to send to Tasks in the #nop_tasks list when rules are
      *  no longer in progress. */
     MessageId nop_message_id;
+
+    /*! Indices of the rules, grouped by the event bit that must be set for
+     *  the rule to run and in table order within each group. */
+    uint16 *event_index;
+
+    /*! Offset into #event_index of the start of each group. The entry after
+     *  the last group marks the end of #event_index. */
+    uint16 event_index_start[RULES_ENGINE_EVENT_INDEX_GROUPS + 1];
+
+    /*! Bitmap of the rules to visit in the current pass of the rules. */
+    uint32 *candidates;
+
+    /*! Set while the rules are being run, to detect a nested pass. */
+    bool running;
 };
 
 
@@ -170,15 +222,137 @@ static rule_action_t RulesEngine_RunRule(rule_set_t rule_set, int rule_index)
 #endif
 }
 
+/*! \brief Get the event index group a rule belongs to.
+
+    A rule only runs if all of its events are set, so it only needs to be
+    considered when its lowest event bit is set. Rules that are always
+    evaluated, or that have no events and so match any set of events, are
+    considered on every pass.
+*/
+static unsigned RulesEngine_GetEventGroup(const rule_entry_t *rule)
+{
+    unsigned bit = 0;
+    rule_events_t events = rule->events;
+
+    if (rule->flags == rule_flag_always_evaluate || !events)
+        return RULES_ENGINE_ALWAYS_GROUP;
+
+    while (!(events & 1ULL))
+    {
+        events >>= 1;
+        bit++;
+    }
+    return bit;
+}
+
+/*! \brief Build the index from event bit to the rules it can trigger. */
+static void RulesEngine_BuildEventIndex(rule_set_t rule_set)
+{
+    unsigned group;
+    uint16 rule_index;
+    uint16 fill[RULES_ENGINE_EVENT_INDEX_GROUPS];
+
+    /* Count the rules in each group */
+    memset(rule_set->event_index_start, 0, sizeof(rule_set->event_index_start));
+    for (rule_index = 0; rule_index < rule_set->rules_count; rule_index++)
+    {
+        group = RulesEngine_GetEventGroup(&rule_set->rules[rule_index]);
+        rule_set->event_index_start[group + 1]++;
+    }
+    for (group = 0; group < RULES_ENGINE_EVENT_INDEX_GROUPS; group++)
+    {
+        rule_set->event_index_start[group + 1] += rule_set->event_index_start[group];
+        fill[group] = rule_set->event_index_start[group];
+    }
+
+    /* Fill in the groups in table order */
+    rule_set->event_index = PanicUnlessMalloc(sizeof(*rule_set->event_index) * rule_set->rules_count);
+    for (rule_index = 0; rule_index < rule_set->rules_count; rule_index++)
+    {
+        group = RulesEngine_GetEventGroup(&rule_set->rules[rule_index]);
+        rule_set->event_index[fill[group]++] = rule_index;
+    }
+
+    rule_set->candidates = PanicUnlessMalloc(sizeof(*rule_set->candidates) *
+                                             RULES_ENGINE_BITMAP_WORDS(rule_set->rules_count));
+}
+
+/*! \brief Mark the rules in an event index group as candidates to run. */
+static void RulesEngine_AddCandidates(rule_set_t rule_set, uint32 *candidates, unsigned group)
+{
+    uint16 i;
+
+    for (i = rule_set->event_index_start[group]; i < rule_set->event_index_start[group + 1]; i++)
+    {
+        uint16 rule_index = rule_set->event_index[i];
+        candidates[rule_index / 32] |= 1UL << (rule_index % 32);
+    }
+}
+
+/*! \brief Get the next candidate rule in table order.
+
+    \param candidates Bitmap of candidates, the returned rule is removed.
+    \param words Number of words in the bitmap.
+    \param word Index of the word to start searching from, updated as words
+                are exhausted.
+    \return Index of the rule, or -1 if there are no more candidates.
+*/
+static int RulesEngine_NextCandidate(uint32 *candidates, unsigned words, unsigned *word)
+{
+    for (; *word < words; (*word)++)
+    {
+        uint32 bits = candidates[*word];
+        if (bits)
+        {
+            unsigned bit = 0;
+            while (!(bits & (1UL << bit)))
+                bit++;
+            candidates[*word] = bits & ~(1UL << bit);
+            return (int)(*word * 32 + bit);
+        }
+    }
+    return -1;
+}
+
+/*! \brief Start a new pass, invalidating all cached facts. */
+static void RulesEngine_NewPass(void)
+{
+    if (++rules_engine_pass == 0)
+        rules_engine_pass = 1;
+}
+
 /*! \brief Run all the rules */
 static void RulesEngine_RunRules(rule_set_t rule_set)
 {
     int rule_index;
     rule_events_t events = rule_set->events;
+    unsigned words = RULES_ENGINE_BITMAP_WORDS(rule_set->rules_count);
+    unsigned word = 0;
+    unsigned group;
+    uint32 *candidates = rule_set->candidates;
+    bool nested = rule_set->running;
 
     RULES_LOG_INFO("RulesEngine_RunRules, starting events %08lx%08lx", PRINT_ULL(events));
 
-    for (rule_index = 0; rule_index < rule_set->rules_count; rule_index++)
+    /* A rule that sets an event would start a nested pass, which needs its
+     * own candidates so it doesn't disturb the pass that is running */
+    if (nested)
+        candidates = PanicUnlessMalloc(sizeof(*candidates) * words);
+    rule_set->running = TRUE;
+    RulesEngine_NewPass();
+    rules_engine_pass_depth++;
+
+    /* Only rules whose lowest event is set can match, so just visit those.
+     * The bitmap keeps them in table order. */
+    memset(candidates, 0, sizeof(*candidates) * words);
+    for (group = 0; group < RULES_ENGINE_NUM_EVENTS; group++)
+    {
+        if (events & (1ULL << group))
+            RulesEngine_AddCandidates(rule_set, candidates, group);
+    }
+    RulesEngine_AddCandidates(rule_set, candidates, RULES_ENGINE_ALWAYS_GROUP);
+
+    while ((rule_index = RulesEngine_NextCandidate(candidates, words, &word)) >= 0)
     {
         const rule_entry_t *rule = &rule_set->rules[rule_index];
         rule_state_t *rule_state = &rule_set->rules_state[rule_index];
@@ -270,15 +444,37 @@ static void RulesEngine_RunRules(rule_set_t rule_set)
             }
         }
     }
+
+    /* Facts cached by a nested pass may be stale once it has returned, so
+     * the pass it interrupted gets a new pass number too */
+    rules_engine_pass_depth--;
+    RulesEngine_NewPass();
+
+    rule_set->running = nested;
+    if (nested)
+        free(candidates);
 }
 
 static void RulesEngine_Check(rule_set_t rule_set)
 {
 #ifdef RULES_ENGINE_TIMING_LOG_ENABLED
+    uint32 hits = rules_engine_fact_stats.hits;
+    uint32 evaluations = rules_engine_fact_stats.evaluations;
     rtime_t start = SystemClockGetTimerTime();
     RulesEngine_RunRules(rule_set);
     rtime_t finish = SystemClockGetTimerTime();
     RULES_LOG("RulesEngine_Check timing total run time %u us", rtime_sub(finish, start));
+
+    hits = rules_engine_fact_stats.hits - hits;
+    evaluations = rules_engine_fact_stats.evaluations - evaluations;
+    if (hits || evaluations)
+    {
+        /* Estimate the time saved from the average cost of evaluating a fact */
+        uint32 saved_us = rules_engine_fact_stats.evaluations ?
+            hits * (rules_engine_fact_stats.evaluation_us / rules_engine_fact_stats.evaluations) : 0;
+        RULES_LOG("RulesEngine_Check facts %u cache hits %u evaluations, saved about %u us",
+                  hits, evaluations, saved_us);
+    }
 #else
     RulesEngine_RunRules(rule_set);
 #endif
@@ -306,6 +502,7 @@ rule_set_t RulesEngine_CreateRuleSet(const rule_set_init_params_t *params)
     TaskList_Initialise(&rule_set->nop_tasks);
     rule_set->nop_message_id = params->nop_message_id;
     rule_set->event_task = params->event_task;
+    RulesEngine_BuildEventIndex(rule_set);
 
     return rule_set;
 }
@@ -314,6 +511,8 @@ rule_set_t RulesEngine_CreateRuleSet(const rule_set_init_params_t *params)
 void RulesEngine_DestroyRuleSet(rule_set_t rule_set)
 {
     TaskList_RemoveAllTasks(&rule_set->nop_tasks);
+    free(rule_set->candidates);
+    free(rule_set->event_index);
     free(rule_set->rules_state);
     free(rule_set);
 }
@@ -411,6 +610,30 @@ bool RulesEngine_InProgress(rule_set_t rule_set)
     return rc;
 }
 
+/*! \brief Get the value of a fact. */
+bool RulesEngine_GetFact(rule_fact_t *fact)
+{
+    if (rules_engine_pass_depth && fact->pass == rules_engine_pass)
+    {
+#ifdef RULES_ENGINE_TIMING_LOG_ENABLED
+        rules_engine_fact_stats.hits++;
+#endif
+        return fact->value;
+    }
+
+#ifdef RULES_ENGINE_TIMING_LOG_ENABLED
+    rtime_t start = SystemClockGetTimerTime();
+    fact->value = fact->evaluate();
+    rtime_t finish = SystemClockGetTimerTime();
+    rules_engine_fact_stats.evaluations++;
+    rules_engine_fact_stats.evaluation_us += rtime_sub(finish, start);
+#else
+    fact->value = fact->evaluate();
+#endif
+    fact->pass = rules_engine_pass_depth ? rules_engine_pass : 0;
+    return fact->value;
+}
+
 /*! \brief Register a task to receive notifications that no rules are in progress. */
 void RulesEngine_NopClientRegister(rule_set_t rule_set, Task task)
 {
@@ -94,6 +94,36 @@ typedef struct
 #define RULE_WITH_FLAGS(event, name, message, flags) \
     { event, flags, name, message }
 
+/*! \brief Function pointer definition for a fact.
+
+    A fact is a predicate tested by several rules. Its value must not change
+    while the rules are being run, as it is evaluated at most once per pass
+    through the rules.
+*/
+typedef bool (*rule_fact_func_t)(void);
+
+/*! \brief Definition of a fact and its value cached for the current pass. */
+typedef struct
+{
+    /*! Pointer to the function to evaluate the fact. */
+    rule_fact_func_t evaluate;
+
+    /*! Pass through the rules that #value was evaluated in, 0 if none. */
+    uint32 pass;
+
+    /*! Value of the fact in pass #pass. */
+    bool value;
+} rule_fact_t;
+
+/*! Macro to define a fact, based on its name and the function that
+    evaluates it */
+#define DEFINE_RULE_FACT(name, evaluate) \
+    static rule_fact_t name = { evaluate, 0, FALSE }
+
+/*! Macro used by a rule to get the value of a fact */
+#define RULE_FACT(name) \
+    RulesEngine_GetFact(&(name))
+
 /*! \brief Opaque handle to a rule set instance.
 
     This object contains both a fixed set of rules and the current state
@@ -204,6 +234,18 @@ void RulesEngine_CopyRunParams(rule_set_t rule_set, const void* param, size_t si
 */
 bool RulesEngine_InProgress(rule_set_t rule_set);
 
+/*! \brief Get the value of a fact.
+
+    Within a pass through the rules the fact is evaluated the first time it
+    is requested and the cached value is returned after that. The cached
+    value is discarded at the end of the pass. Outside of a pass the fact is
+    always evaluated.
+
+    \param fact The fact, defined with #DEFINE_RULE_FACT.
+    \return The value of the fact.
+*/
+bool RulesEngine_GetFact(rule_fact_t *fact);
+
 /*! \brief Register a task to receive notifications that no rules are in progress.
 
     When no rules are in progress the #nop_message_id passed in to
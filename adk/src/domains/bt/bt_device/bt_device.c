@@ -322,7 +322,7 @@ bool appDeviceDelete(const bdaddr *bd_addr)
         {
             DeviceList_RemoveDevice(device);
             Device_Destroy(&device);
-            DeviceDbSerialiser_Serialise();
+            DeviceDbSerialiser_SerialiseLater();
 
             BtDevice_PrintAllDevices();
         }
@@ -478,7 +478,7 @@ bool BtDevice_HandleConnectionLibraryMessages(MessageId id, Message message, boo
                     {
                         DeviceList_RemoveDevice(device);
                         Device_Destroy(&device);
-                        DeviceDbSerialiser_Serialise();
+                        DeviceDbSerialiser_SerialiseLater();
 
                         DEBUG_LOG_VERBOSE("BtDevice_HandleConnectionLibraryMessages device removed");
                     }
@@ -1141,7 +1141,7 @@ void BtDevice_SetLastConnectedProfilesForDevice(device_t device, uint8 profile_m
         /* Update the PDL with this profile connection state in the persistent device data. This is in order to ensure
            we don't lose state information in the case of unexpected power loss. N.b. Normally serialisation occurs
            during a controlled shutdown of the App. */
-        DeviceDbSerialiser_Serialise();
+        DeviceDbSerialiser_SerialiseLater();
     }
     Device_SetPropertyU8(device, device_property_last_connected_profiles, connected_profiles);
     DEBUG_LOG("BtDevice_SetLastConnectedProfilesForDevice, device 0x%x connected_profiles %02x", device, connected_profiles);
@@ -1297,7 +1297,7 @@ uint8 BtDevice_SetProfileConnectedAndSupportedFlagsFromPeer(const bdaddr *bd_add
         /* Update the PDL with this state provided by the peer in our persistent device data. This is in order to ensure
            we don't lose state information in the case of unexpected power loss. N.b. Normally serialisation occurs
            during a controlled shutdown of the App. */
-        DeviceDbSerialiser_Serialise();
+        DeviceDbSerialiser_SerialiseLater();
     }
 
     return was_supported;
@@ -12,8 +12,10 @@
 #include "connection_manager_config.h"
 #include <connection_no_ble.h>
 #include <device_list.h>
+#include <message.h>
 #include <panic.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define SIZE_OF_TYPE            0x1
 #define SIZE_OF_LEN             0x1
@@ -45,10 +47,29 @@ uint8 num_registered_pddus = 0;
 
 static bool deserialised = FALSE;
 
+/*! \brief Internal messages of the Device Database Serialiser */
+enum device_db_serialiser_internal_messages
+{
+    /*! Time to make a write requested by DeviceDbSerialiser_SerialiseLater() */
+    DEVICE_DB_SERIALISER_INTERNAL_WRITE
+};
+
+static void deviceDbSerialiser_HandleMessage(Task task, MessageId id, Message message);
+
+static TaskData device_db_serialiser_task = {deviceDbSerialiser_HandleMessage};
+
+static uint32 write_delay_ms = DEVICE_DB_SERIALISER_DEFAULT_WRITE_DELAY_MS;
+
+static bool write_pending = FALSE;
+
+static device_db_serialiser_statistics_t serialiser_statistics;
+
 void DeviceDbSerialiser_Init(void)
 {
     num_registered_pddus = 0;
     deserialised = FALSE;
+    write_pending = FALSE;
+    memset(&serialiser_statistics, 0, sizeof(serialiser_statistics));
 }
 
 void DeviceDbSerialiser_RegisterPersistentDeviceDataUser(
@@ -149,6 +170,14 @@ static void deviceDbSerialiser_SerialiseDevice(device_t device, void *data)
     if (!registered_pddu_list)
         return;
 
+    if (!Device_ArePropertiesChanged(device))
+    {
+        serialiser_statistics.frames_skipped++;
+        return;
+    }
+
+    Device_ClearPropertiesChanged(device);
+
     // Only store bluetooth devices in the PDL, so the device must have a bdaddr
     if (!Device_GetProperty(device, device_property_bdaddr, (void *)&device_bdaddr, &bdaddr_size))
         return;
@@ -167,6 +196,9 @@ static void deviceDbSerialiser_SerialiseDevice(device_t device, void *data)
 
         ConnectionSmPutAttributeReq(0, TYPED_BDADDR_PUBLIC, device_bdaddr, pdd_frame[LEN_OFFSET_IN_FRAME], pdd_frame);
 
+        serialiser_statistics.bytes_written += pdd_frame[LEN_OFFSET_IN_FRAME];
+        serialiser_statistics.frames_written++;
+
         free(pdd_frame);
     }
 
@@ -175,9 +207,54 @@ static void deviceDbSerialiser_SerialiseDevice(device_t device, void *data)
 
 void DeviceDbSerialiser_Serialise(void)
 {
+    if (write_pending)
+    {
+        MessageCancelAll(&device_db_serialiser_task, DEVICE_DB_SERIALISER_INTERNAL_WRITE);
+        write_pending = FALSE;
+    }
+
     DeviceList_Iterate(deviceDbSerialiser_SerialiseDevice, NULL);
 }
 
+void DeviceDbSerialiser_SerialiseLater(void)
+{
+    /* The delay runs from the first request, so a steady stream of changes
+       can't hold the write off indefinitely */
+    if (!write_pending)
+    {
+        MessageSendLater(&device_db_serialiser_task, DEVICE_DB_SERIALISER_INTERNAL_WRITE, NULL, write_delay_ms);
+        write_pending = TRUE;
+    }
+}
+
+void DeviceDbSerialiser_SetWriteDelay(uint32 delay_ms)
+{
+    write_delay_ms = delay_ms;
+}
+
+void DeviceDbSerialiser_GetStatistics(device_db_serialiser_statistics_t *statistics)
+{
+    PanicNull(statistics);
+    *statistics = serialiser_statistics;
+}
+
+static void deviceDbSerialiser_HandleMessage(Task task, MessageId id, Message message)
+{
+    UNUSED(task);
+    UNUSED(message);
+
+    switch (id)
+    {
+        case DEVICE_DB_SERIALISER_INTERNAL_WRITE:
+            write_pending = FALSE;
+            DeviceList_Iterate(deviceDbSerialiser_SerialiseDevice, NULL);
+            break;
+
+        default:
+            break;
+    }
+}
+
 static device_db_serialiser_registered_pddu_t * deviceDbSerialiser_getRegisteredPddu(uint8 id)
 {
     device_db_serialiser_registered_pddu_t * pddu = NULL;
@@ -247,6 +324,9 @@ static void deviceDbSerialiser_GetDeviceAttributesFromPdlAndDeserialise(uint8 pd
         DeviceList_AddDevice(device);
 
         deviceDbSerialiser_deserialisePddFrame(device, *pdd_frame);
+
+        /* The device matches what is stored, so there is nothing to write back */
+        Device_ClearPropertiesChanged(device);
     }
 }
 
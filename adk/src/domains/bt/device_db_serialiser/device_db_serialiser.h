@@ -22,6 +22,27 @@ typedef void (*serialise_persistent_device_data)(device_t device, void *buf, uin
 
 typedef void (*deserialise_persistent_device_data)(device_t device, void *buf, uint8 data_length, uint8 offset);
 
+/*! \brief Default delay in milliseconds before a write requested with
+    #DeviceDbSerialiser_SerialiseLater is made. */
+#ifndef DEVICE_DB_SERIALISER_DEFAULT_WRITE_DELAY_MS
+#define DEVICE_DB_SERIALISER_DEFAULT_WRITE_DELAY_MS (1000)
+#endif
+
+/*! \brief Counts of Persistent Device Data writes made since boot. */
+typedef struct
+{
+    /*! Octets of Persistent Device Data written to the PS store. */
+    uint32 bytes_written;
+
+    /*! Number of device frames written to the PS store. */
+    uint16 frames_written;
+
+    /*! Number of devices not written because none of their properties had
+        changed since they were last written. */
+    uint16 frames_skipped;
+
+} device_db_serialiser_statistics_t;
+
 /*! \brief Initialise the Device Database Serialiser.
 */
 void DeviceDbSerialiser_Init(void);
@@ -49,9 +70,37 @@ void DeviceDbSerialiser_RegisterPersistentDeviceDataUser(
         deserialise_persistent_device_data deser);
 
 /*! \brief Serialise the set of Persistent Device Data.
+
+    Only devices with properties that have changed since they were last
+    serialised are written. The data is written before this function
+    returns, and any write pending from #DeviceDbSerialiser_SerialiseLater
+    is made now.
 */
 void DeviceDbSerialiser_Serialise(void);
 
+/*! \brief Serialise the set of Persistent Device Data after a delay.
+
+    The write is made once the write delay has passed. Further calls made
+    before then are coalesced into the same write, so bursts of changes
+    cost a single write of each changed device. Use
+    #DeviceDbSerialiser_Serialise when the data must be stored straight
+    away, for example before a reboot.
+*/
+void DeviceDbSerialiser_SerialiseLater(void);
+
+/*! \brief Set the delay used by #DeviceDbSerialiser_SerialiseLater.
+
+    \param delay_ms Delay in milliseconds. The default is
+           #DEVICE_DB_SERIALISER_DEFAULT_WRITE_DELAY_MS.
+*/
+void DeviceDbSerialiser_SetWriteDelay(uint32 delay_ms);
+
+/*! \brief Get the counts of Persistent Device Data writes made since boot.
+
+    \param[out] statistics Filled in with the counts.
+*/
+void DeviceDbSerialiser_GetStatistics(device_db_serialiser_statistics_t *statistics);
+
 /*! \brief Deserialise the set of Persistent Device Data.
 */
 void DeviceDbSerialiser_Deserialise(void);
@@ -39,6 +39,8 @@ are delivered before any server access messages.
 The connections and disconnection callback functions MUST be supplied when an observer registers. 
 The disconnect requested callback is optional for those observers that must do some additional processing
 before calling the response callback to say that GATT disconnection can proceed.
+The MTU exchanged callback is optional for those observers that size their data to the MTU, which is
+only known once the MTU exchange has completed after the connection.
 It is assumed an observer will need to know about connections and disconnections.
  */
 typedef struct
@@ -46,6 +48,7 @@ typedef struct
     void (*OnConnection)(uint16 cid);
     void (*OnDisconnection)(uint16 cid);
     void (*OnDisconnectRequested)(uint16 cid, gatt_connect_disconnect_req_response response);
+    void (*OnMtuExchanged)(uint16 cid, unsigned mtu);
 } gatt_connect_observer_callback_t;
 
 /*! \brief Initialise the gatt_connect module.
@@ -9,6 +9,7 @@
 #include "gatt_connect.h"
 #include "gatt_connect_list.h"
 #include "gatt_connect_mtu.h"
+#include "gatt_connect_observer.h"
 
 #include <panic.h>
 
@@ -19,7 +20,12 @@ static unsigned mtu_local;
 static void updateConnectionMtu(unsigned cid, unsigned mtu_remote)
 {
     gatt_connection_t* connection = GattConnect_FindConnectionFromCid(cid);
-    GattConnect_SetMtu(connection, MIN(mtu_local, mtu_remote));
+
+    if(connection)
+    {
+        GattConnect_SetMtu(connection, MIN(mtu_local, mtu_remote));
+        GattConnect_ObserverNotifyOnMtuExchanged(cid, connection->mtu);
+    }
 }
 
 void gattConnect_HandleExchangeMtuInd(GATT_EXCHANGE_MTU_IND_T* ind)
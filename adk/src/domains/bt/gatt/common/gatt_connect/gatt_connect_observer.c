@@ -86,6 +86,22 @@ void GattConnect_ObserverNotifyOnDisconnectRequested(uint16 cid, gatt_connect_di
     }
 }
 
+void GattConnect_ObserverNotifyOnMtuExchanged(uint16 cid, unsigned mtu)
+{
+    unsigned index = 0;
+
+    while (index < gatt_connect_observer_registry.number_registered)
+    {
+        const gatt_connect_observer_callback_t * callback = gatt_connect_observer_registry.callbacks[index];
+
+        if (callback->OnMtuExchanged)
+        {
+            callback->OnMtuExchanged(cid, mtu);
+        }
+        index++;
+    }
+}
+
 unsigned GattConnect_ObserverGetNumberDisconnectReqCallbacksRegistered(void)
 {
     unsigned index = 0;
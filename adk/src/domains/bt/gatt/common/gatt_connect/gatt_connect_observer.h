@@ -33,6 +33,14 @@ void GattConnect_ObserverNotifyOnDisconnection(uint16 cid);
 */
 void GattConnect_ObserverNotifyOnDisconnectRequested(uint16 cid, gatt_connect_disconnect_req_response response);
 
+/*! @brief Called when the MTU of a GATT connection has been exchanged.
+
+    \param cid          The GATT connection ID
+    \param mtu          The MTU of the connection
+
+*/
+void GattConnect_ObserverNotifyOnMtuExchanged(uint16 cid, unsigned mtu);
+
 /*! @brief Get the number of observers that have registered the 'disconnect requested' callback.
 
     \return The number of observers that have registered the 'disconnect requested' callback.
@@ -205,6 +205,10 @@ static profile_t profileManager_GetNextProfile(device_t device, profile_manager_
     if (profileManager_GetProfileRequestOrder(device, type, &profiles_order, &profiles_order_list_size))
     {
         uint8 profile_request_index = profileManager_GetNextProfileRequestIndex(device);
+
+        /* Storing the index can add it to the device's properties, which may
+           move the order, so look the order up again */
+        profileManager_GetProfileRequestOrder(device, type, &profiles_order, &profiles_order_list_size);
         PanicFalse(profile_request_index != profiles_order_list_size);
 
         profile = profiles_order[profile_request_index];
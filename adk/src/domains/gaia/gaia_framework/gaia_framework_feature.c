@@ -10,7 +10,10 @@
 
 #include <logging.h>
 #include <panic.h>
+#include <string.h>
 
+/*! Number of feature IDs, which are the top seven bits of a command ID */
+#define GAIA_FRAMEWORK_NUMBER_OF_FEATURE_IDS (1 << 7)
 
 
 /*! \brief Feature list node */
@@ -38,6 +41,9 @@ struct feature_list_item
 static struct feature_list_item * feature_list;
 static uint8 number_of_registered_features;
 
+/*! Registered features indexed by feature ID, so commands are dispatched without walking the list */
+static struct feature_list_item * feature_table[GAIA_FRAMEWORK_NUMBER_OF_FEATURE_IDS];
+
 
 /*! \brief Creates a new item for the feature list
 
@@ -57,7 +63,7 @@ static struct feature_list_item * gaiaFrameworkFeature_CreateFeatureListItem(uin
 
     \param  feature_id  Feautue Id for the plugin
 
-    \return Returns the feature list entry otherwise the next available empty slot
+    \return Returns the feature list entry otherwise NULL
 */
 static struct feature_list_item * gaiaFrameworkFeature_FindFeature(uint8 feature_id);
 
@@ -78,6 +84,7 @@ void GaiaFrameworkFeature_Init(void)
 
     feature_list = NULL;
     number_of_registered_features = 0;
+    memset(feature_table, 0, sizeof(feature_table));
 }
 
 bool GaiaFrameworkFeature_AddToList(uint8 feature_id, uint8 version_number, gaia_framework_command_handler_fn_t command_handler, gaia_framework_send_all_notifications_fn_t send_notifications)
@@ -86,11 +93,17 @@ bool GaiaFrameworkFeature_AddToList(uint8 feature_id, uint8 version_number, gaia
 
     DEBUG_LOG("GaiaFramework_RegisterFeature");
 
-    if (!gaiaFrameworkFeature_FindFeature(feature_id))
+    if (feature_id >= GAIA_FRAMEWORK_NUMBER_OF_FEATURE_IDS)
+    {
+        DEBUG_LOG("GaiaFramework_RegisterFeature, Feature ID %d is out of range", feature_id);
+        registered = FALSE;
+    }
+    else if (!gaiaFrameworkFeature_FindFeature(feature_id))
     {
         struct feature_list_item * new_feature = gaiaFrameworkFeature_CreateFeatureListItem(feature_id, version_number, command_handler, send_notifications);
         new_feature->next_item = feature_list;
         feature_list = new_feature;
+        feature_table[feature_id] = new_feature;
         number_of_registered_features++;
     }
     else
@@ -241,18 +254,9 @@ static struct feature_list_item * gaiaFrameworkFeature_FindFeature(uint8 feature
 
     DEBUG_LOG("gaiaFrameworkFeature_FindFeature %d", feature_id);
 
-    entry = feature_list;
-
-    while (entry != NULL)
+    if (feature_id < GAIA_FRAMEWORK_NUMBER_OF_FEATURE_IDS)
     {
-        if (entry->feature_id == feature_id)
-        {
-            break;
-        }
-        else
-        {
-            entry = entry->next_item;
-        }
+        entry = feature_table[feature_id];
     }
 
     return entry;
@@ -40,6 +40,7 @@ typedef enum gaia_handler_internal_messages
 static void gaiaFrameworkInternal_GattConnect(uint16 cid);
 static void gaiaFrameworkInternal_GattDisconnect(uint16 cid);
 static void gaiaFrameworkInternal_GattDisconnectRequested(uint16 cid, gatt_connect_disconnect_req_response response);
+static void gaiaFrameworkInternal_GattMtuExchanged(uint16 cid, unsigned mtu);
 static void gaiaFrameworkInternal_MessageHandler(Task task, MessageId id, Message message);
 
 
@@ -47,7 +48,8 @@ static const gatt_connect_observer_callback_t gatt_gaia_observer_callback =
 {
     .OnConnection = gaiaFrameworkInternal_GattConnect,
     .OnDisconnection = gaiaFrameworkInternal_GattDisconnect,
-    .OnDisconnectRequested = gaiaFrameworkInternal_GattDisconnectRequested
+    .OnDisconnectRequested = gaiaFrameworkInternal_GattDisconnectRequested,
+    .OnMtuExchanged = gaiaFrameworkInternal_GattMtuExchanged
 };
 
 
@@ -313,6 +315,7 @@ static void gaiaFrameworkInternal_GattConnect(uint16 cid)
     if (GaiaGetTaskData()->connections_allowed)
     {
         GaiaConnectGatt(cid);
+        GaiaSetGattMtu(cid, GattConnect_GetMtu(cid));
     }
 }
 
@@ -327,6 +330,11 @@ static void gaiaFrameworkInternal_GattDisconnectRequested(uint16 cid, gatt_conne
     GaiaDisconnectGatt(cid);
 }
 
+static void gaiaFrameworkInternal_GattMtuExchanged(uint16 cid, unsigned mtu)
+{
+    GaiaSetGattMtu(cid, mtu);
+}
+
 
 /*! \brief Disconnect any active gaia connection
  */
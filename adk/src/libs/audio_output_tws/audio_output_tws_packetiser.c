@@ -73,6 +73,7 @@ bool AudioOutputTwsPacketiserInit(Task output_task, Source forwarding_source, co
 
     config.time_before_ttp_to_tx = (params->ttp_latency.min_in_ms) * US_PER_MS;
     config.tx_deadline = (TWS_TX_DEADLINE_MILLISECONDS) * US_PER_MS;
+    config.adaptive_packet_size = TRUE;
     
     packetiser = TwsPacketiserMasterInit(&config);
 
@@ -20,19 +20,42 @@
 struct device_tag
 {
     key_value_list_t properties;
+
+    /*! Set when a property is changed, see Device_ArePropertiesChanged() */
+    bool properties_changed;
 };
 
+static device_property_changed_callback_t property_changed_callback = NULL;
+
+static void device_PropertyChanged(device_t device, device_property_t id)
+{
+    device->properties_changed = TRUE;
+    if (property_changed_callback)
+    {
+        property_changed_callback(device, id);
+    }
+}
+
+/* A value passed in from the property's own buffer may have been modified
+   in place, so it is always treated as a change. */
+static bool device_IsPropertyUnchanged(device_t device, device_property_t id, const void *value, size_t size)
+{
+    void *current = NULL;
+    size_t current_size = 0;
+
+    return KeyValueList_Get(device->properties, id, &current, &current_size)
+            && (current != value)
+            && (current_size == size)
+            && (memcmp(current, value, size) == 0);
+}
+
 static bool device_UpdatePropertyIfExistingHelper(device_t device, device_property_t id, uint32 value, size_t size)
 {
     bool was_set = TRUE;
-    if (!KeyValueList_Add(device->properties, id, &value, size))
+    if (!device_IsPropertyUnchanged(device, id, &value, size))
     {
-        Device_RemoveProperty(device, id);
-        if (!KeyValueList_Add(device->properties, id, &value, size))
-        {
-            was_set = FALSE;
-            Panic();
-        }
+        was_set = KeyValueList_Set(device->properties, id, &value, size);
+        device_PropertyChanged(device, id);
     }
     return was_set;
 }
@@ -68,16 +91,20 @@ bool Device_IsPropertySet(device_t device, device_property_t id)
 void Device_RemoveProperty(device_t device, device_property_t id)
 {
     PanicNull(device);
-    KeyValueList_Remove(device->properties, id);
+    if (KeyValueList_IsSet(device->properties, id))
+    {
+        KeyValueList_Remove(device->properties, id);
+        device_PropertyChanged(device, id);
+    }
 }
 
 bool Device_SetProperty(device_t device, device_property_t id, const void *value, size_t size)
 {
     PanicNull(device);
-    if (!KeyValueList_Add(device->properties, id, value, size))
+    if (!device_IsPropertyUnchanged(device, id, value, size))
     {
-        Device_RemoveProperty(device, id);
-        PanicFalse(KeyValueList_Add(device->properties, id, value, size));
+        PanicFalse(KeyValueList_Set(device->properties, id, value, size));
+        device_PropertyChanged(device, id);
     }
     return TRUE;
 }
@@ -90,8 +117,16 @@ bool Device_GetProperty(device_t device, device_property_t id, void **value, siz
 
 bool Device_SetPropertyPtr(device_t device, device_property_t id, const void *value)
 {
+    bool was_set;
+
     PanicNull(device);
-    return KeyValueList_Add(device->properties, id, &value, sizeof(value));
+
+    was_set = KeyValueList_Add(device->properties, id, &value, sizeof(value));
+    if (was_set && property_changed_callback)
+    {
+        property_changed_callback(device, id);
+    }
+    return was_set;
 }
 
 void *Device_GetPropertyPtr(device_t device, device_property_t id)
@@ -172,3 +207,20 @@ bool Device_GetPropertyU8(device_t device, device_property_t id, uint8 *value)
 
     return found;
 }
+
+bool Device_ArePropertiesChanged(device_t device)
+{
+    PanicNull(device);
+    return device->properties_changed;
+}
+
+void Device_ClearPropertiesChanged(device_t device)
+{
+    PanicNull(device);
+    device->properties_changed = FALSE;
+}
+
+void Device_RegisterPropertyChangedCallback(device_property_changed_callback_t callback)
+{
+    property_changed_callback = callback;
+}
@@ -17,6 +17,10 @@ typedef struct device_tag * device_t;
 /*! \brief A device property is represented by a 16bit unsigned integer. */
 typedef uint16 device_property_t;
 
+/*! \brief Function called when a property of a device is set to a new value
+           or removed. */
+typedef void (*device_property_changed_callback_t)(device_t device, device_property_t id);
+
 /*! \brief Create a new device_t object.
 
     If allocating memory for the new object fails this function will panic.
@@ -191,4 +195,37 @@ bool Device_SetPropertyU8(device_t device, device_property_t id, uint8 value);
 */
 bool Device_GetPropertyU8(device_t device, device_property_t id, uint8 *value);
 
+/*! \brief Check if any property of a device has changed.
+
+    A property changes when it is set to a new value or removed. Setting a
+    property to the value it already holds is not a change, and pointer
+    properties set with #Device_SetPropertyPtr are not tracked.
+
+    \param device Device to check.
+
+    \return TRUE if a property has changed since the device was created or
+            #Device_ClearPropertiesChanged was last called; FALSE otherwise.
+*/
+bool Device_ArePropertiesChanged(device_t device);
+
+/*! \brief Forget any changes to the properties of a device.
+
+    Used once the properties have been stored, so that
+    #Device_ArePropertiesChanged only reports later changes.
+
+    \param device Device to clear the changes of.
+*/
+void Device_ClearPropertiesChanged(device_t device);
+
+/*! \brief Register a function to be called when a property of any device
+           changes.
+
+    Unlike #Device_ArePropertiesChanged the callback is also made for
+    pointer properties. Only one function can be registered at a time; it
+    is used by the device list to keep its property indexes up to date.
+
+    \param callback Function to call, or NULL to stop the calls.
+*/
+void Device_RegisterPropertyChangedCallback(device_property_changed_callback_t callback);
+
 #endif // DEVICE_H_
@@ -12,17 +12,195 @@
 #include <device_list.h>
 #include <panic.h>
 
+/*! Number of hash buckets in each property index, must be a power of two */
+#define DEVICE_LIST_INDEX_BUCKETS   (8)
+
+/*! Marks the end of a bucket chain, or a device that is not in an index */
+#define DEVICE_LIST_INDEX_NONE      (0xff)
+
+/*! \brief Index of the devices in the list by the value of one property.
+
+    The slots of the devices in device_list are chained into buckets by the
+    hash of their property value, in slot order so that lookups find devices
+    in the same order as a scan of the list. Devices without the property
+    are not in any bucket.
+*/
+typedef struct
+{
+    /*! The indexed property */
+    device_property_t id;
+
+    /*! First slot in each bucket */
+    uint8 bucket_head[DEVICE_LIST_INDEX_BUCKETS];
+
+    /*! For each slot, the next slot in the same bucket */
+    uint8 *next_slot;
+
+    /*! For each slot, the bucket it is chained into */
+    uint8 *slot_bucket;
+
+} device_list_index_t;
+
 static device_t *device_list = NULL;
 static uint8 trusted_device_list = 0;
 
+static device_list_index_t device_list_indexes[DEVICE_LIST_MAX_INDEXES];
+static uint8 num_device_list_indexes = 0;
+
+/*! \brief Hash a property value into an index bucket (FNV-1a). */
+static uint8 deviceList_HashValue(const void *value, size_t size)
+{
+    const uint8 *octet = (const uint8 *)value;
+    uint32 hash = 2166136261UL;
+
+    while (size--)
+    {
+        hash = (hash ^ *octet++) * 16777619UL;
+    }
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+
+    return (uint8)(hash & (DEVICE_LIST_INDEX_BUCKETS - 1));
+}
+
+static device_list_index_t *deviceList_GetIndex(device_property_t id)
+{
+    int i;
+
+    for (i = 0; i < num_device_list_indexes; i++)
+    {
+        if (device_list_indexes[i].id == id)
+        {
+            return &device_list_indexes[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8 deviceList_GetSlot(device_t device)
+{
+    int i;
+
+    for (i = 0; i < trusted_device_list; i++)
+    {
+        if (device_list[i] == device)
+        {
+            return (uint8)i;
+        }
+    }
+    return DEVICE_LIST_INDEX_NONE;
+}
+
+static void deviceList_IndexUnlink(device_list_index_t *index, uint8 slot)
+{
+    uint8 bucket = index->slot_bucket[slot];
+
+    if (bucket != DEVICE_LIST_INDEX_NONE)
+    {
+        uint8 *link = &index->bucket_head[bucket];
+
+        while (*link != slot)
+        {
+            link = &index->next_slot[*link];
+        }
+        *link = index->next_slot[slot];
+        index->slot_bucket[slot] = DEVICE_LIST_INDEX_NONE;
+    }
+}
+
+static void deviceList_IndexLink(device_list_index_t *index, uint8 slot)
+{
+    void *property;
+    size_t property_size;
+
+    if (Device_GetProperty(device_list[slot], index->id, &property, &property_size))
+    {
+        uint8 bucket = deviceList_HashValue(property, property_size);
+        uint8 *link = &index->bucket_head[bucket];
+
+        while (*link < slot)
+        {
+            link = &index->next_slot[*link];
+        }
+        index->next_slot[slot] = *link;
+        *link = slot;
+        index->slot_bucket[slot] = bucket;
+    }
+}
+
+static void deviceList_HandlePropertyChanged(device_t device, device_property_t id)
+{
+    device_list_index_t *index = deviceList_GetIndex(id);
+
+    if (index)
+    {
+        uint8 slot = deviceList_GetSlot(device);
+
+        if (slot != DEVICE_LIST_INDEX_NONE)
+        {
+            deviceList_IndexUnlink(index, slot);
+            deviceList_IndexLink(index, slot);
+        }
+    }
+}
+
+static void deviceList_DestroyIndexes(void)
+{
+    int i;
+
+    for (i = 0; i < num_device_list_indexes; i++)
+    {
+        free(device_list_indexes[i].next_slot);
+    }
+    memset(device_list_indexes, 0, sizeof(device_list_indexes));
+    num_device_list_indexes = 0;
+
+    Device_RegisterPropertyChangedCallback(NULL);
+}
+
 void DeviceList_Init(uint8 num_devices)
 {
     PanicNotZero(device_list);
+    PanicFalse(num_devices < DEVICE_LIST_INDEX_NONE);
 
     trusted_device_list = num_devices;
 
     device_list = (device_t *)PanicUnlessMalloc(trusted_device_list * sizeof(device_t));
     memset(device_list, 0, (trusted_device_list * sizeof(device_t)));
+
+    Device_RegisterPropertyChangedCallback(deviceList_HandlePropertyChanged);
+}
+
+void DeviceList_AddIndex(device_property_t id)
+{
+    device_list_index_t *index;
+    int i;
+
+    PanicNull(device_list);
+
+    if (deviceList_GetIndex(id))
+    {
+        return;
+    }
+
+    PanicFalse(num_device_list_indexes < DEVICE_LIST_MAX_INDEXES);
+
+    index = &device_list_indexes[num_device_list_indexes++];
+    index->id = id;
+    memset(index->bucket_head, DEVICE_LIST_INDEX_NONE, sizeof(index->bucket_head));
+
+    /* One allocation holds both per-slot arrays */
+    index->next_slot = (uint8 *)PanicUnlessMalloc(2 * trusted_device_list);
+    index->slot_bucket = index->next_slot + trusted_device_list;
+    memset(index->slot_bucket, DEVICE_LIST_INDEX_NONE, trusted_device_list);
+
+    for (i = 0; i < trusted_device_list; i++)
+    {
+        if (device_list[i])
+        {
+            deviceList_IndexLink(index, (uint8)i);
+        }
+    }
 }
 
 unsigned DeviceList_GetNumOfDevices(void)
@@ -51,6 +229,7 @@ void DeviceList_RemoveAllDevices(void)
             device_list[i] = 0;
         }
     }
+    deviceList_DestroyIndexes();
     free(device_list);
     device_list = NULL;
 }
@@ -60,19 +239,27 @@ bool DeviceList_AddDevice(device_t device)
     int i;
     bool added = FALSE;
 
+    /* A device must only be in one slot, or the indexes would miss changes
+       to the properties of its other slots */
+    if (deviceList_GetSlot(device) != DEVICE_LIST_INDEX_NONE)
+    {
+        return added;
+    }
+
     for (i = 0; i < trusted_device_list; i++)
     {
         if (device_list[i] == 0)
         {
+            int index;
+
             device_list[i] = device;
+            for (index = 0; index < num_device_list_indexes; index++)
+            {
+                deviceList_IndexLink(&device_list_indexes[index], (uint8)i);
+            }
             added = TRUE;
             break;
         }
-        else if (device_list[i] == device)
-        {
-            added = FALSE;
-            break;
-        }
     }
 
     return added;
@@ -86,6 +273,12 @@ void DeviceList_RemoveDevice(device_t device)
     {
         if (device_list[i] == device)
         {
+            int index;
+
+            for (index = 0; index < num_device_list_indexes; index++)
+            {
+                deviceList_IndexUnlink(&device_list_indexes[index], (uint8)i);
+            }
             device_list[i] = 0;
             /* Should the device be destroyed by this function? */
             break;
@@ -93,10 +286,45 @@ void DeviceList_RemoveDevice(device_t device)
     }
 }
 
+static bool deviceList_IsMatchingDevice(device_t device, device_property_t id, const void *value, size_t size)
+{
+    void *property;
+    size_t property_size;
+
+    return Device_GetProperty(device, id, &property, &property_size)
+            && (size == property_size) && !memcmp(value, property, size);
+}
+
+static void deviceList_FindMatchingDevicesInIndex(device_list_index_t *index, const void *value, size_t size, bool just_first, device_t *device_array, unsigned *len_device_array)
+{
+    uint8 slot = index->bucket_head[deviceList_HashValue(value, size)];
+    unsigned num_found_devices = 0;
+
+    for ( ; slot != DEVICE_LIST_INDEX_NONE; slot = index->next_slot[slot])
+    {
+        if (deviceList_IsMatchingDevice(device_list[slot], index->id, value, size))
+        {
+            device_array[num_found_devices] = device_list[slot];
+            num_found_devices += 1;
+
+            if (just_first)
+                break;
+        }
+    }
+    *len_device_array = num_found_devices;
+}
+
 static void deviceList_FindMatchingDevices(device_property_t id, const void *value, size_t size, bool just_first, device_t *device_array, unsigned *len_device_array)
 {
     int i;
     unsigned num_found_devices = 0;
+    device_list_index_t *index = deviceList_GetIndex(id);
+
+    if (index)
+    {
+        deviceList_FindMatchingDevicesInIndex(index, value, size, just_first, device_array, len_device_array);
+        return;
+    }
 
     for (i = 0; i < trusted_device_list; i++)
     {
@@ -14,6 +14,9 @@
            DeviceList_Iterate API.*/
 typedef void (*device_list_iterate_callback_t)(device_t device, void *data);
 
+/*! \brief Most properties the device list can be indexed by. */
+#define DEVICE_LIST_MAX_INDEXES (4)
+
 /*! \brief Initialise the device list module. 
 
     \param num_devices maximum number of devices can be stored in tusted device list.
@@ -26,6 +29,25 @@ void DeviceList_Init(uint8 num_devices);
 */
 unsigned DeviceList_GetNumOfDevices(void);
 
+/*! \brief Index the devices in the list by the value of a property.
+
+    Lookups by an indexed property with
+    #DeviceList_GetFirstDeviceWithPropertyValue and
+    #DeviceList_GetAllDevicesWithPropertyValue go straight to the devices
+    whose value hashes the same, instead of checking every device. The index
+    is kept up to date as devices are added and removed and as their
+    properties are set.
+
+    Indexing a property that is already indexed does nothing. At most
+    #DEVICE_LIST_MAX_INDEXES properties can be indexed.
+
+    \note The index is not updated if a property value is modified in place
+    through the pointer returned by Device_GetProperty().
+
+    \param id The property to index.
+*/
+void DeviceList_AddIndex(device_property_t id);
+
 /*! \brief Add a device to the list.
 
     If the device list is full or memory could not be allocated to add the
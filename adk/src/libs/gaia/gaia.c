@@ -1979,6 +1979,68 @@ bool GaiaUpgradeConnect(void)
 }
 
 
+/*************************************************************************
+NAME
+    upgradeDataSize, upgradeDataMap, upgradeDataDrop
+
+DESCRIPTION
+    Access the upgrade data of a large data transfer, which is read from the
+    transport's source unless the RWCP server released the command from its
+    reorder buffer
+
+*/
+static uint16 upgradeDataSize(gaia_transport *transport)
+{
+    Source source = gaiaTransportGetSource(transport);
+
+    if(gaia->upgrade_large_data.segment)
+    {
+        return gaia->upgrade_large_data.segment_size;
+    }
+
+    return (transport->type == gaia_transport_gatt) ? SourceBoundary(source) : SourceSize(source);
+}
+
+static uint8 *upgradeDataMap(gaia_transport *transport)
+{
+    if(gaia->upgrade_large_data.segment)
+    {
+        return gaia->upgrade_large_data.segment + gaia->upgrade_large_data.segment_offset;
+    }
+
+    return (uint8 *) SourceMap(gaiaTransportGetSource(transport));
+}
+
+static void upgradeDataDrop(gaia_transport *transport, uint16 size)
+{
+    if(gaia->upgrade_large_data.segment)
+    {
+        size = MIN(size, gaia->upgrade_large_data.segment_size);
+        gaia->upgrade_large_data.segment_offset += size;
+        gaia->upgrade_large_data.segment_size -= size;
+    }
+    else
+    {
+        SourceDrop(gaiaTransportGetSource(transport), size);
+    }
+}
+
+/*************************************************************************
+NAME
+    clearRwcpSegment
+
+DESCRIPTION
+    Stop reading upgrade data from the command in the RWCP reorder buffer.
+    The buffer belongs to the RWCP server, which frees it.
+
+*/
+static void clearRwcpSegment(void)
+{
+    gaia->upgrade_large_data.segment = NULL;
+    gaia->upgrade_large_data.segment_size = 0;
+    gaia->upgrade_large_data.segment_offset = 0;
+}
+
 /*************************************************************************
 NAME
     GaiaUpgradeDisconnect
@@ -1998,6 +2060,7 @@ bool GaiaUpgradeDisconnect(void)
     {
         UpgradeTransportDisconnectRequest();
         gaia->upgrade_transport = NULL;
+        clearRwcpSegment();
         /* remove the handles attached previously.*/
         StreamAttSourceRemoveAllHandles(transport->state.gatt.cid);
         transport->state.gatt.snk = 0;
@@ -2048,18 +2111,10 @@ static void getNextUpgradeData(gaia_transport *transport)
     uint16 upgrade_len;
     uint8 *data, *upgrade_data_buffer;
     uint8 more_data = 0;
-    Source source = gaiaTransportGetSource(transport);
 
-    if(transport->type == gaia_transport_gatt)
-    {
-        available_bytes = SourceBoundary(source);
-    }
-    else
-    {
-        available_bytes = SourceSize(source);
-    }
+    available_bytes = upgradeDataSize(transport);
 
-    data =  (uint8 *) SourceMap(source);
+    data = upgradeDataMap(transport);
 
     GAIA_DEBUG(("getNextUpgradeData available_bytes %d\n", available_bytes));
     upgrade_len = MIN(available_bytes, UPGRADE_MAX_PARTITION_DATA_BLOCK_SIZE);
@@ -2068,7 +2123,6 @@ static void getNextUpgradeData(gaia_transport *transport)
     if(upgrade_len == available_bytes)
     {
          more_data = gaia->upgrade_large_data.more_data;
-         gaia->upgrade_large_data.in_progress = FALSE;
     }
 
     upgrade_data_buffer = createUpgradeDataReq(upgrade_len, data, more_data);
@@ -2081,15 +2135,23 @@ static void getNextUpgradeData(gaia_transport *transport)
      * always limit the messages that can be queued and outstanding to be
      * processed.
      */
-    if (FALSE == UpgradeFlowControlProcessDataRequest(upgrade_data_buffer,
+    if (UpgradeFlowControlProcessDataRequest(upgrade_data_buffer,
                                         upgrade_len + GAIA_UPGRADE_HEADER_SIZE))
-        UpgradeFlowOffProcessDataRequest(TRUE); /* Flowed off */
+    {
+        /* Queued for processing, so drop it. The transfer is only complete
+           once the last of it has been queued. */
+        upgradeDataDrop(transport, upgrade_len);
+        if(upgrade_len == available_bytes)
+            gaia->upgrade_large_data.in_progress = FALSE;
+    }
+    else
+    {
+        /* Flowed off, the same data is sent again on the next
+           UPGRADE_TRANSPORT_DATA_CFM */
+        UpgradeFlowOffProcessDataRequest(TRUE);
+    }
 
     free(upgrade_data_buffer);
-
-    /* If not flowed off, drop the message as its queued for processing. */
-    if(FALSE == UpgradeIsProcessDataRequestFlowedOff())
-        SourceDrop(source, upgrade_len);
 }
 
 /*************************************************************************
@@ -2146,10 +2208,13 @@ bool GaiaUpgradeControl(uint8 *payload, uint8 payload_length)
             GAIA_DEBUG(("GaiaUpgradeControl, large data transport\n"));
             gaia->upgrade_large_data.in_progress = TRUE;
             gaia->upgrade_large_data.more_data = payload[GAIA_UPGRADE_HEADER_MORE_DATA_OFFSET];
-            gaia_header_bytes = (transport->type == gaia_transport_gatt)?
+            if(gaia->upgrade_large_data.segment)
+                gaia_header_bytes = GAIA_GATT_OFFS_PAYLOAD;
+            else
+                gaia_header_bytes = (transport->type == gaia_transport_gatt)?
                                                     (GAIA_GATT_OFFS_PAYLOAD + GAIA_HANDLE_SIZE + RWCP_HEADER_SIZE):
                                                     GAIA_OFFS_PAYLOAD;
-            SourceDrop(gaiaTransportGetSource(transport), gaia_header_bytes + GAIA_UPGRADE_HEADER_SIZE);
+            upgradeDataDrop(transport, gaia_header_bytes + GAIA_UPGRADE_HEADER_SIZE);
             getNextUpgradeData(transport);
         }
         else
@@ -2459,6 +2524,57 @@ static void get_memory_slots(gaia_transport *transport)
 }
 
 
+/*************************************************************************
+NAME
+    get_memory_pool_statistics
+
+DESCRIPTION
+    Process Gaia Debugging Command GAIA_COMMAND_GET_MEMORY_POOL_STATISTICS
+    The optional payload byte is the index of the first pool to report.
+    Responds with the total number of pools, the index of the first pool
+    reported and, for up to GAIA_MEMORY_POOLS_PER_RESPONSE pools, the block
+    size, total blocks, blocks in use, peak blocks in use, fallbacks to a
+    larger pool and allocation failures, each as a 16-bit value
+*/
+#define GAIA_MEMORY_POOLS_PER_RESPONSE (4)
+#define GAIA_MEMORY_POOL_STATISTICS_SIZE (12)
+
+static void get_memory_pool_statistics(gaia_transport *transport, uint8 payload_length, uint8 *payload)
+{
+    vm_memory_pool_statistics stats[GAIA_MEMORY_POOLS_PER_RESPONSE];
+    uint8 response[2 + GAIA_MEMORY_POOLS_PER_RESPONSE * GAIA_MEMORY_POOL_STATISTICS_SIZE];
+    uint8 *data = response + 2;
+    uint16 first = payload_length ? payload[0] : 0;
+    uint16 pools = VmGetMemoryPoolStatistics(stats, first, GAIA_MEMORY_POOLS_PER_RESPONSE);
+    uint16 count = 0;
+    uint16 i;
+
+    if (first < pools)
+        count = MIN(pools - first, GAIA_MEMORY_POOLS_PER_RESPONSE);
+
+    response[0] = LOW(pools);
+    response[1] = LOW(first);
+
+    for (i = 0; i < count; ++i)
+    {
+        *data++ = HIGH(stats[i].size);
+        *data++ = LOW(stats[i].size);
+        *data++ = HIGH(stats[i].blocks);
+        *data++ = LOW(stats[i].blocks);
+        *data++ = HIGH(stats[i].allocated);
+        *data++ = LOW(stats[i].allocated);
+        *data++ = HIGH(stats[i].max_allocated);
+        *data++ = LOW(stats[i].max_allocated);
+        *data++ = HIGH(stats[i].fallbacks);
+        *data++ = LOW(stats[i].fallbacks);
+        *data++ = HIGH(stats[i].failures);
+        *data++ = LOW(stats[i].failures);
+    }
+
+    send_success_payload(transport, GAIA_COMMAND_GET_MEMORY_POOL_STATISTICS, data - response, response);
+}
+
+
 /*************************************************************************
 NAME
     send_kalimba_message
@@ -2509,6 +2625,17 @@ static bool gaia_handle_debug_command(gaia_transport *transport, uint16 command_
         get_memory_slots(transport);
         return TRUE;
 
+    case GAIA_COMMAND_GET_MEMORY_POOL_STATISTICS:
+        if (validate_payload_length(transport, command_id, payload_length, 0, 1))
+            get_memory_pool_statistics(transport, payload_length, payload);
+
+        return TRUE;
+
+    case GAIA_COMMAND_RESET_MEMORY_POOL_STATISTICS:
+        VmResetMemoryPoolStatistics();
+        send_success(transport, GAIA_COMMAND_RESET_MEMORY_POOL_STATISTICS);
+        return TRUE;
+
     case GAIA_COMMAND_DELETE_PDL:
         ConnectionSmDeleteAllAuthDevices(0);
         send_success(transport, GAIA_COMMAND_DELETE_PDL);
@@ -2925,6 +3052,34 @@ void GaiaRwcpProcessCommand(uint8 *command, uint16 size_command)
         gaiaProcessCommand(transport, vendor_id, command_id, size_payload, payload);
     }
 }
+
+/*************************************************************************
+ *  NAME
+ *      GaiaRwcpProcessBufferedCommand
+ *
+ *  DESCRIPTION
+ *      This function processes a GAIA packet held in the RWCP reorder
+ *      buffer. A large data transfer reads the rest of the packet from it.
+ *
+ *  RETURNS
+ *      TRUE if the upgrade library has taken all of the packet, FALSE if it
+ *      is still being read or was flowed off
+ */
+bool GaiaRwcpProcessBufferedCommand(uint8 *command, uint16 size_command)
+{
+    gaia->upgrade_large_data.segment = command;
+    gaia->upgrade_large_data.segment_size = size_command;
+    gaia->upgrade_large_data.segment_offset = 0;
+
+    GaiaRwcpProcessCommand(command, size_command);
+
+    /* The rest is passed on from UPGRADE_TRANSPORT_DATA_CFM */
+    if(gaia->upgrade_large_data.in_progress)
+        return FALSE;
+
+    clearRwcpSegment();
+    return !UpgradeIsProcessDataRequestFlowedOff();
+}
 /*************************************************************************
  *  NAME
  *      handle_upgrade_transport_data_cfm
@@ -2939,6 +3094,14 @@ void handle_upgrade_transport_data_cfm(uint8 packet_type, upgrade_status_t statu
     if(gaia->upgrade_large_data.in_progress)
     {
         getNextUpgradeData(gaia->upgrade_transport);
+
+        /* Let the RWCP server acknowledge a held segment once all of it is
+           queued for processing */
+        if(!gaia->upgrade_large_data.in_progress && gaia->upgrade_large_data.segment)
+        {
+            clearRwcpSegment();
+            RwcpServerBufferedSegmentTaken();
+        }
         return;
     }
 
@@ -3376,6 +3539,58 @@ bool gaiaProcessData(gaia_transport *transport, uint16 size_data, uint8 *data)
     return (RwcpServerHandleMessage(data, size_data));
 }
 
+/*************************************************************************
+NAME
+    process_batch_commands
+
+DESCRIPTION
+    Process each command of a GAIA_COMMAND_BATCH_COMMANDS in turn, so that
+    their responses can be sent together
+
+    0 bytes  1        2        3        4        5            len+1
+    +--------+--------+--------+--------+--------+--/ /---+ +--/ /---+
+    | LENGTH |   VENDOR ID     |   COMMAND ID    | PAYLOAD  | |  ...   |
+    +--------+--------+--------+--------+--------+--/ /---+ +--/ /---+
+*/
+static void process_batch_commands(gaia_transport *transport, uint16 size_payload, uint8 *payload)
+{
+    uint8 status = GAIA_STATUS_SUCCESS;
+
+    if (transport->batching)
+    {
+        send_ack(transport, GAIA_VENDOR_QTIL, GAIA_COMMAND_BATCH_COMMANDS, GAIA_STATUS_INCORRECT_STATE, 0, NULL);
+        return;
+    }
+
+    gaiaTransportBatchStart(transport);
+
+    while (size_payload > 0)
+    {
+        uint16 length = payload[GAIA_BATCH_OFFS_LENGTH];
+
+        if ((length < GAIA_BATCH_OFFS_PAYLOAD - GAIA_BATCH_OFFS_VENDOR_ID) ||
+            (length + GAIA_BATCH_OFFS_VENDOR_ID > size_payload))
+        {
+            GAIA_CMD_DEBUG(("gaia: bad batch %u/%u\n", length, size_payload));
+            status = GAIA_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        gaiaProcessCommand(transport,
+                           W16(payload + GAIA_BATCH_OFFS_VENDOR_ID),
+                           W16(payload + GAIA_BATCH_OFFS_COMMAND_ID),
+                           length + GAIA_BATCH_OFFS_VENDOR_ID - GAIA_BATCH_OFFS_PAYLOAD,
+                           payload + GAIA_BATCH_OFFS_PAYLOAD);
+
+        payload += length + GAIA_BATCH_OFFS_VENDOR_ID;
+        size_payload -= length + GAIA_BATCH_OFFS_VENDOR_ID;
+    }
+
+    send_ack(transport, GAIA_VENDOR_QTIL, GAIA_COMMAND_BATCH_COMMANDS, status, 0, NULL);
+    gaiaTransportBatchEnd(transport);
+}
+
+
 /*************************************************************************
 NAME
     gaiaProcessCommand
@@ -3402,6 +3617,11 @@ void gaiaProcessCommand(gaia_transport *transport, uint16 vendor_id, uint16 comm
             }
         }
 
+        if ((vendor_id == GAIA_VENDOR_QTIL) && (command_id == GAIA_COMMAND_BATCH_COMMANDS))
+        {
+            process_batch_commands(transport, size_payload, payload);
+            return;
+        }
 
         if ((gaia_app_version == gaia_app_version_2) && (vendor_id == GAIA_VENDOR_QTIL))
         {
@@ -3842,6 +4062,7 @@ void GaiaBuildAndSendSynch(GAIA_TRANSPORT *transport,
             Sink sink = gaiaTransportGetSink((gaia_transport *) transport);
             uint16 packet_length = GAIA_OFFS_PAYLOAD + size_payload;
             uint8 flags = ((gaia_transport *)transport)->flags;
+            uint16 offset;
 
             if (gaia == NULL || sink == NULL)
                 return;
@@ -3857,19 +4078,20 @@ void GaiaBuildAndSendSynch(GAIA_TRANSPORT *transport,
 
             GAIA_TRANS_DEBUG(("gaia: bss %d\n", packet_length));
 
-            if (SinkClaim(sink, packet_length) == BAD_SINK_CLAIM)
+            offset = SinkClaim(sink, packet_length);
+            if (offset == BAD_SINK_CLAIM)
             {
                 GAIA_TRANS_DEBUG(("gaia: no sink\n"));
                 return;
             }
 
-            build_packet(SinkMap(sink), flags, vendor_id, command_id,
+            build_packet(SinkMap(sink) + offset, flags, vendor_id, command_id,
                                 status, size_payload, payload);
 
 #ifdef DEBUG_GAIA_TRANSPORT
             {
                 uint16 idx;
-                uint8 *data = SinkMap(sink);
+                uint8 *data = SinkMap(sink) + offset;
                 GAIA_DEBUG(("gaia: put"));
                 for (idx = 0; idx < packet_length; ++idx)
                     GAIA_DEBUG((" %02x", data[idx]));
@@ -3877,7 +4099,11 @@ void GaiaBuildAndSendSynch(GAIA_TRANSPORT *transport,
             }
 #endif
 
-            SinkFlush(sink, packet_length);
+            /*  This also flushes any responses held back by a batch  */
+            SinkFlush(sink, offset + packet_length);
+#if defined GAIA_TRANSPORT_RFCOMM || defined GAIA_TRANSPORT_SPP
+            ((gaia_transport *) transport)->state.spp.size_unflushed = 0;
+#endif
         }
         break;
 
@@ -3913,6 +4139,7 @@ void GaiaBuildAndSendSynch16(GAIA_TRANSPORT *transport,
         Sink sink = gaiaTransportGetSink((gaia_transport *) transport);
         uint16 packet_length = GAIA_OFFS_PAYLOAD + 2 * size_payload;
         uint8 flags = ((gaia_transport *)transport)->flags;
+        uint16 offset;
 
         if (gaia == NULL || sink == NULL)
             return;
@@ -3928,16 +4155,21 @@ void GaiaBuildAndSendSynch16(GAIA_TRANSPORT *transport,
         if (packet_length > GAIA_MAX_PACKET)
             return;
 
-        if (SinkClaim(sink, packet_length) == BAD_SINK_CLAIM)
+        offset = SinkClaim(sink, packet_length);
+        if (offset == BAD_SINK_CLAIM)
         {
             GAIA_TRANS_DEBUG(("gaia: no sink\n"));
             return;
         }
 
-        build_packet_16(SinkMap(sink), flags, vendor_id, command_id,
+        build_packet_16(SinkMap(sink) + offset, flags, vendor_id, command_id,
                             status, size_payload, payload);
 
-        SinkFlush(sink, packet_length);
+        /*  This also flushes any responses held back by a batch  */
+        SinkFlush(sink, offset + packet_length);
+#if defined GAIA_TRANSPORT_RFCOMM || defined GAIA_TRANSPORT_SPP
+        ((gaia_transport *) transport)->state.spp.size_unflushed = 0;
+#endif
     }
 }
 
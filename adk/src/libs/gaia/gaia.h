@@ -193,6 +193,9 @@ Copyright (c) 2010 - 2018 Qualcomm Technologies International, Ltd.
 #define GAIA_COMMAND_SEND_APPLICATION_MESSAGE (0x0721)
 #define GAIA_COMMAND_SEND_KALIMBA_MESSAGE (0x0722)
 #define GAIA_COMMAND_GET_MEMORY_SLOTS (0x0730)
+#define GAIA_COMMAND_GET_MEMORY_POOL_STATISTICS (0x0731)
+#define GAIA_COMMAND_RESET_MEMORY_POOL_STATISTICS (0x0732)
+#define GAIA_COMMAND_BATCH_COMMANDS (0x0740)
 #define GAIA_COMMAND_DELETE_PDL (0x0750)
 #define GAIA_COMMAND_SET_BLE_CONNECTION_PARAMETERS (0x0752)
 
@@ -870,6 +873,17 @@ Sink GaiaTransportGetSink(GAIA_TRANSPORT *transport);
 void GaiaConnectGatt(uint16 cid);
 
 
+/*!
+    @brief Tells GAIA the ATT MTU of a GATT connection, which bounds
+           how many responses to a GAIA_COMMAND_BATCH_COMMANDS can be
+           coalesced into one notification.
+
+    @param cid The connection identifier from the application
+    @param mtu The ATT MTU of the connection
+*/
+void GaiaSetGattMtu(uint16 cid, uint16 mtu);
+
+
 /*!
     @brief Disassociates a CID.  This will disappear once we have
            GattGetHandleFromUuid() etc.
@@ -950,6 +964,15 @@ void GaiaVoiceAssistantCancelRequest(GAIA_TRANSPORT *transport, gaia_va_cancel_r
  */
 void GaiaRwcpProcessCommand(uint8 *command, uint16 size_command);
 
+/*! @brief Process a GAIA command the RWCP server held in its reorder buffer.
+
+    The RWCP server keeps the command. If this returns FALSE, GAIA may still
+    be reading it and calls RwcpServerBufferedSegmentTaken() once it is done.
+
+    @return TRUE if the upgrade library has taken all of the command
+ */
+bool GaiaRwcpProcessBufferedCommand(uint8 *command, uint16 size_command);
+
 /* @brief Process the notification sent from RWCP server */
 void GaiaRwcpSendNotification(uint8 *payload, uint16 payload_length);
 
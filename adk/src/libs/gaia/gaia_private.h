@@ -178,6 +178,19 @@ typedef enum
 #define GAIA_GATT_OFFS_PAYLOAD (4)
 
 #define GAIA_GATT_HEADER_SIZE ((GAIA_GATT_OFFS_PAYLOAD) - (GAIA_GATT_OFFS_VENDOR_ID))
+
+/*  Offsets into a command of a GAIA_COMMAND_BATCH_COMMANDS payload */
+#define GAIA_BATCH_OFFS_LENGTH (0)
+#define GAIA_BATCH_OFFS_VENDOR_ID (1)
+#define GAIA_BATCH_OFFS_COMMAND_ID (3)
+#define GAIA_BATCH_OFFS_PAYLOAD (5)
+
+/*  ATT MTU assumed until the application tells us otherwise */
+#define GAIA_GATT_DEFAULT_MTU (23)
+
+/*  Octets of the ATT MTU used by a notification's opcode and handle */
+#define GAIA_GATT_NOTIFICATION_OVERHEAD (3)
+
 #define GAIA_GATT_RESPONSE_STATUS_SIZE (1)
 
 #define GAIA_SOF (0xFF)
@@ -321,6 +334,7 @@ typedef enum
     GAIA_INTERNAL_REBOOT_REQ,
     GAIA_INTERNAL_DFU_REQ,
     GAIA_INTERNAL_DFU_TIMEOUT,
+    GAIA_INTERNAL_BATCH_END_REQ,
     GAIA_INTERNAL_ATT_STREAMS_BUFFER_UNAVAILABLE /*This message is sent for upgrade cases on GATT transport when ATT streams SinkSlack is unavailable*/
 } gaia_internal_message;
 
@@ -348,6 +362,14 @@ typedef struct
     gaia_transport *transport;
 } GAIA_INTERNAL_DISCONNECT_REQ_T;
 
+
+/*! @brief definition of internal message to flush the responses to a batch of commands.
+ */
+typedef struct
+{
+    gaia_transport *transport;
+} GAIA_INTERNAL_BATCH_END_REQ_T;
+
 /*! @brief definition of internal timer message to check battery level for host on specified transport.
  */
 typedef struct
@@ -384,6 +406,7 @@ typedef struct
 {
     uint16 rfcomm_channel;          /*!< RFCOMM channel used by this transport. */
     Sink sink;                      /*!< Stream sink of this transport. */
+    uint16 size_unflushed;          /*!< octets of a batched response written but not flushed. */
 } gaia_transport_spp_data;
 
 /* helper macro to get SPP specific transport data from generic gaia_transport pointer */
@@ -409,6 +432,10 @@ typedef struct
     Sink snk;
     uint16 handle_data_endpoint;
     uint16 handle_response_endpoint;
+    uint16 mtu;              /*!< ATT MTU of the connection. */
+    uint16 size_batch;       /*!< octets in batch. */
+    uint16 size_batch_max;   /*!< octets allocated for batch, fixed when the batch starts. */
+    uint8 *batch;            /*!< responses coalesced while batching. */
 } gaia_transport_gatt_data;
 #endif /* GAIA_TRANSPORT_GATT */
 
@@ -424,7 +451,8 @@ struct _gaia_transport
     unsigned notify_dfu_state:1;    /*!< enable notification of DFU state changes */
     unsigned notify_vmup:1;         /*!< enable notification of VM Upgrade Protocol */
     unsigned has_voice_assistant:1; /*!< host supports device's version of VA protocol */
-    unsigned :10;                    /*!< explicitly track unused bits in this word */
+    unsigned batching:1;            /*!< processing a GAIA_COMMAND_BATCH_COMMANDS */
+    unsigned :9;                    /*!< explicitly track unused bits in this word */
 
     int16 battery_lo_threshold[2];
     int16 battery_hi_threshold[2];
@@ -500,6 +528,9 @@ typedef struct
 {
     uint8 more_data;
     uint16 in_progress;
+    uint8 *segment;             /*!< Command released from the RWCP reorder buffer, read in place of the source */
+    uint16 segment_size;        /*!< Octets of the segment not yet read */
+    uint16 segment_offset;      /*!< Offset of the first octet not yet read */
 }gaia_upgrade_large_data;
 
 /*! @brief Gaia library main task and state structure. */
@@ -155,7 +155,8 @@ NAME
     gaiaTransportStreamSendPacket
 
 DESCRIPTION
-    Copy the passed packet to the transport sink and flush it
+    Copy the passed packet to the transport sink and flush it, unless it
+    is a response to a batch of commands, which are flushed together
     If <task> is not NULL, send a confirmation message
 */
 static void gaiaTransportStreamSendPacket(Task task, gaia_transport *transport, uint16 length, uint8 *data)
@@ -187,7 +188,12 @@ static void gaiaTransportStreamSendPacket(Task task, gaia_transport *transport,
             }
 #endif
             if(status == TRUE)
-                status = TransportMgrDataSend(type, cid, length);
+            {
+                if (transport->batching)
+                    transport->state.spp.size_unflushed += length;
+                else
+                    status = TransportMgrDataSend(type, cid, length);
+            }
         }
     }
 
@@ -198,6 +204,26 @@ static void gaiaTransportStreamSendPacket(Task task, gaia_transport *transport,
         free(data);
 }
 
+/*************************************************************************
+NAME
+    gaiaTransportStreamBatchEnd
+
+DESCRIPTION
+    Flush the responses to a batch of commands in one go
+*/
+static void gaiaTransportStreamBatchEnd(gaia_transport *transport)
+{
+    transport->batching = FALSE;
+
+    if (transport->state.spp.size_unflushed)
+    {
+        GAIA_TRANS_DEBUG(("gaia: batch flush %u\n", transport->state.spp.size_unflushed));
+        TransportMgrDataSend(transport->type, transport->state.spp.rfcomm_channel,
+                             transport->state.spp.size_unflushed);
+        transport->state.spp.size_unflushed = 0;
+    }
+}
+
 
 
 /*! @brief Attempt to find the tranport associated with a sink
@@ -403,6 +429,7 @@ void gaiaTransportDropState(gaia_transport *transport)
         case gaia_transport_rfcomm:
         case gaia_transport_spp:
             transport->state.spp.sink = NULL;
+            transport->state.spp.size_unflushed = 0;
             break;
 #endif
 
@@ -420,6 +447,7 @@ void gaiaTransportDropState(gaia_transport *transport)
         transport->connected = FALSE;
         transport->enabled = FALSE;
         transport->has_voice_assistant = FALSE;
+        transport->batching = FALSE;
         transport->type = gaia_transport_none;
 
         /* No longer have a Gaia connection over this transport, ensure we reset any threshold state */
@@ -531,6 +559,61 @@ void gaiaTransportSendPacket(Task task, gaia_transport *transport,
     }
 }
 
+/*! @brief Start coalescing the responses to a batch of commands.
+ */
+void gaiaTransportBatchStart(gaia_transport *transport)
+{
+    transport->batching = TRUE;
+
+    switch (transport->type)
+    {
+#if defined GAIA_TRANSPORT_RFCOMM || defined GAIA_TRANSPORT_SPP
+        case gaia_transport_rfcomm:
+        case gaia_transport_spp:
+            transport->state.spp.size_unflushed = 0;
+            break;
+#endif
+
+#ifdef GAIA_TRANSPORT_GATT
+        case gaia_transport_gatt:
+            gaiaTransportGattBatchStart(transport);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/*! @brief Send the coalesced responses to a batch of commands.
+ */
+void gaiaTransportBatchEnd(gaia_transport *transport)
+{
+    switch (transport->type)
+    {
+#if defined GAIA_TRANSPORT_RFCOMM || defined GAIA_TRANSPORT_SPP
+        case gaia_transport_rfcomm:
+        case gaia_transport_spp:
+            {
+                /*  Responses are queued as GAIA_INTERNAL_SEND_REQ; flush after the last  */
+                MESSAGE_PMAKE(m, GAIA_INTERNAL_BATCH_END_REQ_T);
+                m->transport = transport;
+                MessageSend(&gaia->task_data, GAIA_INTERNAL_BATCH_END_REQ, m);
+            }
+            break;
+#endif
+
+#ifdef GAIA_TRANSPORT_GATT
+        case gaia_transport_gatt:
+            gaiaTransportGattBatchEnd(transport);
+            transport->batching = FALSE;
+            break;
+#endif
+        default:
+            transport->batching = FALSE;
+            break;
+    }
+}
+
 /*! @brief Get the stream source for a given transport.
  */
 Source gaiaTransportGetSource(gaia_transport *transport) {
@@ -739,8 +822,14 @@ void gaiaTransportProcessSource(gaia_transport *transport)
             if (locals->idx < locals->data_length) {
                 MESSAGE_PMAKE(more, GAIA_INTERNAL_MORE_DATA_T); GAIA_TRANS_DEBUG(("gaia: more: %d < %d\n", locals->idx, locals->data_length));
                 more->transport = transport;
-                MessageSendLater(&gaia->task_data, GAIA_INTERNAL_MORE_DATA, more,
-                        APP_BUSY_WAIT_MILLIS);
+
+                /*  A pipelined command follows the one just consumed; don't wait for it  */
+                if ((locals->packet_length == locals->expected) && !gaia->upgrade_large_data.in_progress)
+                    MessageSend(&gaia->task_data, GAIA_INTERNAL_MORE_DATA, more);
+
+                else
+                    MessageSendLater(&gaia->task_data, GAIA_INTERNAL_MORE_DATA, more,
+                            APP_BUSY_WAIT_MILLIS);
             }
         }
 
@@ -766,6 +855,15 @@ bool gaiaTransportHandleMessage(Task task, MessageId id, Message message)
             }
             break;
 
+#if defined GAIA_TRANSPORT_RFCOMM || defined GAIA_TRANSPORT_SPP
+        case GAIA_INTERNAL_BATCH_END_REQ:
+            {
+                GAIA_INTERNAL_BATCH_END_REQ_T *m = (GAIA_INTERNAL_BATCH_END_REQ_T *) message;
+                gaiaTransportStreamBatchEnd(m->transport);
+            }
+            break;
+#endif
+
         case TRANSPORT_MGR_MORE_DATA:
             {
                 TRANSPORT_MGR_MORE_DATA_T *m = (TRANSPORT_MGR_MORE_DATA_T*) message;
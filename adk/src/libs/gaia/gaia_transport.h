@@ -45,6 +45,14 @@ void gaiaTransportStopService(gaia_transport_type transport_type, uint16 link_id
  */
 void gaiaTransportSendPacket(Task task, gaia_transport *transport, uint16 length, uint8 *data);
 
+/*! @brief Start coalescing the responses to a batch of commands.
+ */
+void gaiaTransportBatchStart(gaia_transport *transport);
+
+/*! @brief Send the coalesced responses to a batch of commands.
+ */
+void gaiaTransportBatchEnd(gaia_transport *transport);
+
 /*! @brief Get the stream source for a given transport.
  *
  * NOTE - only applicable to the SPP transport.
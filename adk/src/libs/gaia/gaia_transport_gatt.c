@@ -6,6 +6,7 @@ Copyright (c) 2011 - 2020 Qualcomm Technologies International, Ltd.
 #include "gaia_transport_gatt.h"
 #include "gaia_transport.h"
 #include "gaia_transport_common.h"
+#include "rwcp_server.h"
 #include <source.h>
 #include <stdio.h>
 #include <sink.h>
@@ -15,6 +16,8 @@ Copyright (c) 2011 - 2020 Qualcomm Technologies International, Ltd.
 
 #include "gaia_db.h"
 
+static void populate_response_header(uint16 vendor_id, uint16 command_id, uint8 *response_header);
+
 static void process_command(gaia_transport *transport, uint16 size_command, uint8 *command)
 {
 /*  Short packets are by definition badly framed and hence silently ignored  */
@@ -90,6 +93,7 @@ void GaiaConnectGatt(uint16 cid)
 
         transport->state.gatt.config_not = TRUE; /* we're really supposed to persist these */
         transport->state.gatt.config_ind = FALSE;
+        transport->state.gatt.mtu = GAIA_GATT_DEFAULT_MTU;
 
         ok = TRUE;
     }
@@ -98,6 +102,21 @@ void GaiaConnectGatt(uint16 cid)
 }
 
 
+/*! @brief
+ */
+void GaiaSetGattMtu(uint16 cid, uint16 mtu)
+{
+    gaia_transport *transport = gaiaTransportFromCid(cid);
+
+    GAIA_TRANS_DEBUG(("gaia: mtu cid=0x%04X mtu=%u\n", cid, mtu));
+
+    if (transport && mtu >= GAIA_GATT_DEFAULT_MTU)
+    {
+        transport->state.gatt.mtu = mtu;
+    }
+}
+
+
 /*! @brief
  */
 void GaiaDisconnectGatt(uint16 cid)
@@ -137,6 +156,118 @@ void gaiaTransportGattRegisterServer(uint16 start_handle, uint16 end_handle)
 }
 
 
+/*************************************************************************
+NAME
+    batch_size_max
+
+DESCRIPTION
+    Returns the most octets that can be sent in one notification
+*/
+static uint16 batch_size_max(gaia_transport *transport)
+{
+    return transport->state.gatt.mtu - GAIA_GATT_NOTIFICATION_OVERHEAD;
+}
+
+
+/*************************************************************************
+NAME
+    batch_flush
+
+DESCRIPTION
+    Notify the central of the responses coalesced so far, if there are any
+
+    0 bytes  1        2        3        4        5        6           n+6
+    +--------+--------+--------+--------+--------+--------+--/ /---+ +--/ /---+
+    |   VENDOR ID     |   COMMAND ID    | STATUS | LENGTH | RESPONSE | |  ...   |
+    +--------+--------+--------+--------+--------+--------+--/ /---+ +--/ /---+
+*/
+static void batch_flush(gaia_transport *transport)
+{
+    if (transport->state.gatt.size_batch > GAIA_GATT_OFFS_PAYLOAD + 1)
+    {
+        transport->batching = FALSE;
+        gaiaTransportGattRes(transport, transport->state.gatt.size_batch,
+                             transport->state.gatt.batch, HANDLE_GAIA_RESPONSE_ENDPOINT);
+        transport->batching = TRUE;
+    }
+
+    transport->state.gatt.size_batch = 0;
+}
+
+
+/*************************************************************************
+NAME
+    batch_add
+
+DESCRIPTION
+    Coalesce a response with the others sent while processing a batch of
+    commands. Returns FALSE if the response is too long to coalesce.
+*/
+static bool batch_add(gaia_transport *transport, uint16 size_response, uint8 *response)
+{
+    uint16 size_max = transport->state.gatt.size_batch_max;
+    uint8 *batch = transport->state.gatt.batch;
+
+    if (batch == NULL || size_response > 0xFF ||
+        GAIA_GATT_OFFS_PAYLOAD + 2 + size_response > size_max)
+    {
+        return FALSE;
+    }
+
+    if (transport->state.gatt.size_batch + 1 + size_response > size_max)
+    {
+        batch_flush(transport);
+    }
+
+    if (transport->state.gatt.size_batch == 0)
+    {
+        populate_response_header(GAIA_VENDOR_QTIL, GAIA_COMMAND_BATCH_COMMANDS | GAIA_ACK_MASK, batch);
+        batch[GAIA_GATT_OFFS_PAYLOAD] = GAIA_STATUS_SUCCESS;
+        transport->state.gatt.size_batch = GAIA_GATT_OFFS_PAYLOAD + 1;
+    }
+
+    batch += transport->state.gatt.size_batch;
+    *batch++ = (uint8) size_response;
+    memcpy(batch, response, size_response);
+    transport->state.gatt.size_batch += 1 + size_response;
+
+    return TRUE;
+}
+
+
+/*************************************************************************
+NAME
+    gaiaTransportGattBatchStart
+
+DESCRIPTION
+    Start coalescing responses into as few notifications as possible
+*/
+void gaiaTransportGattBatchStart(gaia_transport *transport)
+{
+    transport->state.gatt.size_batch_max = batch_size_max(transport);
+    transport->state.gatt.batch = malloc(transport->state.gatt.size_batch_max);
+    transport->state.gatt.size_batch = 0;
+}
+
+
+/*************************************************************************
+NAME
+    gaiaTransportGattBatchEnd
+
+DESCRIPTION
+    Notify the central of any coalesced responses and stop coalescing
+*/
+void gaiaTransportGattBatchEnd(gaia_transport *transport)
+{
+    if (transport->state.gatt.batch)
+    {
+        batch_flush(transport);
+        free(transport->state.gatt.batch);
+        transport->state.gatt.batch = NULL;
+    }
+}
+
+
 /*************************************************************************
 NAME
     gaiaTransportGattRes
@@ -155,6 +286,20 @@ void gaiaTransportGattRes(gaia_transport *transport, uint16 size_response, uint8
             return;
         }
 
+        if (transport->batching && (handle == HANDLE_GAIA_RESPONSE_ENDPOINT))
+        {
+            if (batch_add(transport, size_response, response))
+            {
+                return;
+            }
+
+            /* Too long to coalesce, so send the responses before it first */
+            if (transport->state.gatt.batch)
+            {
+                batch_flush(transport);
+            }
+        }
+
         if (size_response >= GAIA_GATT_OFFS_PAYLOAD)
         {
             GAIA_TRANS_DEBUG(("gaiaTransportGattRes size_response >= GAIA_GATT_OFFS_PAYLOAD\n"));
@@ -628,6 +773,7 @@ DESCRIPTION
 */
 void gaiaTransportGattDropState(gaia_transport *transport)
 {
+    free(transport->state.gatt.batch);
     memset(&transport->state.gatt, 0, sizeof transport->state.gatt);
 }
 
@@ -647,6 +793,11 @@ bool gaiaTransportGattProcessSource(void)
     if(gaia->upgrade_large_data.in_progress)
         return FALSE;
 
+    /* Segments the RWCP server held back while waiting for a missing one go
+       before anything still in the source */
+    if(gaia->data_endpoint_mode == GAIA_DATA_ENDPOINT_MODE_RWCP && RwcpServerProcessBufferedSegment())
+        return FALSE;
+
     packetSize = SourceBoundary(gatt_source);
     GAIA_TRANS_DEBUG(("gaiaTransportGattProcessSource: packetSize %d\n",packetSize));
     if(packetSize)
@@ -43,6 +43,14 @@ void gaiaTransportGattSendPacket(Task task, gaia_transport *transport, uint16 le
  */
 void gaiaTransportGattRes(gaia_transport *transport, uint16 size_response, uint8 *response, uint8 handle);
 
+/*! @brief Start coalescing responses to a batch of commands.
+ */
+void gaiaTransportGattBatchStart(gaia_transport *transport);
+
+/*! @brief Send any coalesced responses and stop coalescing.
+ */
+void gaiaTransportGattBatchEnd(gaia_transport *transport);
+
 /*! @brief
  */
 bool gaiaTransportGattHandleMessage(Task task, MessageId id, Message message);
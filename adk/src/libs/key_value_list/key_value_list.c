@@ -5,6 +5,12 @@
 \file
 \brief      Source file for a data structure with a list of { key, value } elements.
 
+    The elements of a list are held in entries sorted by key, so lookups are
+    a binary search. A value of up to KEY_VALUE_SMALL_SIZE octets is held in
+    its entry, as it was in the nodes of the original linked list; a larger
+    value has a buffer of its own. The entries are stored in blocks of
+    KEY_VALUE_BLOCK_ENTRIES, found through a table, so the list grows one
+    small block at a time and never needs a large pmalloc slot.
 */
 
 #include <stdint.h>
@@ -17,147 +23,171 @@
 #include "key_value_list.h"
 
 
-#define KEY_VALUE_TYPE_MASK     (0x3)
-#define KEY_VALUE_TYPE_SMALL    (0x1)
-#define KEY_VALUE_TYPE_LARGE    (0x2)
+#define KEY_VALUE_MAX_SIZE      ((1 << 12) - 1)
 
-#define KEY_VALUE_SMALL_SIZE    (sizeof(((key_value_pair_t *)0)->value.u32))
+/* Values up to this size are held in the entry itself */
+#define KEY_VALUE_SMALL_SIZE    (sizeof(((key_value_entry_t *)0)->value.u32))
 
-#define KEY_VALUE_MAX_SIZE      ((1 << 12) - 1)
+/* Number of entries in a block, a power of 2. Four entries of 8 octets fill
+   a 32 octet pmalloc pool. */
+#define KEY_VALUE_BLOCK_ENTRIES_LOG2    (2)
+#define KEY_VALUE_BLOCK_ENTRIES         (1 << KEY_VALUE_BLOCK_ENTRIES_LOG2)
+
+/* Number of blocks needed for a number of entries */
+#define keyValueList_blocksFor(count) \
+    (((count) + KEY_VALUE_BLOCK_ENTRIES - 1) >> KEY_VALUE_BLOCK_ENTRIES_LOG2)
 
 
-typedef struct key_value_pair_tag
+typedef struct
 {
     uint16 key;
-    uint16 size:12;
-    uint16 flags:4;
+    uint16 size;
     union
     {
         void *ptr;
         uint32 u32;
     } value;
-    struct key_value_pair_tag *next;
-} key_value_pair_t;
+} key_value_entry_t;
 
 struct key_value_list_tag
 {
-    key_value_pair_t *head;
+    /*! Table of blocks of entries, which together are sorted by key. NULL if
+        the list is empty */
+    key_value_entry_t **blocks;
+
+    /*! Number of entries */
+    uint16 count;
 };
 
 /*****************************************************************************/
 
-static key_value_pair_t *keyValueList_getKeyValuePair(key_value_list_t list, key_value_key_t key);
-
-static bool keyValueList_keyValueIsType(key_value_pair_t *key_value, uint16 type)
+static key_value_entry_t *keyValueList_entry(key_value_list_t list, uint16 index)
 {
-    return (type == (key_value->flags & KEY_VALUE_TYPE_MASK));
+    return &list->blocks[index >> KEY_VALUE_BLOCK_ENTRIES_LOG2][index & (KEY_VALUE_BLOCK_ENTRIES - 1)];
 }
 
-static void *getKeyValue(key_value_pair_t *key_value)
+/* Returns TRUE if the key was found, and the index of its entry or the index
+   it would be inserted at if not */
+static bool keyValueList_findEntry(key_value_list_t list, key_value_key_t key, uint16 *index)
 {
-    void * value = NULL;
+    uint16 low = 0;
+    uint16 high = list->count;
 
-    if (keyValueList_keyValueIsType(key_value, KEY_VALUE_TYPE_LARGE))
+    while (low < high)
     {
-        value = key_value->value.ptr;
-    }
-    else
-    {
-        value = (void *)&key_value->value.u32;
+        uint16 mid = (uint16)((low + high) / 2);
+        key_value_key_t mid_key = keyValueList_entry(list, mid)->key;
+
+        if (mid_key == key)
+        {
+            *index = mid;
+            return TRUE;
+        }
+        else if (mid_key < key)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
     }
 
-    return value;
+    *index = low;
+    return FALSE;
 }
 
-static size_t keyValueList_getKeySize(key_value_pair_t *key_value)
+static bool keyValueList_isSmall(const key_value_entry_t *entry)
 {
-    return key_value->size;
+    return entry->size <= KEY_VALUE_SMALL_SIZE;
 }
 
-static key_value_pair_t *keyValueList_addKeyValuePairAtListHead(key_value_list_t list)
+static void *keyValueList_getValue(key_value_entry_t *entry)
 {
-    key_value_pair_t *new_kvp = (key_value_pair_t *)PanicUnlessMalloc(sizeof(key_value_pair_t));
-    new_kvp->next = list->head;
-    list->head = new_kvp;
-    return new_kvp;
+    return keyValueList_isSmall(entry) ? (void *)&entry->value.u32 : entry->value.ptr;
 }
 
-static bool keyValueList_addKeyValuePair(key_value_list_t list, key_value_key_t key, const void * value, size_t size)
+/* Fill in the value of an entry that is not yet in the array. The value is
+   copied straight away, as it may be the value of a key that is about to
+   move or be freed. */
+static void keyValueList_setValue(key_value_entry_t *entry, const void *value, size_t size)
 {
-    key_value_pair_t *key_value = 0;
-    bool success = FALSE;
-
-    key_value = keyValueList_addKeyValuePairAtListHead(list);
-    key_value->key = key;
-    if (size <= KEY_VALUE_SMALL_SIZE)
+    entry->size = (uint16)size;
+    if (keyValueList_isSmall(entry))
     {
-        key_value->flags = KEY_VALUE_TYPE_SMALL;
-        memmove(&key_value->value.u32, value, size);
-        key_value->size = size;
-        success = TRUE;
-    }
-    else if (size <= KEY_VALUE_MAX_SIZE)
-    {
-        key_value->flags = KEY_VALUE_TYPE_LARGE;
-        key_value->value.ptr = PanicUnlessMalloc(size);
-        memmove(key_value->value.ptr, value, size);
-        key_value->size = size;
-        success = TRUE;
+        entry->value.u32 = 0;
+        memcpy(&entry->value.u32, value, size);
     }
     else
     {
-        /* size is too large to store in the key_value_pair_t */
-        Panic();
+        entry->value.ptr = PanicUnlessMalloc(size);
+        memcpy(entry->value.ptr, value, size);
     }
+}
 
-    return success;
+static void keyValueList_freeValue(key_value_entry_t *entry)
+{
+    if (!keyValueList_isSmall(entry))
+    {
+        free(entry->value.ptr);
+    }
 }
 
-static void keyValueList_removeKeyValuePairFromList(key_value_list_t list, key_value_pair_t *key_value)
+/* Resize the table for a new number of entries, adding or freeing the last
+   block if need be */
+static void keyValueList_resizeBlocks(key_value_list_t list, uint16 count)
 {
-    key_value_pair_t *curr = list->head;
+    uint16 blocks = keyValueList_blocksFor(list->count);
+    uint16 new_blocks = keyValueList_blocksFor(count);
 
-    if (list->head == key_value)
+    if (new_blocks > blocks)
     {
-        list->head = list->head->next;
+        list->blocks = PanicNull(realloc(list->blocks, new_blocks * sizeof(key_value_entry_t *)));
+        list->blocks[blocks] = PanicUnlessMalloc(KEY_VALUE_BLOCK_ENTRIES * sizeof(key_value_entry_t));
     }
-    else
+    else if (new_blocks < blocks)
     {
-        while (curr->next != NULL)
+        free(list->blocks[new_blocks]);
+        if (new_blocks)
         {
-            if (curr->next == key_value)
-            {
-                curr->next = curr->next->next;
-                break;
-            }
-            else curr = curr->next;
+            list->blocks = PanicNull(realloc(list->blocks, new_blocks * sizeof(key_value_entry_t *)));
+        }
+        else
+        {
+            free(list->blocks);
+            list->blocks = NULL;
         }
     }
 }
 
-static void keyValueList_destroyKeyValuePair(key_value_list_t list, key_value_pair_t *key_value)
+static void keyValueList_insertEntry(key_value_list_t list, uint16 index, key_value_key_t key, const void *value, size_t size)
 {
-    keyValueList_removeKeyValuePairFromList(list, key_value);
+    key_value_entry_t entry;
+    uint16 i;
+
+    entry.key = key;
+    keyValueList_setValue(&entry, value, size);
 
-    if (keyValueList_keyValueIsType(key_value, KEY_VALUE_TYPE_LARGE))
+    keyValueList_resizeBlocks(list, list->count + 1);
+    for (i = list->count; i > index; i--)
     {
-        free(key_value->value.ptr);
+        *keyValueList_entry(list, i) = *keyValueList_entry(list, i - 1);
     }
-
-    free(key_value);
+    *keyValueList_entry(list, index) = entry;
+    list->count++;
 }
 
-static key_value_pair_t *keyValueList_getKeyValuePair(key_value_list_t list, key_value_key_t key)
+static void keyValueList_removeEntry(key_value_list_t list, uint16 index)
 {
-    key_value_pair_t *curr = list->head;
-    while (curr != NULL)
+    uint16 i;
+
+    keyValueList_freeValue(keyValueList_entry(list, index));
+    for (i = index; i + 1 < list->count; i++)
     {
-        if (curr->key == key)
-            break;
-        else
-            curr = curr->next;
+        *keyValueList_entry(list, i) = *keyValueList_entry(list, i + 1);
     }
-    return curr;
+    keyValueList_resizeBlocks(list, list->count - 1);
+    list->count--;
 }
 
 /*****************************************************************************/
@@ -179,34 +209,81 @@ void KeyValueList_Destroy(key_value_list_t* list)
 bool KeyValueList_Add(key_value_list_t list, key_value_key_t key, const void *value, size_t size)
 {
     bool success = FALSE;
+    uint16 index;
 
     PanicNull(list);
 
-    if (KeyValueList_IsSet(list, key))
+    if (keyValueList_findEntry(list, key, &index))
     {
         success = FALSE;
     }
+    else if (size <= KEY_VALUE_MAX_SIZE)
+    {
+        keyValueList_insertEntry(list, index, key, value, size);
+        success = TRUE;
+    }
     else
     {
-        success = keyValueList_addKeyValuePair(list, key, value, size);
+        /* size is too large to store in the key_value_list_t */
+        Panic();
     }
 
     return success;
 }
 
+bool KeyValueList_Set(key_value_list_t list, key_value_key_t key, const void *value, size_t size)
+{
+    uint16 index;
+
+    PanicNull(list);
+
+    if (size > KEY_VALUE_MAX_SIZE)
+    {
+        /* size is too large to store in the key_value_list_t */
+        Panic();
+    }
+
+    if (keyValueList_findEntry(list, key, &index))
+    {
+        key_value_entry_t *entry = keyValueList_entry(list, index);
+
+        if (entry->size == size)
+        {
+            memmove(keyValueList_getValue(entry), value, size);
+        }
+        else
+        {
+            /* Copy the new value before freeing the old one, which it may be */
+            key_value_entry_t replacement;
+
+            replacement.key = key;
+            keyValueList_setValue(&replacement, value, size);
+            keyValueList_freeValue(entry);
+            *entry = replacement;
+        }
+    }
+    else
+    {
+        keyValueList_insertEntry(list, index, key, value, size);
+    }
+
+    return TRUE;
+}
+
 bool KeyValueList_Get(key_value_list_t list, key_value_key_t key, void **value, size_t *size)
 {
     bool found = FALSE;
-    key_value_pair_t * key_value = 0;
+    uint16 index;
 
     PanicNull(value);
     PanicNull(size);
 
-    key_value = keyValueList_getKeyValuePair(list, key);
-    if (key_value)
+    if (keyValueList_findEntry(list, key, &index))
     {
-        *value = getKeyValue(key_value);
-        *size = keyValueList_getKeySize(key_value);
+        key_value_entry_t *entry = keyValueList_entry(list, index);
+
+        *value = keyValueList_getValue(entry);
+        *size = entry->size;
         found = TRUE;
     }
 
@@ -215,29 +292,32 @@ bool KeyValueList_Get(key_value_list_t list, key_value_key_t key, void **value,
 
 void KeyValueList_Remove(key_value_list_t list, key_value_key_t key)
 {
-    key_value_pair_t * key_value = 0;
+    uint16 index;
 
-    key_value = keyValueList_getKeyValuePair(list, key);
-    if (key_value)
-        keyValueList_destroyKeyValuePair(list, key_value);
+    if (keyValueList_findEntry(list, key, &index))
+        keyValueList_removeEntry(list, index);
 }
 
 void KeyValueList_RemoveAll(key_value_list_t list)
 {
-    while (list->head != NULL)
+    uint16 i;
+
+    for (i = 0; i < list->count; i++)
     {
-        keyValueList_destroyKeyValuePair(list, list->head);
+        keyValueList_freeValue(keyValueList_entry(list, i));
     }
+    for (i = 0; i < keyValueList_blocksFor(list->count); i++)
+    {
+        free(list->blocks[i]);
+    }
+    free(list->blocks);
+    list->blocks = NULL;
+    list->count = 0;
 }
 
 bool KeyValueList_IsSet(key_value_list_t list, key_value_key_t key)
 {
-    bool is_set = FALSE;
-
-    if (keyValueList_getKeyValuePair(list, key))
-    {
-        is_set = TRUE;
-    }
+    uint16 index;
 
-    return is_set;
+    return keyValueList_findEntry(list, key, &index);
 }
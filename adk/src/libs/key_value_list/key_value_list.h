@@ -40,12 +40,9 @@ void KeyValueList_Destroy(key_value_list_t* list);
     This function will add the new key-value pair to the given list unless the
     key is already in the list or the list is full.
 
-    The data passed in via #value is copied to the list and if necessary a new
-    buffer will be allocated and owned by the list to store the copied data.
-    If the buffer cannot be allocated this function will panic.
-
-    Small values of 4 octets or less will not require a buffer to be allocated
-    by the list to store the copied data.
+    The data passed in via #value is copied into memory owned by the list.
+    If the buffer cannot be allocated this function will panic. #value may
+    point to the value of another key in the same list.
 
     \param list Key-value list to add to.
     \param key Key to insert.
@@ -56,6 +53,21 @@ void KeyValueList_Destroy(key_value_list_t* list);
 */
 bool KeyValueList_Add(key_value_list_t list, key_value_key_t key, const void *value, size_t size);
 
+/*! \brief Set the value of a key in a key-value list.
+
+    Adds the key-value pair if the key is not in the list, otherwise replaces
+    the value of the key. A value of the same size is overwritten in place, so
+    pointers to it returned by #KeyValueList_Get stay valid.
+
+    \param list Key-value list to set the value in.
+    \param key Key to set.
+    \param value Pointer to the data to associate with the key.
+    \param size Size in octets of the data pointed to by value.
+
+    \return bool TRUE, the function panics if the value cannot be stored.
+*/
+bool KeyValueList_Set(key_value_list_t list, key_value_key_t key, const void *value, size_t size);
+
 /*! \brief Remove a key-value pair from a key-value list.
 
     Any memory owned by the key-value pair will be freed when it is removed.
@@ -88,7 +100,9 @@ bool KeyValueList_IsSet(key_value_list_t list, key_value_key_t key);
 /*! \brief Get the value for a key in a key-value list.
 
     The value is returned as a pointer to the buffer owned by the key-value
-    pair and the size of the buffer.
+    pair and the size of the buffer. The pointer is valid until a key is added
+    to or removed from the list, or the value of this key changes size.
+    Changing the values of other keys does not move it.
 
     If the key does not exist the pointer to the buffer and the pointer to
     the size will not be modified.
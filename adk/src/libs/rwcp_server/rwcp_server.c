@@ -16,6 +16,22 @@ DESCRIPTION
 #include "rwcp_server.h"
 #include <gaia.h>
 
+#define RWCP_SEQUENCE_NUMBER_MAX                        64
+#define RWCP_RECEIVE_WINDOW_MAX                         32
+
+/* Most segments held in the reorder buffer at once */
+#ifndef RWCP_REORDER_BUFFER_SEGMENTS_MAX
+#define RWCP_REORDER_BUFFER_SEGMENTS_MAX                8
+#endif
+
+/* Segment held in the reorder buffer */
+typedef struct
+{
+    uint8 *command;          /* copy of the GAIA command carried by the segment, NULL if the slot is empty */
+    uint16 size;          /* size of the command */
+    uint8 sequence;          /* sequence number of the segment */
+} rwcp_segment_t;
+
 /* Service data type */
 typedef struct
 {
@@ -25,6 +41,8 @@ typedef struct
     uint8 rwcp_upgrade_header_size;          /*cumulative header size of GAIA and Upgrade headers */
     bool accept_segments;          /* flow control flag */
     Task client_task;          /*Client task*/
+    uint8 buffered_segments;          /* number of segments in the reorder buffer */
+    rwcp_segment_t reorder_buffer[RWCP_RECEIVE_WINDOW_MAX];          /* segments received early, not acknowledged until GAIA has taken them, indexed by sequence number */
 } SERVER_DATA_T;
 
 /*
@@ -51,6 +69,7 @@ typedef enum
     RWCP_DATA_PKT_IN_SEQUENCE,
     RWCP_DATA_PKT_DUPLICATE,
     RWCP_DATA_PKT_OUT_OF_SEQUENCE,
+    RWCP_DATA_PKT_BUFFERED,
     RWCP_DATA_PKT_DISCARDED
 } rwcp_data_pkts_t;
 
@@ -59,8 +78,6 @@ typedef enum
 #define RWCP_HEADER_OFFSET                              0
 /*#define RWCP_HEADER_SIZE                                1*/
 #define RWCP_PAYLOAD_OFFSET                             1
-#define RWCP_SEQUENCE_NUMBER_MAX                        64
-#define RWCP_RECEIVE_WINDOW_MAX                         32
 #define RWCP_SEQUENCE_NUMBER_INVALID                0xFF
 
 #if defined(DEBUG_RWCP_SERVER)
@@ -249,6 +266,110 @@ static bool isOutOfSequence(uint8 sequence)
 }
 
 
+/*----------------------------------------------------------------------------*
+ *  NAME
+ *      isBuffered
+ *
+ *  DESCRIPTION
+ *      Check if a segment is held in the reorder buffer
+ *
+ *  RETURNS
+ *      TRUE if the segment with the sequence number is held
+ *
+ *---------------------------------------------------------------------------*/
+static bool isBuffered(uint8 sequence)
+{
+    rwcp_segment_t *segment = &g_server_data.reorder_buffer[sequence % RWCP_RECEIVE_WINDOW_MAX];
+
+    return ( segment->command != NULL && segment->sequence == sequence );
+}
+
+
+/*----------------------------------------------------------------------------*
+ *  NAME
+ *      bufferSegment
+ *
+ *  DESCRIPTION
+ *      Hold a copy of a segment in the reorder buffer until every segment
+ *      before it has been passed to GAIA. A segment that is already held is
+ *      not copied again.
+ *
+ *  RETURNS
+ *      TRUE if the segment is in the reorder buffer, FALSE if there is no
+ *      room for it.
+ *
+ *---------------------------------------------------------------------------*/
+static bool bufferSegment(uint8 sequence, uint8 *data, uint16 size)
+{
+    rwcp_segment_t *segment = &g_server_data.reorder_buffer[sequence % RWCP_RECEIVE_WINDOW_MAX];
+    uint16 norm;
+
+    /* the buffer only has a slot for each segment up to a window after
+       the last one acknowledged */
+    norm = ( sequence -
+            g_server_data.last_sequence_number +
+            RWCP_SEQUENCE_NUMBER_MAX) %
+            RWCP_SEQUENCE_NUMBER_MAX;
+
+    if ( norm == 0 || norm > RWCP_RECEIVE_WINDOW_MAX )
+    {
+        return FALSE;
+    }
+
+    if ( segment->command )
+    {
+        RWCP_SERVER_DEBUG(( "h:%d\n", sequence ));
+        return TRUE;
+    }
+
+    if ( size <= RWCP_HEADER_SIZE ||
+         g_server_data.buffered_segments >= RWCP_REORDER_BUFFER_SEGMENTS_MAX )
+    {
+        return FALSE;
+    }
+
+    /* the client resends a segment that could not be held, so don't panic */
+    segment->command = malloc(size - RWCP_HEADER_SIZE);
+    if ( segment->command == NULL )
+    {
+        return FALSE;
+    }
+
+    memcpy(segment->command, &data[RWCP_PAYLOAD_OFFSET], size - RWCP_HEADER_SIZE);
+    segment->size = size - RWCP_HEADER_SIZE;
+    segment->sequence = sequence;
+    g_server_data.buffered_segments++;
+
+    RWCP_SERVER_DEBUG(( "b:%d\n", sequence ));
+    return TRUE;
+}
+
+
+/*----------------------------------------------------------------------------*
+ *  NAME
+ *      releaseBufferedSegments
+ *
+ *  DESCRIPTION
+ *      Free every segment in the reorder buffer.
+ *
+ *  RETURNS
+ *      None.
+ *
+ *---------------------------------------------------------------------------*/
+static void releaseBufferedSegments(void)
+{
+    uint16 i;
+
+    for (i = 0; i < RWCP_RECEIVE_WINDOW_MAX; i++)
+    {
+        free(g_server_data.reorder_buffer[i].command);
+        g_server_data.reorder_buffer[i].command = NULL;
+    }
+
+    g_server_data.buffered_segments = 0;
+}
+
+
 /*----------------------------------------------------------------------------*
  *  NAME
  *      handleDataSegment
@@ -264,14 +385,23 @@ static rwcp_data_pkts_t handleDataSegment(uint8 sequence_number, uint8 *data, ui
 {
     /*
      * payload received, check the sequence number
-     * Send an ACK if, the sequence number is as expected.
-     * Send a GAP if, the sequence number is unexpected.
+     * Send an ACK if, the sequence number is as expected, unless it is a
+     * resend of a segment held in the reorder buffer. That is acknowledged
+     * once GAIA has taken it.
+     * Send a GAP if, the sequence number is unexpected, and hold the
+     * segment in the reorder buffer if there is room.
      * ACK duplicates.
      */
     rwcp_data_pkts_t data_pkt_type = RWCP_DATA_PKT_DISCARDED;
     if ( g_server_data.accept_segments )
     {
-        if ( isNextSequence(sequence_number) )
+        if ( isNextSequence(sequence_number) && isBuffered(sequence_number) )
+        {
+            /* the copy in the reorder buffer is passed to GAIA instead */
+            data_pkt_type = RWCP_DATA_PKT_BUFFERED;
+            RWCP_SERVER_DEBUG(( "h:%d\n", sequence_number ));
+        }
+        else if ( isNextSequence(sequence_number) )
         {
             data_pkt_type = RWCP_DATA_PKT_IN_SEQUENCE;
             g_server_data.out_of_sequence_status = FALSE;
@@ -282,7 +412,8 @@ static rwcp_data_pkts_t handleDataSegment(uint8 sequence_number, uint8 *data, ui
         }
         else if ( isOutOfSequence(sequence_number) )
         {
-            data_pkt_type = RWCP_DATA_PKT_OUT_OF_SEQUENCE;
+            data_pkt_type = bufferSegment(sequence_number, data, size) ?
+                                RWCP_DATA_PKT_BUFFERED : RWCP_DATA_PKT_OUT_OF_SEQUENCE;
             if ( !g_server_data.out_of_sequence_status )
             {
                 g_server_data.out_of_sequence_status = TRUE;
@@ -311,6 +442,45 @@ static rwcp_data_pkts_t handleDataSegment(uint8 sequence_number, uint8 *data, ui
     return data_pkt_type;
 }
 
+bool RwcpServerProcessBufferedSegment(void)
+{
+    uint8 next = nextExpectedSequenceNumber(g_server_data.last_sequence_number);
+    rwcp_segment_t *segment = &g_server_data.reorder_buffer[next % RWCP_RECEIVE_WINDOW_MAX];
+
+    if ( !isBuffered(next) )
+    {
+        return FALSE;
+    }
+
+    RWCP_SERVER_DEBUG(( "d:%d\n", next ));
+
+    /* GAIA reads the command in place, so it stays in the buffer until
+       the upgrade library has taken all of it */
+    if ( GaiaRwcpProcessBufferedCommand(segment->command, segment->size) )
+    {
+        RwcpServerBufferedSegmentTaken();
+    }
+    return TRUE;
+}
+
+void RwcpServerBufferedSegmentTaken(void)
+{
+    uint8 next = nextExpectedSequenceNumber(g_server_data.last_sequence_number);
+    rwcp_segment_t *segment = &g_server_data.reorder_buffer[next % RWCP_RECEIVE_WINDOW_MAX];
+
+    if ( !isBuffered(next) )
+    {
+        return;
+    }
+
+    free(segment->command);
+    segment->command = NULL;
+    g_server_data.buffered_segments--;
+
+    g_server_data.last_sequence_number = next;
+    rwcpDataAck( next);
+}
+
 rwcp_protocol_state RwcpGetProtocolState(void)
 {
     return g_server_data.protocol_state;
@@ -368,6 +538,7 @@ bool RwcpServerHandleMessage(uint8 *data, uint16 size)
                     RWCP_SERVER_DEBUG(( "SYN received, LISTEN => SYN_RCVD\n" ));
                     rwcpSynAck(sequence_number);
                     g_server_data.last_sequence_number = sequence_number;
+                    releaseBufferedSegments();
                     g_server_data.protocol_state = RWCP_SYN_RCVD;
                     break;
 
@@ -398,6 +569,7 @@ bool RwcpServerHandleMessage(uint8 *data, uint16 size)
                     RWCP_SERVER_DEBUG(( "SYN received, SYN_RCVD => SYN_RCVD\n" ));
                     rwcpSynAck(sequence_number);
                     g_server_data.last_sequence_number = sequence_number;
+                    releaseBufferedSegments();
                     break;
 
                 /* handle the ReSeT command */
@@ -435,6 +607,7 @@ bool RwcpServerHandleMessage(uint8 *data, uint16 size)
                 case RWCP_CLIENT_CMD_RST:
                     RWCP_SERVER_DEBUG(( "RST received, ESTABLISHED => LISTEN\n" ));
                     rwcpRstAck( sequence_number);
+                    releaseBufferedSegments();
                     g_server_data.protocol_state = RWCP_LISTEN;
                     break;
 
@@ -449,6 +622,7 @@ bool RwcpServerHandleMessage(uint8 *data, uint16 size)
                 default:
                     RWCP_SERVER_DEBUG(( "Unexpected, hdr = %x, ESTABLISHED => LISTEN\n", rwcp_header ));
                     rwcpRst( sequence_number);
+                    releaseBufferedSegments();
                     g_server_data.protocol_state = RWCP_LISTEN;
                     break;
             }
@@ -462,6 +636,7 @@ bool RwcpServerHandleMessage(uint8 *data, uint16 size)
 
     /* Return FALSE if data not sent to upgrade => We want to read further RWCP packets in the ATT Source streams */
     if(isRWwcpControlCmd(command) || data_packet_type == RWCP_DATA_PKT_OUT_OF_SEQUENCE
+                                  || data_packet_type == RWCP_DATA_PKT_BUFFERED
                                   || data_packet_type == RWCP_DATA_PKT_DUPLICATE)
     {
         status = FALSE;
@@ -488,5 +663,6 @@ void RwcpServerInit( uint8 header_size)
     g_server_data.accept_segments = TRUE;
     g_server_data.client_task = NULL;
     g_server_data.last_sequence_number = 0;
+    releaseBufferedSegments();
     g_server_data.rwcp_upgrade_header_size = header_size;
 }
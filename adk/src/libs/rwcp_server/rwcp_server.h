@@ -69,13 +69,34 @@ rwcp_protocol_state RwcpGetProtocolState(void);
 */
 void RwcpServerFlowControl(bool accept);
 
+  /*! 
+    @brief Pass the next segment held in the reorder buffer to GAIA
+
+    Segments that arrive before a missing one are held until it is received.
+    Call this before reading the next packet from the ATT source, and read
+    the source only if it returns FALSE. A held segment is not acknowledged
+    until GAIA has taken all of it.
+
+    @return TRUE if a segment was passed to GAIA, FALSE if none is waiting
+*/
+bool RwcpServerProcessBufferedSegment(void);
+
+  /*! 
+    @brief Acknowledge and free the held segment GAIA has finished with
+
+    Called when GAIA took a segment from RwcpServerProcessBufferedSegment()
+    over more than one upgrade data request.
+*/
+void RwcpServerBufferedSegmentTaken(void);
+
   /*! 
     @brief Handle a RWCP server message
     
     @param data The payload of the RWCP message
     @param size The size of the payload
     
-    @return FALSE for Conrol and Data packets which are duplicate or Out of Sequence
+    @return FALSE for Conrol and Data packets which are duplicate, Out of Sequence
+            or held in the reorder buffer
             TRUE for Data packets which are in sequence 
 */
 bool RwcpServerHandleMessage(uint8 *data, uint16 size);
@@ -40,6 +40,16 @@
 /*! Set the list no destroy value */
 #define taskList_NoDestroySet(list, value) ((list)->base.no_destroy = (value))
 
+/*! Accessor for number of tasks allocated in the dynamic array */
+#define taskList_DynamicSize(list) ((list)->base.size_dynamic_tasks)
+
+/*! Set the number of tasks allocated in the dynamic array */
+#define taskList_DynamicSizeSet(list, size) ((list)->base.size_dynamic_tasks = (size))
+
+/*! Total number of tasks the list can hold without reallocating */
+#define taskList_Capacity(list) \
+    (taskList_FlexibleSize(list) + MAX(taskList_DynamicSize(list), 1))
+
 /*! Sizeof a flexible task list */
 #define taskList_FlexibleSizeof(flexible_tasks) (sizeof(task_list_flexible_t) + ((flexible_tasks) * sizeof(Task)))
 
@@ -59,20 +69,19 @@ static Task taskList_GetTaskAtIndex(task_list_t *list, uint16 index)
 {
     task_list_flexible_t *flex = STRUCT_FROM_MEMBER(task_list_flexible_t, base, list);
     uint16 flex_size = taskList_FlexibleSize(list);
-    uint16 list_size = taskList_Size(list);
     Task task;
 
     /* Tasks are placed in this order:
         1. In the flexible array (if it exists)
-        2. In the union's task
-        3. In the union's dynamically allocated array (2) is moved to first element in this array.
+        2. In the union's task, while no dynamic array is allocated
+        3. In the union's dynamically allocated array, which replaces (2).
     */
 
     if (index < flex_size)
     {
         task = flex->flexible_tasks[index];
     }
-    else if ((index == flex_size) && (list_size == (index + 1)))
+    else if (taskList_DynamicSize(list) == 0)
     {
         task = list->u.task;
     }
@@ -91,22 +100,54 @@ static Task taskList_GetTaskAtIndex(task_list_t *list, uint16 index)
 
     \return bool TRUE search_task found and index returned.
                  FALSE search_task not found, index not valid.
+
+    Tasks are unique on a list, so the search stops at the first match. The
+    flexible and dynamic arrays are scanned directly rather than through
+    taskList_GetTaskAtIndex.
  */
 static bool taskList_FindTaskIndex(task_list_t *list, Task search_task, uint16* index)
 {
-    bool task_index_found = FALSE;
-    uint16 iter = 0;
+    task_list_flexible_t *flex = STRUCT_FROM_MEMBER(task_list_flexible_t, base, list);
+    uint16 flex_size = taskList_FlexibleSize(list);
+    uint16 list_size = taskList_Size(list);
+    uint16 static_end = MIN(flex_size, list_size);
+    uint16 iter;
 
-    for (iter = 0; iter < taskList_Size(list); iter++)
+    for (iter = 0; iter < static_end; iter++)
     {
-        if (taskList_GetTaskAtIndex(list, iter) == search_task)
+        if (flex->flexible_tasks[iter] == search_task)
         {
             *index = iter;
-            task_index_found = TRUE;
+            return TRUE;
+        }
+    }
+
+    if (list_size > flex_size)
+    {
+        if (taskList_DynamicSize(list) == 0)
+        {
+            if (list->u.task == search_task)
+            {
+                *index = flex_size;
+                return TRUE;
+            }
+        }
+        else
+        {
+            Task *tasks = list->u.tasks;
+
+            for (iter = 0; iter < list_size - flex_size; iter++)
+            {
+                if (tasks[iter] == search_task)
+                {
+                    *index = flex_size + iter;
+                    return TRUE;
+                }
+            }
         }
     }
 
-    return task_index_found;
+    return FALSE;
 }
 
 /*! \brief Set the task at a given index.
@@ -119,13 +160,12 @@ static void taskList_SetTaskAtIndex(task_list_t *list, Task task, uint16 index)
 {
     task_list_flexible_t *flex = STRUCT_FROM_MEMBER(task_list_flexible_t, base, list);
     uint16 flex_size = taskList_FlexibleSize(list);
-    uint16 list_size = taskList_Size(list);
 
     if (index < flex_size)
     {
         flex->flexible_tasks[index] = task;
     }
-    else if ((index == flex_size) && (index == (list_size - 1)))
+    else if (taskList_DynamicSize(list) == 0)
     {
         list->u.task = task;
     }
@@ -153,81 +193,98 @@ static inline task_list_data_t *taskList_GetListData(task_list_t *list)
     return taskList_ToListWithData(list)->data;
 }
 
+/*! \brief Release the multicast recipient set of a list, if it has one.
+
+    \param list Pointer to a Tasklist.
+*/
+static void taskList_ReleaseRecipients(task_list_t *list)
+{
+    MessageMulticastSetRelease(list->recipients);
+    list->recipients = NULL;
+}
+
 /*! \brief Resize a list (optionally with data)
     \param list Pointer to the list to be resized.
     \param The new size of the list.
 
-    This function does not check current size of the list - always resizing to
-    the new_size requested.
+    Tasks beyond the flexible array are stored in u.task until a second one
+    is needed, and from then on in a dynamically allocated array. The array
+    doubles when it is full and halves when it is only a quarter full, so
+    adding and removing tasks rarely reallocates. All dynamically allocated
+    memory is released when the list becomes empty.
 
-    This function handles the list having a flexible array of tasks in addition
-    to a dynamically allocated list of tasks.
+    The data of a list with data is kept in an array with the same capacity
+    as the tasks.
 */
 static void taskList_Resize(task_list_t *list, uint16 new_size)
 {
-    /* Number of statically allocated tasks in the list (flexible array and task in union) */
     uint16 flex_size = taskList_FlexibleSize(list);
-    uint16 static_size = flex_size + 1;
-    uint16 old_size = taskList_Size(list);
+    uint16 dynamic_size = taskList_DynamicSize(list);
+    uint16 old_capacity = taskList_Capacity(list);
+    uint16 needed = (new_size > flex_size) ? (new_size - flex_size) : 0;
+
+    PanicFalse(new_size <= TASK_LIST_MAX_TASKS);
 
-    if (new_size == static_size)
+    /* The tasks are about to change, so the recipient set no longer matches */
+    taskList_ReleaseRecipients(list);
+
+    if (new_size == 0)
     {
-        if (old_size > static_size)
+        if (dynamic_size)
         {
-            Task move_task = list->u.tasks[0];
             free(list->u.tasks);
-            list->u.tasks = NULL;
-            list->u.task = move_task;
-        }
-        else if (old_size < static_size)
-        {
-            list->u.task = NULL;
+            taskList_DynamicSizeSet(list, 0);
         }
+        list->u.task = NULL;
     }
-    else if (new_size > static_size)
+    else if (needed > MAX(dynamic_size, 1))
     {
-        size_t alloc_size = sizeof(Task) * (new_size - flex_size);
+        uint16 new_dynamic_size = MAX(dynamic_size, 1);
+
+        while (new_dynamic_size < needed)
+        {
+            new_dynamic_size *= 2;
+        }
+        new_dynamic_size = MIN(new_dynamic_size, TASK_LIST_MAX_TASKS - flex_size);
 
-        if (old_size == static_size)
+        if (dynamic_size == 0)
         {
             Task move_task = list->u.task;
-            list->u.tasks = PanicNull(malloc(alloc_size));
+            list->u.tasks = PanicUnlessMalloc(sizeof(Task) * new_dynamic_size);
             list->u.tasks[0] = move_task;
         }
         else
         {
-           list->u.tasks = PanicNull(realloc(list->u.tasks, alloc_size));
+            list->u.tasks = PanicNull(realloc(list->u.tasks, sizeof(Task) * new_dynamic_size));
         }
+        taskList_DynamicSizeSet(list, new_dynamic_size);
     }
-    else
+    else if ((dynamic_size > 2) && (needed <= dynamic_size / 4))
     {
-        if (old_size > static_size)
-        {
-            free(list->u.tasks);
-            list->u.tasks = NULL;
-        }
-        else if (old_size == static_size)
-        {
-            list->u.task = NULL;
-        }
+        uint16 new_dynamic_size = dynamic_size / 2;
+
+        list->u.tasks = PanicNull(realloc(list->u.tasks, sizeof(Task) * new_dynamic_size));
+        taskList_DynamicSizeSet(list, new_dynamic_size);
+    }
+    else if ((needed == 0) && (dynamic_size == 0))
+    {
+        list->u.task = NULL;
     }
 
     if (taskList_Type(list) == TASKLIST_TYPE_WITH_DATA)
     {
         task_list_with_data_t *list_with_data = taskList_ToListWithData(list);
-        if (new_size)
+        task_list_data_t *list_data = list_with_data->data;
+
+        if (new_size == 0)
         {
-            task_list_data_t *list_data = list_with_data->data;
-            list_data = realloc(list_data, sizeof(*list_data) * new_size);
-            list_with_data->data = PanicNull(list_data);
+            free(list_data);
+            list_with_data->data = NULL;
         }
-        else
+        else if ((list_data == NULL) || (taskList_Capacity(list) != old_capacity))
         {
-            if (list_with_data->data)
-            {
-                free(list_with_data->data);
-                list_with_data->data = NULL;
-            }
+            list_data = realloc(list_data, sizeof(*list_data) * taskList_Capacity(list));
+            list_with_data->data = PanicNull(list_data);
         }
     }
 
@@ -306,18 +363,16 @@ static Task * taskList_CreateNullTerminatedTaskArray(task_list_t *list)
 
     if (number_of_tasks != 0)
     {
-        Task next_task = NULL;
         uint16 index;
 
         /* Account for null terminator */
-        number_of_tasks++;
-        task_list = (Task *) PanicUnlessMalloc(number_of_tasks*sizeof(Task));
+        task_list = (Task *) PanicUnlessMalloc((number_of_tasks + 1)*sizeof(Task));
 
-        while (iterateIndex(list, &next_task, &index))
+        for (index = 0; index < number_of_tasks; index++)
         {
-            task_list[index] = next_task;
+            task_list[index] = taskList_GetTaskAtIndex(list, index);
         }
-        task_list[++index] = NULL;
+        task_list[number_of_tasks] = NULL;
     }
 
     return task_list;
@@ -591,7 +646,7 @@ task_list_t *TaskList_Duplicate(task_list_t* list)
 
     if (taskList_Type(list) == TASKLIST_TYPE_STANDARD)
     {
-        new_list = TaskList_CreateWithCapacity(taskList_FlexibleSize(list));
+        new_list = TaskList_CreateWithCapacity(taskList_FlexibleSize(list) + 1);
     }
     else
     {
@@ -602,8 +657,6 @@ task_list_t *TaskList_Duplicate(task_list_t* list)
     {
         unsigned index;
 
-        new_list->base = list->base;
-        taskList_NoDestroySet(new_list, FALSE);
         taskList_Resize(new_list, taskList_Size(list));
 
         for (index = 0; index < taskList_Size(list); index++)
@@ -636,17 +689,24 @@ void TaskList_MessageSendLaterWithSize(task_list_t *list, MessageId id, void *da
 {
     PanicNull(list);
 
-    Task *task_list = taskList_CreateNullTerminatedTaskArray(list);
-    if (task_list)
+    if (taskList_Size(list))
     {
         if (size_data == 0)
         {
             PanicNotNull(data);
         }
 
-        MessageSendMulticastLater(task_list, id, data, delay);
+        /* Build the recipient set on the first send after the list changes
+           and share it between all the messages sent until the next change */
+        if (list->recipients == NULL)
+        {
+            Task *task_list = taskList_CreateNullTerminatedTaskArray(list);
+
+            list->recipients = MessageMulticastSetCreate(task_list);
+            free(task_list);
+        }
 
-        free(task_list);
+        MessageSendMulticastSetLater(list->recipients, id, data, delay);
     }
     else
     {
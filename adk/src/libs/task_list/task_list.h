@@ -136,6 +136,10 @@ typedef struct
      *  #TaskList_Initialise, it is not valid to call #TaskList_Destroy */
     unsigned no_destroy : 1;
 
+    /*! Number of tasks allocated in u.tasks, zero if u.task is in use.
+        Grows by doubling so that adding a task rarely reallocates. */
+    unsigned size_dynamic_tasks : TASK_LIST_SIZE_BITS;
+
 } task_list_base_t;
 
 /*! \brief List of VM Tasks.
@@ -157,6 +161,10 @@ typedef struct
         Task task;
     } u;
 
+    /*! Recipient set the tasks were last sent a message through, reused
+        until the list changes. NULL if there isn't one. */
+    MulticastSet recipients;
+
 } task_list_t;
 
 /*! \brief List of VM Tasks with a flexible array of tasks.
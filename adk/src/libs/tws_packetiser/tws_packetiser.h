@@ -101,8 +101,44 @@ typedef struct __tws_packetiser_master_config
     /* The last time before the TTP at which a packet may be transmitted */
     rtime_t tx_deadline;
 
+    /*! Adapt the number of audio frames sent in each packet to the time
+        before the TTP at which packets are transmitted */
+    bool adaptive_packet_size;
+
 } tws_packetiser_master_config_t;
 
+/*! The number of bins in the master's transmit slack histogram */
+#define TWS_PACKETISER_SLACK_HISTOGRAM_BINS (8)
+
+/*! The width of each bin in the master's transmit slack histogram */
+#define TWS_PACKETISER_SLACK_HISTOGRAM_BIN_US (10 * US_PER_MS)
+
+/*! Statistics collected by the TWS master packetiser */
+typedef struct __tws_packetiser_master_stats
+{
+    /*! The number of packets transmitted */
+    uint32 packets;
+
+    /*! The number of audio frames transmitted */
+    uint32 frames;
+
+    /*! The number of audio frames dropped because they were late */
+    uint32 frames_dropped;
+
+    /*! The most audio frames transmitted in one packet */
+    uint16 frames_per_packet_max;
+
+    /*! The number of octets of audio the master currently waits for before
+        transmitting a packet early */
+    uint16 target_audio_length;
+
+    /*! The number of packets transmitted with slack (the time before the TTP
+        less the tx_deadline) in each TWS_PACKETISER_SLACK_HISTOGRAM_BIN_US.
+        The last bin also counts all packets with more slack. */
+    uint32 slack_histogram[TWS_PACKETISER_SLACK_HISTOGRAM_BINS];
+
+} tws_packetiser_master_stats_t;
+
 /*! Structure defining the TWS slave packetiser configuration.
   All members must be set when initialising the library.
 */
@@ -196,6 +232,20 @@ tws_packetiser_master_t* TwsPacketiserMasterInit(tws_packetiser_master_config_t
 */ 
 uint32 TwsPacketiserMasterHeaderLength(tws_packetiser_master_t *tp, uint32 number_audio_frames);
 
+/*!
+  @brief Get the statistics collected by the TWS master packetiser.
+  @param tp The instance.
+  @param stats Set to the statistics collected since the instance was created
+  or the statistics were last reset.
+*/
+void TwsPacketiserMasterGetStatistics(tws_packetiser_master_t *tp, tws_packetiser_master_stats_t *stats);
+
+/*!
+  @brief Reset the statistics collected by the TWS master packetiser.
+  @param tp The instance.
+*/
+void TwsPacketiserMasterResetStatistics(tws_packetiser_master_t *tp);
+
 /*!
   @brief Destroy the TWS master packetiser instance.
   @param tp The instance to destroy.
@@ -11,12 +11,15 @@ FILE NAME
 #include <tws_packetiser_private.h>
 #include <packetiser_helper.h>
 #include <panic.h>
+#include <hydra_macros.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stream.h>
 
 #define TP_INTERNAL_MSG_BASE        (0)
-#define TP_INTERNAL_MSG_PERIOD_MS   (25)
+
+/* Weight of a new frame length in the average frame length, as a shift */
+#define TP_FRAME_LENGTH_AVERAGE_SHIFT   (3)
 
 typedef enum __tp_internal_msg
 {
@@ -68,6 +71,23 @@ struct __tws_packetiser_master
     /*! The previous value of this state */
     time_before_ttp_state_t time_before_ttp_state_prev;
 
+    /*! Set while a TP_INTERNAL_TX_PACKET_MSG is queued */
+    bool tx_timer_pending;
+
+    /*! The local-clock time at which the queued TP_INTERNAL_TX_PACKET_MSG is due */
+    rtime_t tx_timer_due;
+
+    /*! The number of octets of audio to wait for before transmitting early */
+    uint32 target_audio_length;
+
+    /*! Average length of the audio frames, scaled by TP_FRAME_LENGTH_AVERAGE_SHIFT */
+    uint32 frame_length_average;
+
+    /*! Set if a frame has been dropped since the last packet was transmitted */
+    bool frame_dropped;
+
+    /*! The statistics */
+    tws_packetiser_master_stats_t stats;
 
 };
 
@@ -110,12 +130,65 @@ static void tpDropAudioFrame(tws_packetiser_master_t *tp, audio_frame_metadata_t
 
     tp->packet.funcs->droppedAudioFrame(&tp->packet, frame_src, frame_len, fmd);
     SourceDrop(tp->config.source, frame_len);
+
+    tp->stats.frames_dropped++;
+    tp->frame_dropped = TRUE;
 }
 
-static bool tpSourceHasEnoughDataToFillPacket(tws_packetiser_master_t *tp)
+/* The most audio that fits in a packet */
+static uint32 tpMaxAudioLength(tws_packetiser_master_t *tp)
 {
     uint32 header_length = tp->packet.funcs->headerLength(&tp->packet, 1);
-    return SourceSize(tp->config.source) >= (tp->config.mtu - header_length);
+    return tp->config.mtu - header_length;
+}
+
+static bool tpSourceHasEnoughDataToFillPacket(tws_packetiser_master_t *tp)
+{
+    return SourceSize(tp->config.source) >= tp->target_audio_length;
+}
+
+/* Aggregate more frames per packet when they are being transmitted well
+   ahead of the deadline, to save air time, and fewer when they are close
+   to it or late, so that they are transmitted sooner */
+static void tpAdaptPacketSize(tws_packetiser_master_t *tp, int32 slack)
+{
+    int32 window = rtime_sub(tp->config.time_before_ttp_to_tx, tp->config.tx_deadline);
+    uint32 step = tp->frame_length_average >> TP_FRAME_LENGTH_AVERAGE_SHIFT;
+    uint32 max_length = tpMaxAudioLength(tp);
+
+    if (step == 0)
+    {
+        /* No frames have been transmitted yet */
+        return;
+    }
+
+    if (tp->frame_dropped || slack < window / 4)
+    {
+        tp->target_audio_length = (tp->target_audio_length > 2 * step) ?
+                                        tp->target_audio_length - step : step;
+    }
+    else if (slack > (window / 4) * 3)
+    {
+        tp->target_audio_length = MIN(tp->target_audio_length + step, max_length);
+    }
+}
+
+/* Update the statistics, and the packet size, after a packet is transmitted */
+static void tpPacketTransmitted(tws_packetiser_master_t *tp, uint16 frames)
+{
+    int32 slack = rtime_sub(tp->tx_time_before_ttp, tp->config.tx_deadline);
+    uint32 bin = (slack > 0) ? (uint32)slack / TWS_PACKETISER_SLACK_HISTOGRAM_BIN_US : 0;
+
+    tp->stats.packets++;
+    tp->stats.frames += frames;
+    tp->stats.frames_per_packet_max = MAX(tp->stats.frames_per_packet_max, frames);
+    tp->stats.slack_histogram[MIN(bin, TWS_PACKETISER_SLACK_HISTOGRAM_BINS - 1)]++;
+
+    if (tp->config.adaptive_packet_size)
+    {
+        tpAdaptPacketSize(tp, slack);
+    }
+    tp->frame_dropped = FALSE;
 }
 
 static time_before_ttp_state_t tpClassifyTimeBeforeTTP(tws_packetiser_master_t *tp, rtime_t ttp)
@@ -162,42 +235,70 @@ static process_header_action_t tpDecideAction(tws_packetiser_master_t *tp, rtime
     return action;
 }
 
+/* Cancel the deadline timer, if it is queued */
+static void tpCancelTxTimer(tws_packetiser_master_t *tp)
+{
+    if (tp->tx_timer_pending)
+    {
+        PanicFalse(MessageCancelAll(&tp->lib_task, TP_INTERNAL_TX_PACKET_MSG) <= 1);
+        tp->tx_timer_pending = FALSE;
+    }
+}
+
+/* Queue the deadline timer to fire time_before_ttp before the ttp. Packets are
+   otherwise sent from MESSAGE_MORE_DATA and MESSAGE_MORE_SPACE, so the timer
+   is left alone if it is already due at that time. */
+static void tpArmTxTimer(tws_packetiser_master_t *tp, rtime_t ttp, rtime_t time_before_ttp)
+{
+    rtime_t due = rtime_sub(ttp, time_before_ttp);
+    int32 delay_us = rtime_sub(tp->tx_time_before_ttp, time_before_ttp);
+    uint32 delay_ms = 0;
+
+    if (tp->tx_timer_pending && tp->tx_timer_due == due)
+    {
+        return;
+    }
+    tpCancelTxTimer(tp);
+
+    /* Round up, a timer that fires early would only find there is nothing to do yet */
+    if (delay_us > 0)
+    {
+        delay_ms = (uint32)((delay_us + US_PER_MS - 1) / US_PER_MS);
+    }
+    MessageSendLater(&tp->lib_task, TP_INTERNAL_TX_PACKET_MSG, NULL, delay_ms);
+    tp->tx_timer_pending = TRUE;
+    tp->tx_timer_due = due;
+}
+
 static bool tpProcessHeader(tws_packetiser_master_t *tp)
 {
     audio_frame_metadata_t fmd;
 
-    /* A message may already be queued for the frame at the head of the source -
-       this will happen if the time to transmit the frame is in the future, and
-       this function is re-called (e.g. because of a MESSAGE_MORE_DATA) before
-       the queued message is delivered. In all cases, just cancel any queued
-       message - it will be re-sent if necessary */
-    PanicFalse(MessageCancelAll(&tp->lib_task, TP_INTERNAL_TX_PACKET_MSG) <= 1);
-
     while (PacketiserHelperAudioFrameMetadataGetFromSource(tp->config.source, &fmd))
     {
         process_header_action_t action = tpDecideAction(tp, fmd.ttp);
-        uint32 delay_ms;
         switch (action)
         {
             case WAIT:
-                delay_ms = rtime_sub(tp->tx_time_before_ttp, tp->config.time_before_ttp_to_tx) / US_PER_MS;
-                TP_DEBUG3("TPMASTER: ProcessHeader wait %d %d delay_ms %d", tp->tx_time_before_ttp, SourceSize(tp->config.source), delay_ms);
-                MessageSendLater(&tp->lib_task, TP_INTERNAL_TX_PACKET_MSG, NULL, delay_ms);
+                /* MESSAGE_MORE_DATA will arrive if the packet fills before
+                   then, this message sends a part filled packet on time. */
+                TP_DEBUG2("TPMASTER: ProcessHeader wait %d %d", tp->tx_time_before_ttp, SourceSize(tp->config.source));
+                tpArmTxTimer(tp, fmd.ttp, tp->config.time_before_ttp_to_tx);
                 return FALSE;
             
             case WRITE_HEADER:
                 TP_DEBUG1("TPMASTER: ProcessHeader write header %d", tp->tx_time_before_ttp);
                 if (tpWriteHeader(tp, fmd.ttp))
                 {
+                    tpCancelTxTimer(tp);
                     return TRUE;
                 }
                 else
                 {
                     /* In case no further sink/source messages are received
                        (e.g. sink and source are full), this message will trigger 
-                       the packetiser to drop late frames from the audio source. */
-                    delay_ms = (tp->tx_time_before_ttp / US_PER_MS);
-                    MessageSendLater(&tp->lib_task, TP_INTERNAL_TX_PACKET_MSG, NULL, delay_ms);
+                       the packetiser to drop the frame as soon as it is late. */
+                    tpArmTxTimer(tp, fmd.ttp, tp->config.tx_deadline);
                     return FALSE;
                 }
 
@@ -208,12 +309,16 @@ static bool tpProcessHeader(tws_packetiser_master_t *tp)
             break;
         }
     }
+
+    /* Nothing to send, wait for MESSAGE_MORE_DATA */
+    tpCancelTxTimer(tp);
     return FALSE;
 }
 
-static void tpWriteFrames(tws_packetiser_master_t *tp)
+static uint16 tpWriteFrames(tws_packetiser_master_t *tp)
 {
     audio_frame_metadata_t fmd;
+    uint16 frames = 0;
 
     while (PacketiserHelperAudioFrameMetadataGetFromSource(tp->config.source, &fmd))
     {
@@ -224,6 +329,17 @@ static void tpWriteFrames(tws_packetiser_master_t *tp)
         {
             SourceDrop(tp->config.source, frame_len);
             TP_DEBUG2("TPMASTER:    Wrote Frame: %d %d", fmd.ttp, frame_len);
+
+            if (tp->frame_length_average)
+            {
+                tp->frame_length_average += frame_len -
+                        (tp->frame_length_average >> TP_FRAME_LENGTH_AVERAGE_SHIFT);
+            }
+            else
+            {
+                tp->frame_length_average = frame_len << TP_FRAME_LENGTH_AVERAGE_SHIFT;
+            }
+            frames++;
         }
         else
         {
@@ -231,6 +347,7 @@ static void tpWriteFrames(tws_packetiser_master_t *tp)
             break;
         }
     }
+    return frames;
 }
 
 static void tpTransmitPacket(tws_packetiser_master_t *tp)
@@ -249,14 +366,17 @@ static void messageHandler(Task task, MessageId id, Message message)
     UNUSED(message);
     switch (id)
     {
+        case TP_INTERNAL_TX_PACKET_MSG:
+            tp->tx_timer_pending = FALSE;
+            /* Fall through */
         case MESSAGE_MORE_DATA:
         case MESSAGE_MORE_SPACE:
-        case TP_INTERNAL_TX_PACKET_MSG:
         {
             while (tpProcessHeader(tp))
             {
-                tpWriteFrames(tp);
+                uint16 frames = tpWriteFrames(tp);
                 tpTransmitPacket(tp);
+                tpPacketTransmitted(tp, frames);
 
                 if(tp->first_packet)
                 {
@@ -298,6 +418,7 @@ tws_packetiser_master_t* TwsPacketiserMasterInit(tws_packetiser_master_config_t
 
                 tp->time_before_ttp_state_prev = TIME_BEFORE_TTP_EARLY;
                 tp->first_packet = TRUE;
+                tp->target_audio_length = tpMaxAudioLength(tp);
 
                 MessageStreamTaskFromSink(config->sink, &tp->lib_task);
                 MessageStreamTaskFromSource(config->source, &tp->lib_task);
@@ -309,6 +430,7 @@ tws_packetiser_master_t* TwsPacketiserMasterInit(tws_packetiser_master_config_t
                 SinkConfigure(config->sink, VM_SINK_MESSAGES, VM_MESSAGES_SOME);
                 
                 MessageSend(&tp->lib_task, TP_INTERNAL_TX_PACKET_MSG, NULL);
+                tp->tx_timer_pending = TRUE;
             }
             else
             {
@@ -325,6 +447,17 @@ uint32 TwsPacketiserMasterHeaderLength(tws_packetiser_master_t *tp, uint32 numbe
     return tp->packet.funcs->headerLength(&tp->packet, number_audio_frames);
 }
 
+void TwsPacketiserMasterGetStatistics(tws_packetiser_master_t *tp, tws_packetiser_master_stats_t *stats)
+{
+    tp->stats.target_audio_length = (uint16)tp->target_audio_length;
+    *stats = tp->stats;
+}
+
+void TwsPacketiserMasterResetStatistics(tws_packetiser_master_t *tp)
+{
+    memset(&tp->stats, 0, sizeof(tp->stats));
+}
+
 void TwsPacketiserMasterDestroy(tws_packetiser_master_t *tp)
 {
     uint32 i;
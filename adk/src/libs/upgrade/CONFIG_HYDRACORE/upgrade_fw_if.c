@@ -298,6 +298,8 @@ UpgradeHostErrorCode UpgradeFWIFPartitionClose(UpgradeFWIFPartitionHdl handle)
     UpgradeSavePSKeys();
     PRINT(("P&R: last_closed_partition is %d\n", UpgradeCtxGetPSKeys()->last_closed_partition));
 
+    UpgradeFWIFValidateStreamClosePartition();
+
     return UPGRADE_HOST_SUCCESS;
 }
 
@@ -48,6 +48,9 @@ uint8 UpgradePartitionDataGetSigningMode(void);
 /* The number of uint8s in a SHA-256 signature */
 #define SHA_256_HASH_LENGTH (256/8)
 
+/* The number of uint8s in the first word of a partition */
+#define FIRST_WORD_SIZE 4
+
 /*
  * The expected signing mode types:
  * "standard" for ADK6.1 with all partitions signed;
@@ -62,6 +65,22 @@ typedef enum
 /* A bit map of up to 32 partitions that are being processed in this DFU file. */
 static uint32 partitionMap;
 
+/*
+ * The hash of the partition data as it is written, in the order the sections
+ * are hashed from flash. It is only used while it covers every octet of the
+ * partitions received so far, and survives a resume of the transfer but not
+ * a reboot.
+ */
+static struct
+{
+    hash_context_t context;     /* NULL if there is no usable hash */
+    uint16 nextPartition;       /* Lowest partition that may be added next */
+    uint16 partition;           /* Partition being added, if open */
+    uint32 offset;              /* Octets of the open partition written */
+    bool open;                  /* TRUE if a partition is being added */
+    bool hashing;               /* TRUE if the open partition is signed */
+} stream;
+
 /******************************************************************************
 NAME
     UpgradeFWIFAudioDFUExists
@@ -194,6 +213,202 @@ bool UpgradeFWIFValidateUpdate(uint8 *buffer, uint16 partNum)
     return FALSE;
 }
 
+/***************************************************************************
+NAME
+    UpgradeFWIFValidateStreamInit
+
+DESCRIPTION
+    Start hashing the partition data of a new upgrade as it is written,
+    discarding any hash left over from an earlier upgrade.
+
+RETURNS
+*/
+void UpgradeFWIFValidateStreamInit(void)
+{
+    UpgradeFWIFValidateStreamDiscard();
+
+    stream.context = ImageUpgradeHashInitialise(SHA256_ALGORITHM);
+    stream.nextPartition = 0;
+    stream.open = FALSE;
+    PRINT(("UPG: UpgradeFWIFValidateStreamInit %p\n", stream.context));
+}
+
+/***************************************************************************
+NAME
+    UpgradeFWIFValidateStreamDiscard
+
+DESCRIPTION
+    Free the hash of the partition data as it was written, if there is one.
+    Validation will then read the partitions back from flash.
+
+RETURNS
+*/
+void UpgradeFWIFValidateStreamDiscard(void)
+{
+    if (stream.context)
+    {
+        PRINT(("UPG: UpgradeFWIFValidateStreamDiscard\n"));
+        ImageUpgradeHashFinalise(stream.context, NULL, SHA_256_HASH_LENGTH);
+        stream.context = NULL;
+    }
+}
+
+/***************************************************************************
+NAME
+    UpgradeFWIFValidateStreamSkipPartition
+
+DESCRIPTION
+    Called for a partition that was closed before the transfer was resumed.
+    The hash is only kept if that partition was added to it.
+
+PARAMS
+    partNum The partition number
+
+RETURNS
+*/
+void UpgradeFWIFValidateStreamSkipPartition(uint16 partNum)
+{
+    if (stream.open || partNum >= stream.nextPartition)
+    {
+        UpgradeFWIFValidateStreamDiscard();
+    }
+}
+
+/***************************************************************************
+NAME
+    UpgradeFWIFValidateStreamOpenPartition
+
+DESCRIPTION
+    Add a partition that has been opened for writing to the hash. The first
+    word is hashed now, as it is at the start of the section in flash even
+    though it is written when the partition is closed.
+
+    Sections are hashed in ascending order, so the hash is discarded if the
+    partition is out of order, or if some of its data was written without
+    being hashed, such as before a reboot.
+
+PARAMS
+    partNum The partition number
+    firstWord The first word of the partition data
+    offset Octets of the partition already written, after the first word
+
+RETURNS
+*/
+void UpgradeFWIFValidateStreamOpenPartition(uint16 partNum, const uint8 *firstWord, uint32 offset)
+{
+    if (!stream.context)
+    {
+        return;
+    }
+
+    if (stream.open)
+    {
+        /* Resuming a partition, which must carry on where the hash stopped */
+        if (partNum != stream.partition || offset != stream.offset)
+        {
+            UpgradeFWIFValidateStreamDiscard();
+        }
+        return;
+    }
+
+    if (partNum < stream.nextPartition || offset != 0)
+    {
+        UpgradeFWIFValidateStreamDiscard();
+        return;
+    }
+
+    stream.partition = partNum;
+    stream.offset = 0;
+    stream.open = TRUE;
+    stream.hashing = (UpgradePartitionDataGetSigningMode() == ALL_PARTITIONS_SIGNING_MODE)
+                            || (partNum == IMAGE_SECTION_APPS_P0_HEADER);
+
+    if (stream.hashing && !ImageUpgradeHashMsgUpdate(stream.context, firstWord, FIRST_WORD_SIZE))
+    {
+        UpgradeFWIFValidateStreamDiscard();
+    }
+}
+
+/***************************************************************************
+NAME
+    UpgradeFWIFValidateStreamUpdate
+
+DESCRIPTION
+    Add partition data that has been written to the open partition to the
+    hash.
+
+PARAMS
+    data Pointer to the data written
+    len Number of octets written
+
+RETURNS
+*/
+void UpgradeFWIFValidateStreamUpdate(const uint8 *data, uint16 len)
+{
+    if (!stream.context || !stream.open)
+    {
+        return;
+    }
+
+    if (stream.hashing && !ImageUpgradeHashMsgUpdate(stream.context, data, len))
+    {
+        UpgradeFWIFValidateStreamDiscard();
+        return;
+    }
+
+    stream.offset += len;
+}
+
+/***************************************************************************
+NAME
+    UpgradeFWIFValidateStreamClosePartition
+
+DESCRIPTION
+    Called when the open partition has been closed, once all of its data
+    has been written.
+
+RETURNS
+*/
+void UpgradeFWIFValidateStreamClosePartition(void)
+{
+    if (stream.open)
+    {
+        stream.open = FALSE;
+        stream.nextPartition = stream.partition + 1;
+    }
+}
+
+/***************************************************************************
+NAME
+    UpgradeFWIFValidateStreamFinish
+
+DESCRIPTION
+    Verify the hash of the partition data as it was written against the
+    given signature, without reading the partitions back from flash.
+    The hash is freed whatever the result.
+
+PARAMS
+    signature Pointer to the signature to compare against.
+
+RETURNS
+    bool TRUE if the signature matches, FALSE if it does not or there is
+    no hash covering all of the partition data.
+*/
+bool UpgradeFWIFValidateStreamFinish(uint8 *signature)
+{
+    hash_context_t context = stream.context;
+
+    if (!context || stream.open)
+    {
+        UpgradeFWIFValidateStreamDiscard();
+        return FALSE;
+    }
+
+    /* UpgradeFWIFValidateFinish() frees the context */
+    stream.context = NULL;
+    return UpgradeFWIFValidateFinish(context, signature);
+}
+
 /***************************************************************************
 NAME
     UpgradeFWIFValidateStart
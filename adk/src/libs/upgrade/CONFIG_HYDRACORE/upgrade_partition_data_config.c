@@ -232,9 +232,35 @@ UpgradeHostErrorCode UpgradeSaveHeaderInPSKeys(uint16 *data, uint16 len)
         }
     }while (len != 0);
 
+    /* The header can be relayed to the peer device as soon as it is stored */
+    UpgradePeerNotifyDataAvailable();
+
     return UPGRADE_HOST_SUCCESS;
 }
 
+/***************************************************************************
+NAME
+    UpgradePartitionDataGetStoredHeaderWords
+
+DESCRIPTION
+    Get how much of the DFU headers have been stored in PSKEYs so far.
+
+RETURNS
+    Number of words stored.
+*/
+uint16 UpgradePartitionDataGetStoredHeaderWords(void)
+{
+    UpgradePartitionDataCtx *ctx = UpgradeCtxGetPartitionData();
+
+    if(ctx == NULL || ctx->dfuHeaderPskey < DFU_HEADER_PSKEY_START)
+    {
+        return 0;
+    }
+
+    return (uint16)((ctx->dfuHeaderPskey - DFU_HEADER_PSKEY_START) *
+                    PSKEY_MAX_STORAGE_LENGTH + ctx->dfuHeaderPskeyOffset);
+}
+
 /****************************************************************************
 NAME
     UpgradePartitionDataInit  -  Initialise.
@@ -280,6 +306,10 @@ bool UpgradePartitionDataInit(bool *waitForEraseComplete)
         PRINT(("Partial update interrupted. Not erasing.\n"));
         return TRUE;
     }
+
+    /* The partitions are written from the start, so can be hashed as they are */
+    UpgradeFWIFValidateStreamInit();
+
     /* Ensure the other bank is erased before we start. */
     if (UPGRADE_PARTITIONS_ERASED == UpgradePartitionsEraseAllManaged())
     {
@@ -497,6 +527,7 @@ UpgradeHostErrorCode UpgradePartitionDataHandleDataHeaderState(uint8 *data, uint
     if (UpgradeCtxGetPSKeys()->last_closed_partition > partNum)
     {
         PRINT(("PART_DATA: already handled partNum %u; skipping\n", partNum));
+        UpgradeFWIFValidateStreamSkipPartition(partNum);
         ctx->nextOffset = ctx->partitionLength - FIRST_WORD_SIZE;
         UpgradePartitionDataRequestData(HEADER_FIRST_PART_SIZE);
         ctx->state = UPGRADE_PARTITION_DATA_STATE_GENERIC_1ST_PART;
@@ -516,6 +547,7 @@ UpgradeHostErrorCode UpgradePartitionDataHandleDataHeaderState(uint8 *data, uint
     }
 
     ctx->nextOffset = UpgradeFWIFPartitionGetOffset(ctx->partitionHdl);
+    UpgradeFWIFValidateStreamOpenPartition(partNum, &data[PARTITION_SECOND_HEADER_SIZE], ctx->nextOffset);
 
     PRINT(("PART_DATA: partition length is %ld and offset is: %ld\n", ctx->partitionLength, ctx->nextOffset));
 
@@ -535,6 +567,7 @@ UpgradeHostErrorCode UpgradePartitionDataHandleDataHeaderState(uint8 *data, uint
         }
 
         ctx->openNextPartition = TRUE;
+        UpgradePeerNotifyDataAvailable();
 
         ctx->nextOffset -= FIRST_WORD_SIZE;
         UpgradePartitionDataRequestData(HEADER_FIRST_PART_SIZE);
@@ -681,7 +714,7 @@ NAME
     UpgradePartitionDataHandleDataState  -  Partition data handling.
 
 DESCRIPTION
-    Writes data to a SQIF and sends it the MD5 validation.
+    Writes data to a SQIF and adds it to the hash used for validation.
 
 RETURNS
     Upgrade library error code.
@@ -697,6 +730,8 @@ UpgradeHostErrorCode UpgradePartitionDataHandleDataState(uint8 *data, uint16 len
         return UPGRADE_HOST_ERROR_PARTITION_WRITE_FAILED_DATA;
     }
 
+    UpgradeFWIFValidateStreamUpdate(data, len);
+
     if(reqComplete)
     {
         UpgradeHostErrorCode closeStatus;
@@ -711,6 +746,7 @@ UpgradeHostErrorCode UpgradePartitionDataHandleDataState(uint8 *data, uint16 len
         }
 
         ctx->openNextPartition = TRUE;
+        UpgradePeerNotifyDataAvailable();
     }
 
     return UPGRADE_HOST_SUCCESS;
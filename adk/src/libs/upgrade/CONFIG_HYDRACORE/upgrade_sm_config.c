@@ -131,6 +131,12 @@ bool UpgradeSMHandleValidated(MessageId id, Message message)
                         /* TODO: An error has occured, fail the DFU */
                     }
                 }
+                else
+                {
+                    /* The peer device DFU was started when the data transfer
+                     * started, it can now finish. */
+                    UpgradePeerPrimaryValidated();
+                }
             }
             /* Send UPGRADE_HOST_TRANSFER_COMPLETE_IND once standalone upgrade
              * is done.
@@ -221,6 +227,12 @@ bool UpgradeSMHandleValidated(MessageId id, Message message)
                     /* TODO: An error has occured, failed the DFU */
                     }
                 }
+                else
+                {
+                    /* The peer device DFU was started when the data transfer
+                     * started, it can now finish. */
+                    UpgradePeerPrimaryValidated();
+                }
             }
             /* Send UPGRADE_HOST_TRANSFER_COMPLETE_IND later once upgrade is
              * done during standalone DFU.
@@ -370,6 +382,10 @@ DESCRIPTION
 void UpgradeSMActionOnValidated(void)
 {
 #ifdef MESSAGE_IMAGE_UPGRADE_COPY_STATUS
+    /* Pause relaying the DFU file to the peer device during the copy */
+    if(UPGRADE_PEER_IS_SUPPORTED && UPGRADE_PEER_IS_STARTED)
+        UpgradeCtxSetPeerDFUStartStatus(UPGRADE_DELAY_PEER_DFU);
+
     PRINT(("ImageUpgradeCopy()\n"));
     ImageUpgradeCopy();
 #endif  /* MESSAGE_IMAGE_UPGRADE_COPY_STATUS */
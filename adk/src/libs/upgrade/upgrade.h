@@ -1305,7 +1305,10 @@ uint16 *UpgradeIsPriRebootDone(void);
 void UpgradeSetPriRebootDone(bool val);
 
 /*!
-    @brief Cancel the Peer DFU Start if image upgrade copy is not successful
+    @brief Cancel the Peer DFU Start if image upgrade copy is not successful,
+           or abort a peer DFU that is relaying the DFU file while it is
+           being received if this device fails to receive, validate or
+           copy it.
 
     Returns None
 */
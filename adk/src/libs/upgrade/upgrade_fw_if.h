@@ -229,6 +229,61 @@ UpgradeHostErrorCode UpgradeFWIFValidateStart(hash_context_t *vctx);
 */
 bool UpgradeFWIFValidateFinish(hash_context_t *vctx, uint8 *signature);
 
+/*!
+    @brief Start hashing the partition data of a new upgrade as it is
+           written, so that it need not be read back from flash to be
+           validated.
+*/
+void UpgradeFWIFValidateStreamInit(void);
+
+/*!
+    @brief Free the hash of the partition data as it was written.
+*/
+void UpgradeFWIFValidateStreamDiscard(void);
+
+/*!
+    @brief Check that a partition closed before the transfer was resumed
+           is in the hash of the partition data as it was written.
+
+    @param partNum The partition number.
+*/
+void UpgradeFWIFValidateStreamSkipPartition(uint16 partNum);
+
+/*!
+    @brief Add a partition opened for writing to the hash of the partition
+           data as it is written.
+
+    @param partNum The partition number.
+    @param firstWord The first word of the partition data.
+    @param offset Number of octets of the partition already written.
+*/
+void UpgradeFWIFValidateStreamOpenPartition(uint16 partNum, const uint8 *firstWord, uint32 offset);
+
+/*!
+    @brief Add data written to the open partition to the hash of the
+           partition data as it is written.
+
+    @param data Pointer to the data.
+    @param len Length of the data.
+*/
+void UpgradeFWIFValidateStreamUpdate(const uint8 *data, uint16 len);
+
+/*!
+    @brief Record that the open partition has been closed.
+*/
+void UpgradeFWIFValidateStreamClosePartition(void);
+
+/*!
+    @brief Verify the hash of the partition data as it was written against
+           the given signature.
+
+    @param signature Signature sequence.
+
+    @return TRUE if the signature matches, FALSE if it does not or the hash
+            does not cover all of the partition data.
+*/
+bool UpgradeFWIFValidateStreamFinish(uint8 *signature);
+
 /*!
     @brief Add the data from an existing partition to the validation context.
 
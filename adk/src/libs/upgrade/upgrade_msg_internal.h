@@ -35,7 +35,10 @@ typedef enum
     UPGRADE_INTERNAL_BATTERY_LOW,
 
     /*! send to itself after reboot to commit, it is used to handle no reconnection cases */
-    UPGRADE_INTERNAL_RECONNECTION_TIMEOUT
+    UPGRADE_INTERNAL_RECONNECTION_TIMEOUT,
+
+    /*! sent to the partition data writer to write the next queued block */
+    UPGRADE_INTERNAL_WRITE_PARTITION_DATA
 
 } UpgradeMsgInternal;
 
@@ -9,7 +9,9 @@ DESCRIPTION
     Upgrade file processing state machine.
     It is parsing and validating headers.
     All received data are passed to MD5 validation.
-    Partition data are written to SQIF.
+    Partition data are written to SQIF. Blocks of partition data are queued
+    and written by a separate task, so the next block is requested from the
+    host while the previous ones are still being written.
 
 NOTES
 
@@ -19,12 +21,14 @@ NOTES
 #include <stdlib.h>
 
 #include <byte_utils.h>
+#include <message.h>
 #include <panic.h>
 #include <print.h>
 
 #include "upgrade_partition_data.h"
 #include "upgrade_partition_data_priv.h"
 #include "upgrade_ctx.h"
+#include "upgrade_msg_internal.h"
 #include "upgrade_fw_if.h"
 #include "upgrade_psstore.h"
 #include "upgrade_partitions.h"
@@ -42,11 +46,218 @@ static UpgradeHostErrorCode ParseCompleteData(uint8 *data, uint16 len, bool reqC
 static UpgradeHostErrorCode HandleFooterState(uint8 *data, uint16 len, bool reqComplete);
 static void UpgradePartitionDataRequestDataRequestSingleBlock(uint32 size);
 static void UpgradePartitionDataRequestDataRequestMultipleBlocks(uint32 size);
+static void WriteQueueHandler(Task task, MessageId id, Message message);
+
+static TaskData writeQueueTask = { WriteQueueHandler };
+
+/****************************************************************************
+NAME
+    WriteQueuedBlock  -  Write the oldest queued block to the partition.
+
+DESCRIPTION
+    The block stays allocated so that it can be reused for a later block.
+
+RETURNS
+    Upgrade library error code.
+*/
+static UpgradeHostErrorCode WriteQueuedBlock(UpgradePartitionDataWriteQueue *queue)
+{
+    UpgradePartitionDataWriteBlock *block = queue->block[queue->head];
+
+    queue->head = (queue->head + 1) % UPGRADE_PARTITION_DATA_WRITE_QUEUE_DEPTH;
+    queue->count--;
+
+    return UpgradePartitionDataHandleDataState(block->data, block->len, FALSE);
+}
+
+/****************************************************************************
+NAME
+    WriteQueueHandler  -  Write queued blocks in the background.
+
+DESCRIPTION
+    Writes one block per message so that data from the host is handled
+    between writes. After a write fails the rest of the queue is dropped and
+    the error is reported when the next block is parsed.
+*/
+static void WriteQueueHandler(Task task, MessageId id, Message message)
+{
+    UpgradePartitionDataCtx *ctx = UpgradeCtxGetPartitionData();
+    UpgradePartitionDataWriteQueue *queue = ctx ? ctx->writeQueue : NULL;
+    UNUSED(task);
+    UNUSED(message);
+
+    if(id != UPGRADE_INTERNAL_WRITE_PARTITION_DATA || !queue || !queue->count)
+    {
+        return;
+    }
+
+    queue->error = WriteQueuedBlock(queue);
+    if(queue->error != UPGRADE_HOST_SUCCESS)
+    {
+        PRINT(("PART_DATA: queued write failed %d\n", queue->error));
+        queue->count = 0;
+    }
+
+    if(queue->count)
+    {
+        MessageSend(&writeQueueTask, UPGRADE_INTERNAL_WRITE_PARTITION_DATA, NULL);
+    }
+}
+
+/****************************************************************************
+NAME
+    CommitQueuedBlocks  -  Write every queued block now.
+
+DESCRIPTION
+    The queue is freed afterwards.
+
+RETURNS
+    Upgrade library error code, including that of an earlier queued write.
+*/
+static UpgradeHostErrorCode CommitQueuedBlocks(void)
+{
+    UpgradePartitionDataWriteQueue *queue = UpgradeCtxGetPartitionData()->writeQueue;
+    UpgradeHostErrorCode rc = UPGRADE_HOST_SUCCESS;
+
+    if(queue)
+    {
+        (void)MessageCancelAll(&writeQueueTask, UPGRADE_INTERNAL_WRITE_PARTITION_DATA);
+
+        rc = queue->error;
+        while(rc == UPGRADE_HOST_SUCCESS && queue->count)
+        {
+            rc = WriteQueuedBlock(queue);
+        }
+
+        UpgradePartitionDataDiscardWrites();
+    }
+
+    return rc;
+}
+
+/****************************************************************************
+NAME
+    GetFreeBlock  -  Get the next free block of the write queue.
+
+DESCRIPTION
+    The queue is allocated on first use, and each block the first time it
+    is needed.
+
+RETURNS
+    The block, or NULL if there was not enough memory.
+*/
+static UpgradePartitionDataWriteBlock *GetFreeBlock(UpgradePartitionDataCtx *ctx)
+{
+    UpgradePartitionDataWriteQueue *queue = ctx->writeQueue;
+    uint16 tail;
+
+    if(!queue)
+    {
+        queue = malloc(sizeof(*queue));
+        if(!queue)
+        {
+            return NULL;
+        }
+        memset(queue, 0, sizeof(*queue));
+        ctx->writeQueue = queue;
+    }
+
+    tail = (queue->head + queue->count) % UPGRADE_PARTITION_DATA_WRITE_QUEUE_DEPTH;
+    if(!queue->block[tail])
+    {
+        queue->block[tail] = malloc(sizeof(*queue->block[tail]));
+    }
+
+    return queue->block[tail];
+}
+
+/****************************************************************************
+NAME
+    QueueBlock  -  Queue a block of partition data to be written.
+
+DESCRIPTION
+    If the queue is full the oldest block is written first, which bounds the
+    number of blocks acknowledged to the host but not yet written. If there
+    is not enough memory to queue the block, the queued blocks and then this
+    one are written straight away.
+
+RETURNS
+    Upgrade library error code, including that of an earlier queued write.
+*/
+static UpgradeHostErrorCode QueueBlock(uint8 *data, uint16 len)
+{
+    UpgradePartitionDataCtx *ctx = UpgradeCtxGetPartitionData();
+    UpgradePartitionDataWriteQueue *queue = ctx->writeQueue;
+    UpgradePartitionDataWriteBlock *block;
+
+    if(queue)
+    {
+        if(queue->error != UPGRADE_HOST_SUCCESS)
+        {
+            return queue->error;
+        }
+
+        if(queue->count == UPGRADE_PARTITION_DATA_WRITE_QUEUE_DEPTH)
+        {
+            UpgradeHostErrorCode rc = WriteQueuedBlock(queue);
+            if(rc != UPGRADE_HOST_SUCCESS)
+            {
+                UpgradePartitionDataDiscardWrites();
+                return rc;
+            }
+        }
+    }
+
+    block = GetFreeBlock(ctx);
+    if(!block)
+    {
+        UpgradeHostErrorCode rc = CommitQueuedBlocks();
+
+        PRINT(("PART_DATA: no memory to queue block, writing it now\n"));
+        if(rc != UPGRADE_HOST_SUCCESS)
+        {
+            return rc;
+        }
+        return UpgradePartitionDataHandleDataState(data, len, FALSE);
+    }
+
+    queue = ctx->writeQueue;
+    memmove(block->data, data, len);
+    block->len = len;
+
+    if(queue->count++ == 0)
+    {
+        MessageSend(&writeQueueTask, UPGRADE_INTERNAL_WRITE_PARTITION_DATA, NULL);
+    }
+
+    return UPGRADE_HOST_SUCCESS;
+}
+
+void UpgradePartitionDataDiscardWrites(void)
+{
+    UpgradePartitionDataCtx *ctx = UpgradeCtxGetPartitionData();
+
+    (void)MessageCancelAll(&writeQueueTask, UPGRADE_INTERNAL_WRITE_PARTITION_DATA);
+
+    if(ctx && ctx->writeQueue)
+    {
+        uint16 i;
+
+        for(i = 0; i < UPGRADE_PARTITION_DATA_WRITE_QUEUE_DEPTH; i++)
+        {
+            free(ctx->writeQueue->block[i]);
+        }
+        free(ctx->writeQueue);
+        ctx->writeQueue = NULL;
+    }
+}
 
 void UpgradePartitionDataDestroy(void)
 {
     UpgradePartitionDataCtx *ctx = UpgradeCtxGetPartitionData();
 
+    UpgradePartitionDataDiscardWrites();
+
     if(ctx)
     {
         if(ctx->signature)
@@ -443,6 +654,24 @@ UpgradeHostErrorCode ParseCompleteData(uint8 *data, uint16 len, bool reqComplete
         }
     }
 
+    /* Blocks in the middle of a partition are written in the background.
+     * Everything else waits for the queued blocks to be written, so the
+     * partition is only closed, and the resume point only moves on, once
+     * its data is in SQIF.
+     */
+    if(ctx->state == UPGRADE_PARTITION_DATA_STATE_DATA && !reqComplete)
+    {
+        PRINT(("PART_DATA: queue block len %d\n", len));
+        return QueueBlock(data, len);
+    }
+
+    rc = CommitQueuedBlocks();
+    if(rc != UPGRADE_HOST_SUCCESS)
+    {
+        return rc;
+    }
+    rc = UPGRADE_HOST_ERROR_INTERNAL_ERROR_1;
+
     switch(ctx->state)
     {
     case UPGRADE_PARTITION_DATA_STATE_GENERIC_1ST_PART:
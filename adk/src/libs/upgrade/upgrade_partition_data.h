@@ -53,6 +53,12 @@ typedef enum {
 */
 UpgradeHostErrorCode UpgradeSaveHeaderInPSKeys(uint16 *data, uint16 len);
 
+/*!
+    @brief Get how much of the DFU headers have been stored in PSKEYs.
+    @return Number of words stored.
+*/
+uint16 UpgradePartitionDataGetStoredHeaderWords(void);
+
 /*!
     @brief Initialisation of PartitionData module.
     @param waitForEraseComplete Set TURE if need to wait for UpgradeSMEraseStatus.
@@ -116,6 +122,14 @@ UpgradePartitionDataPartialTransferState UpgradePartitionDataParseDataCopy(uint8
 */
 void UpgradePartitionDataStopData(void);
 
+/*!
+    @brief Discard partition data blocks that are waiting to be written.
+
+    Blocks that were not written are not included in the partition offset,
+    so they are requested again when the upgrade resumes.
+*/
+void UpgradePartitionDataDiscardWrites(void);
+
 
 /*!
     @brief UpgradePartitionDataIsDfuUpdate
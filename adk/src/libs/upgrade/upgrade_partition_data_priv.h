@@ -21,6 +21,15 @@ DESCRIPTION
 
 #define PREFETCH_UPGRADE_BLOCKS 3
 
+/* Number of partition data blocks that can be waiting to be written to the
+ * partition while the following blocks are requested from the host. The
+ * queue and each block are allocated separately, and only while a partition
+ * is being received, so that none of this is held in the context.
+ */
+#ifndef UPGRADE_PARTITION_DATA_WRITE_QUEUE_DEPTH
+#define UPGRADE_PARTITION_DATA_WRITE_QUEUE_DEPTH 3
+#endif
+
 typedef enum
 {
     UPGRADE_PARTITION_DATA_STATE_GENERIC_1ST_PART,
@@ -36,6 +45,18 @@ typedef struct {
     uint8 data[UPGRADE_MAX_PARTITION_DATA_BLOCK_SIZE];
 } UpgradePartitionDataIncompleteData;
 
+typedef struct {
+    uint16 len;
+    uint8 data[UPGRADE_MAX_PARTITION_DATA_BLOCK_SIZE];
+} UpgradePartitionDataWriteBlock;
+
+typedef struct {
+    uint16 head;
+    uint16 count;
+    UpgradeHostErrorCode error;
+    UpgradePartitionDataWriteBlock *block[UPGRADE_PARTITION_DATA_WRITE_QUEUE_DEPTH];
+} UpgradePartitionDataWriteQueue;
+
 typedef struct {
     uint32 nextReqSize;
     uint32 nextOffset;
@@ -48,6 +69,7 @@ typedef struct {
     uint8 *signature;
     uint16 signatureReceived;
     UpgradePartitionDataIncompleteData incompleteData;
+    UpgradePartitionDataWriteQueue *writeQueue;
     bool openNextPartition;
 
     /* PSKEY information to store the DFU headers */
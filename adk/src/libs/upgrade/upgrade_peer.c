@@ -212,6 +212,10 @@ static void UpgradePeerCtxDestroy(void)
     {
         if(upgradePeerInfo->SmCtx != NULL)
         {
+            MessageCancelAll((Task)&upgradePeerInfo->myTask,
+                             INTERNAL_DATA_AVAILABLE_MSG);
+            MessageCancelAll((Task)&upgradePeerInfo->myTask,
+                             INTERNAL_TRANSFER_COMPLETE_MSG);
             upgradePeerInfo->SmCtx->confirm_type = UPGRADE_TRANSFER_COMPLETE;
             upgradePeerInfo->SmCtx->peerState = UPGRADE_PEER_STATE_SYNC;
             upgradePeerInfo->SmCtx->mResumePoint = UPGRADE_PEER_RESUME_POINT_START;
@@ -428,22 +432,69 @@ static bool StartPeerData(uint32 dataLength, uint8 *packet, bool last_packet)
 }
 
 /**
- * This method is called when we received an UPGRADE_DATA_BYTES_REQ message.
- * We manage this packet and use it for the next step which is to upload the
- * file on the device using UPGRADE_DATA messages.
+ * Reads the requested amount of data from the DFU file stored on this device
+ * and sends it to the peer device. If this device hasn't received that data
+ * from the host yet, the request is held until UpgradePeerNotifyDataAvailable()
+ * is called, which is what paces the peer device.
  */
-static void ReceiveDataBytesREQ(UPGRADE_PEER_START_DATA_BYTES_REQ_T *data)
+static void SendDataBytes(uint32 data_bytes)
 {
     uint8* payload = NULL;
     uint16 pkt_len;
     bool last_packet = FALSE;
-    upgrade_peer_status_t error;
+    upgrade_peer_status_t error = UPGRADE_PEER_SUCCESS;
     /* For header and last packet information */
     uint8 dataPkt_hdr = UPGRADE_PEER_PACKET_HEADER +
                         UPGRADE_DATA_MIN_DATA_LENGTH;
     /* This will be updated as how much data device is sending */
     uint32 sentLength = 0;
 
+    /* Until this device has validated the DFU file it may still be
+     * receiving it, and partitions can't be read during an image copy. */
+    if (*UpgradeCtxGetPeerDFUStartStatus() != UPGRADE_START_PEER_DFU ||
+        (upgradePeerInfo->awaiting_primary_validation &&
+         !UpgradePeerPartitionIsDataAvailable(data_bytes)))
+    {
+        PRINT(("UpgradePeer: Hold DATA Bytes Req\n"));
+        upgradePeerInfo->SmCtx->isRequestPending = TRUE;
+        upgradePeerInfo->SmCtx->mPendingBytes = data_bytes;
+        return;
+    }
+
+    pkt_len = BYTES_TO_WORDS(data_bytes + dataPkt_hdr);
+
+    /* Allocate memory for data read from partition */
+    payload = PanicUnlessMalloc(pkt_len*sizeof(uint16));
+    error = UpgradePeerPartitionMoreData(&payload[dataPkt_hdr],
+                                         &last_packet, data_bytes,
+                                         &sentLength);
+
+    /* Store data pointer for future purpose */
+    upgradePeerInfo->SmCtx->file = payload;
+
+    /* data has been read from partition, now send to peer device */
+    if((error == UPGRADE_PEER_SUCCESS) &&
+        StartPeerData(sentLength, payload, last_packet) == FALSE)
+    {
+        error = UPGRADE_PEER_ERROR_PARTITION_OPEN_FAILED;
+    }
+
+    if(error != UPGRADE_PEER_SUCCESS)
+    {
+        upgradePeerInfo->SmCtx->upgrade_status = error;
+        UpgradePeerSendErrorMsg(upgradePeerInfo->SmCtx->upgrade_status);
+    }
+}
+
+/**
+ * This method is called when we received an UPGRADE_DATA_BYTES_REQ message.
+ * We manage this packet and use it for the next step which is to upload the
+ * file on the device using UPGRADE_DATA messages.
+ */
+static void ReceiveDataBytesREQ(UPGRADE_PEER_START_DATA_BYTES_REQ_T *data)
+{
+    upgrade_peer_status_t error;
+
     PRINT(("UpgradePeer: DATA Bytes Req\n"));
 
     /* Checking the data has the good length */
@@ -451,22 +502,12 @@ static void ReceiveDataBytesREQ(UPGRADE_PEER_START_DATA_BYTES_REQ_T *data)
     {
         UpgradePeerSetState(UPGRADE_PEER_STATE_DATA_TRANSFER);
 
-        pkt_len = BYTES_TO_WORDS(data->data_bytes + dataPkt_hdr);
-
-        /* Allocate memory for data read from partition */
-        payload = PanicUnlessMalloc(pkt_len*sizeof(uint16));
-        error = UpgradePeerPartitionMoreData(&payload[dataPkt_hdr],
-                                             &last_packet, data->data_bytes,
-                                             &sentLength);
-
-        /* Store data pointer for future purpose */
-        upgradePeerInfo->SmCtx->file = payload;
-
-        /* data has been read from partition, now send to peer device */
-        if((error == UPGRADE_PEER_SUCCESS) &&
-            StartPeerData(sentLength, payload, last_packet) == FALSE)
+        /* The peer device resumes from its own offset, which may be ahead
+         * of where this device has got to reading the DFU file. */
+        error = UpgradePeerPartitionSkipData(data->start_offset);
+        if (error == UPGRADE_PEER_SUCCESS)
         {
-            error = UPGRADE_PEER_ERROR_PARTITION_OPEN_FAILED;
+            SendDataBytes(data->data_bytes);
         }
     }
     else
@@ -529,8 +570,11 @@ static void ReceiveTransferCompleteIND(void)
 {
     DEBUG_LOG("UpgradePeer: Transfer Complete Ind\n");
     SetResumePoint(UPGRADE_PEER_RESUME_POINT_PRE_REBOOT);
-    /* Send TRANSFER_COMPLETE_IND to host to get confirmation */
-    AskForConfirmation(UPGRADE_TRANSFER_COMPLETE);
+    /* Send TRANSFER_COMPLETE_IND to host to get confirmation, once this
+     * device has validated its own copy of the DFU file. */
+    MessageSendConditionally((Task)&upgradePeerInfo->myTask,
+                             INTERNAL_TRANSFER_COMPLETE_MSG, NULL,
+                             &upgradePeerInfo->awaiting_primary_validation);
 }
 
 /**
@@ -816,6 +860,18 @@ static void HandleLocalMessage(Task task, MessageId id, Message message)
             HandlePeerAppMsg((uint8 *)message);
             break;
 
+        case INTERNAL_DATA_AVAILABLE_MSG:
+            if(upgradePeerInfo->SmCtx->isRequestPending)
+            {
+                upgradePeerInfo->SmCtx->isRequestPending = FALSE;
+                SendDataBytes(upgradePeerInfo->SmCtx->mPendingBytes);
+            }
+            break;
+
+        case INTERNAL_TRANSFER_COMPLETE_MSG:
+            AskForConfirmation(UPGRADE_TRANSFER_COMPLETE);
+            break;
+
         default:
             DEBUG_LOG("unhandled msg\n");
     }
@@ -1329,12 +1385,74 @@ bool UpgradePeerStartDfu(void)
     /* Peer DFU is going to start, so it's not aborted yet*/
     upgradePeerInfo->is_dfu_aborted = FALSE;
 
+    /* This device has validated the DFU file unless told otherwise */
+    upgradePeerInfo->awaiting_primary_validation = FALSE;
+
     /* Peer DFU will start, once the image upgrade copy is completed */
     MessageSendConditionally(upgradePeerInfo->appTask, UPGRADE_PEER_CONNECT_REQ, NULL, (uint16 *)UpgradeCtxGetPeerDFUStartStatus());
 
     return TRUE;
 }
 
+/****************************************************************************
+NAME
+    UpgradePeerStartCutThroughDfu
+
+DESCRIPTION
+    Start peer device DFU procedure as this device starts receiving the
+    DFU file from the host. Each part of the file is relayed to the peer
+    device once this device has stored it, rather than after it has been
+    validated, so the two transfers overlap.
+*/
+bool UpgradePeerStartCutThroughDfu(void)
+{
+    if(!UpgradePeerStartDfu())
+    {
+        return FALSE;
+    }
+
+    upgradePeerInfo->awaiting_primary_validation = TRUE;
+
+    return TRUE;
+}
+
+/****************************************************************************
+NAME
+    UpgradePeerPrimaryValidated
+
+DESCRIPTION
+    This device has validated the DFU file, so the peer device can complete
+    a cut-through transfer.
+*/
+void UpgradePeerPrimaryValidated(void)
+{
+    if(upgradePeerInfo != NULL)
+    {
+        upgradePeerInfo->awaiting_primary_validation = FALSE;
+        UpgradePeerNotifyDataAvailable();
+    }
+}
+
+/****************************************************************************
+NAME
+    UpgradePeerNotifyDataAvailable
+
+DESCRIPTION
+    More of the DFU file has been stored by this device, so retry a data
+    request from the peer device that was waiting for it.
+*/
+void UpgradePeerNotifyDataAvailable(void)
+{
+    if(upgradePeerInfo != NULL && upgradePeerInfo->SmCtx != NULL &&
+       upgradePeerInfo->SmCtx->isRequestPending)
+    {
+        MessageCancelAll((Task)&upgradePeerInfo->myTask,
+                         INTERNAL_DATA_AVAILABLE_MSG);
+        MessageSend((Task)&upgradePeerInfo->myTask,
+                    INTERNAL_DATA_AVAILABLE_MSG, NULL);
+    }
+}
+
 bool UpgradePeerSetDeviceRolePrimary(bool is_primary)
 {
     /* If upgradePeerInfo context is not yet created */
@@ -1371,6 +1489,26 @@ void UpgradePeerSetDFUMode(bool is_dfu_mode)
 void UpgradePeerCancelDFU(void)
 {
     MessageCancelAll(upgradePeerInfo->appTask, UPGRADE_PEER_CONNECT_REQ);
+
+    /* Drop a held DATA_BYTES_REQ and TRANSFER_COMPLETE_IND before clearing
+     * awaiting_primary_validation, which would release the latter */
+    MessageCancelAll((Task)&upgradePeerInfo->myTask,
+                     INTERNAL_DATA_AVAILABLE_MSG);
+    MessageCancelAll((Task)&upgradePeerInfo->myTask,
+                     INTERNAL_TRANSFER_COMPLETE_MSG);
+    upgradePeerInfo->awaiting_primary_validation = FALSE;
+
+    if(upgradePeerInfo->SmCtx != NULL)
+    {
+        upgradePeerInfo->SmCtx->isRequestPending = FALSE;
+
+        /* A cut-through transfer is already relaying a DFU file this
+         * device has failed to validate or copy, so abort it */
+        if(upgradePeerInfo->SmCtx->isUpgrading)
+        {
+            AbortPeerDfu();
+        }
+    }
 }
 
 void UpgradePeerResetStateInfo(void)
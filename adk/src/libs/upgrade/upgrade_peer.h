@@ -303,6 +303,30 @@ void UpgradePeerProcessHostMsg(upgrade_peer_msg_t msgid,
 */
 bool UpgradePeerStartDfu(void);
 
+/*!
+    @brief Start peer device upgrade procedure as the DFU file starts to
+           arrive from the host, relaying it as it is stored.
+
+    Returns TRUE if peer device upgrade procedure is started.
+*/
+bool UpgradePeerStartCutThroughDfu(void);
+
+/*!
+    @brief This device has validated the DFU file, so a peer device upgrade
+           that was started with UpgradePeerStartCutThroughDfu() can complete.
+
+    Returns None
+*/
+void UpgradePeerPrimaryValidated(void);
+
+/*!
+    @brief More of the DFU file has been stored by this device, so a peer
+           data request waiting for it can be served.
+
+    Returns None
+*/
+void UpgradePeerNotifyDataAvailable(void);
+
 /*!
     @brief Check is peer device upgrade is started.
         
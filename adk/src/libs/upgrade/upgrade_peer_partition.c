@@ -18,6 +18,7 @@ DESCRIPTION
 #include <imageupgrade.h>
 
 #include "upgrade_private.h"
+#include "upgrade_ctx.h"
 #include "upgrade_partition_data.h"
 #include "upgrade_peer_private.h"
 
@@ -270,6 +271,59 @@ static bool getNextUpgradePskeyData(uint8 *peer_data, uint32 req_len)
     return TRUE;
 }
 
+/******************************************************************************
+NAME
+    isPskeyDataAvailable
+
+DESCRIPTION
+    Checks if this device has received and stored the next part of the DFU
+    headers yet.
+
+RETURNS
+    TRUE if the next req_words of header data are in the PSKEYs.
+*/
+static bool isPskeyDataAvailable(uint32 req_words)
+{
+    uint32 read_words = (uint32)(peerPartitionCtx->pskey - DFU_HEADER_PSKEY_START) *
+                        PSKEY_MAX_STORAGE_LENGTH + peerPartitionCtx->read_offset;
+
+    return (read_words + req_words) <= UpgradePartitionDataGetStoredHeaderWords();
+}
+
+/******************************************************************************
+NAME
+    isNextPartitionClosed
+
+DESCRIPTION
+    Reads the partition number from the next partition data header without
+    consuming it, and checks if this device has finished writing that
+    partition.
+
+RETURNS
+    TRUE if the partition can be read.
+*/
+static bool isNextPartitionClosed(void)
+{
+    uint8 header[PARTITION_SECOND_HEADER_SIZE];
+    uint16 pskey = peerPartitionCtx->pskey;
+    uint16 read_offset = peerPartitionCtx->read_offset;
+    uint16 partNum;
+
+    if(!isPskeyDataAvailable(BYTES_TO_WORDS(PARTITION_SECOND_HEADER_SIZE)) ||
+       !getNextUpgradePskeyData(header, BYTES_TO_WORDS(PARTITION_SECOND_HEADER_SIZE)))
+    {
+        return FALSE;
+    }
+
+    peerPartitionCtx->pskey = pskey;
+    peerPartitionCtx->read_offset = read_offset;
+
+    partNum = ByteUtilsGet2BytesFromStream(&header[2]);
+
+    /* last_closed_partition == partition_num + 1 */
+    return (UpgradeCtxGetPSKeys()->last_closed_partition > partNum);
+}
+
 /******************************************************************************
 NAME
     UpgradePeerDfuHandleGeneric1stPartState  -  Parser for ID and
@@ -613,6 +667,81 @@ upgrade_peer_status_t UpgradePeerPartitionMoreData(uint8 *dataPtr,
     return ret;
 }
 
+/******************************************************************************
+NAME
+    UpgradePeerPartitionIsDataAvailable
+
+DESCRIPTION
+    Checks if the data for the next request from the peer has been received
+    by this device, so that it can be relayed while the host is still
+    sending the rest of the DFU file.
+*/
+bool UpgradePeerPartitionIsDataAvailable(uint32 mBytesReq)
+{
+    switch(peerPartitionCtx->peerPartitionState)
+    {
+    case UPGRADE_PEER_PARTITION_DATA_STATE_DATA_HEADER:
+        return isNextPartitionClosed();
+
+    case UPGRADE_PEER_PARTITION_DATA_STATE_DATA:
+        /* The partition was closed when its header was read */
+        return TRUE;
+
+    default:
+        return isPskeyDataAvailable(BYTES_TO_WORDS(mBytesReq));
+    }
+}
+
+/******************************************************************************
+NAME
+    UpgradePeerPartitionSkipData
+
+DESCRIPTION
+    Skips partition data the peer already has, when it resumes part way
+    through a partition or has already closed it. The offset is relative to
+    the current position in the partition.
+*/
+upgrade_peer_status_t UpgradePeerPartitionSkipData(uint32 mStartOffset)
+{
+    uint32 skip_len;
+
+    if(peerPartitionCtx->peerPartitionState !=
+                                    UPGRADE_PEER_PARTITION_DATA_STATE_DATA)
+    {
+        return UPGRADE_PEER_SUCCESS;
+    }
+
+    skip_len = MIN(mStartOffset, peerPartitionCtx->part_data_length);
+
+    DEBUG_LOG("UpgradePeerPartition: Skip %d of %d\n", skip_len,
+                                    peerPartitionCtx->part_data_length);
+
+    while(skip_len)
+    {
+        uint32 drop_len = MIN(SourceSize(peerPartitionCtx->partitionHdl),
+                              skip_len);
+
+        if(drop_len == 0)
+        {
+            SourceClose(peerPartitionCtx->partitionHdl);
+            return UPGRADE_PEER_ERROR_PARTITION_WRITE_FAILED_DATA;
+        }
+
+        SourceDrop(peerPartitionCtx->partitionHdl, drop_len);
+        peerPartitionCtx->part_data_length -= drop_len;
+        skip_len -= drop_len;
+    }
+
+    if(peerPartitionCtx->part_data_length == 0)
+    {
+        peerPartitionCtx->peerPartitionState =
+                            UPGRADE_PEER_PARTITION_DATA_STATE_GENERIC_1ST_PART;
+        SourceClose(peerPartitionCtx->partitionHdl);
+    }
+
+    return UPGRADE_PEER_SUCCESS;
+}
+
 /******************************************************************************
 NAME
     UpgradePeerParititonInit
@@ -225,7 +225,9 @@ typedef enum
 {
     INTERNAL_START_REQ_MSG,
     INTERNAL_VALIDATION_DONE_MSG,
-    INTERNAL_PEER_MSG
+    INTERNAL_PEER_MSG,
+    INTERNAL_DATA_AVAILABLE_MSG,
+    INTERNAL_TRANSFER_COMPLETE_MSG
 } upgrade_peer_internal_msg_t;
 
 /* Structure used internally to save information about the upgrade across
@@ -299,6 +301,15 @@ typedef struct
      * The offset to use to upload data on the device.
      */
     unsigned mStartOffset;
+    /**
+     * To know if a data request from the device is waiting for the data to
+     * be received from the host.
+     */
+    bool isRequestPending;
+    /**
+     * The amount of data requested by the waiting data request.
+     */
+    uint32 mPendingBytes;
 } UPGRADE_PEER_CTX_T;
 
 typedef struct
@@ -324,6 +335,11 @@ typedef struct
     bool is_dfu_aborted;
 
     bool is_dfu_abort_trigerred;
+
+    /* Set while the peer is being upgraded before this device has validated
+       its own copy of the DFU file, to hold back the peer's transfer
+       complete indication. */
+    uint16 awaiting_primary_validation;
 } UPGRADE_PEER_INFO_T;
 
 /*!
@@ -348,6 +364,23 @@ upgrade_peer_status_t UpgradePeerPartitionMoreData(uint8 *dataPtr,
                                                    uint32 mBytesReq,
                                                    uint32 *mBytesSent);
 
+/*!
+    @brief Check if the data for the next request from the peer has been
+           received by this device.
+    @param mBytesReq Amount of data requested by peer.
+
+    Returns TRUE if the request can be served now.
+*/
+bool UpgradePeerPartitionIsDataAvailable(uint32 mBytesReq);
+
+/*!
+    @brief Skip partition data that the peer already has.
+    @param mStartOffset Amount of partition data to skip.
+
+    Returns status of partition data (SUCCESS or FAILURE).
+*/
+upgrade_peer_status_t UpgradePeerPartitionSkipData(uint32 mStartOffset);
+
 /*!
     @brief Set Upgrade peer state on context.
     @param nextState State of Upgrade Peer.
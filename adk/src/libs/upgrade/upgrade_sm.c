@@ -524,6 +524,18 @@ bool HandleDataReady(MessageId id, Message message)
                  */
                 UpgradeCtxGet()->isImgUpgradeEraseDone = (uint16)WaitForEraseComplete;
                 UpgradeSendStartUpgradeDataInd();
+
+                /* Relay the DFU file to the peer device as it is received,
+                 * rather than once it has been validated. */
+                if(UPGRADE_PEER_IS_SUPPORTED && !UPGRADE_PEER_IS_STARTED)
+                {
+                    UpgradeCtxSetPeerDFUStartStatus(UPGRADE_START_PEER_DFU);
+                    if(UpgradePeerStartCutThroughDfu() == FALSE)
+                    {
+                        PRINT(("Peer DFU left until validation\n"));
+                    }
+                }
+
                 if (!WaitForEraseComplete)
                 {
                     uint16 req_size = UpgradePartitionDataGetNextReqSize();
@@ -658,6 +670,16 @@ bool HandleDataHashChecking(MessageId id, Message message)
     switch(id)
     {
     case UPGRADE_INTERNAL_CONTINUE:
+        /* The partition data was hashed as it was written, unless the
+           transfer was resumed after a reboot, so try that first and only
+           read the partitions back from flash if it doesn't match. */
+        if (UpgradeFWIFValidateStreamFinish(ctx->partitionData->signature))
+        {
+            hashCheckedOk = TRUE;
+            hashCheckDone = TRUE;
+            break;
+        }
+
         ctx->vctx = ImageUpgradeHashInitialise(SHA256_ALGORITHM);
 
         if (ctx->vctx == NULL)
@@ -1433,6 +1455,12 @@ void UpgradeSMMoveToState(UpgradeState nextState)
 void FatalError(UpgradeHostErrorCode ec)
 {
     DEBUG_LOG("FatalError, error_code:%d", ec);
+
+    /* Stop relaying the DFU file to the peer device, for example when this
+     * device fails to validate it before the cut-through transfer ends */
+    if(UPGRADE_PEER_IS_SUPPORTED && UPGRADE_PEER_IS_STARTED)
+        UpgradePeerCancelDFU();
+
     UpgradeCtxGet()->funcs->SendErrorInd((uint16)ec);
     UpgradeSMSetState(UPGRADE_STATE_ABORTING);
     UpgradeCtxGetPSKeys()->upgrade_in_progress_key = UPGRADE_RESUME_POINT_ERROR;
@@ -1468,11 +1496,13 @@ void UpgradeSMErase(void)
     UpgradePartitionDataCtx *ctx = UpgradeCtxGetPartitionData();
     if (ctx)
     {
+        UpgradePartitionDataDiscardWrites();
         if (ctx->partitionHdl)
         {
              UpgradeFWIFPartitionClose(ctx->partitionHdl);
         }
     }
+    UpgradeFWIFValidateStreamDiscard();
 
     /*
      * Store upgrade_in_progress_key since pskey is stored prior to assessment
@@ -1731,7 +1761,10 @@ void UpgradeSMCopyStatus(Message message)
         * upgarde copy is completed and successful
         */
         if(UPGRADE_PEER_IS_SUPPORTED && UPGRADE_PEER_IS_STARTED)
+        {
             UpgradeCtxSetPeerDFUStartStatus(UPGRADE_START_PEER_DFU);
+            UpgradePeerNotifyDataAvailable();
+        }
         /*
          * The SQIF has been copied successfully.
          */
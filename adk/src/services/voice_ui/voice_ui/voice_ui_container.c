@@ -84,7 +84,7 @@ void VoiceUi_SetSelectedAssistant(uint8 voice_ui_provider)
    if(device_instance_exists)
    {
        Device_SetPropertyU8(device, device_property_voice_assistant, voice_ui_provider);
-       DeviceDbSerialiser_Serialise();
+       DeviceDbSerialiser_SerialiseLater();
    }
     VoiceUiGaiaPlugin_NotifyAssistantChanged(voice_ui_provider);
 }
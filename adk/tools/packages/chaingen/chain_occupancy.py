@@ -0,0 +1,333 @@
+'''
+ Copyright (c) 2020 Qualcomm Technologies International, Ltd.
+    %%version
+
+ Topology and buffer occupancy checker for chain descriptions, used by
+ chaingen --occupancy. Operators are Python models of how each capability
+ moves data; no Kymera code is built or run. It shows whether data reaches
+ every output and how full each connection gets, but nothing about
+ processing time or latency on the target.
+'''
+
+from __future__ import print_function, division
+
+import sys
+import wave
+import array
+
+
+class ChainOccupancyException(Exception):
+    '''Exception class indicating a chain that cannot be checked on the host'''
+    pass
+
+
+class HostBuffer(object):
+    ''' A connection between two terminals '''
+    def __init__(self, name, size):
+        self.name = name
+        self.size = size
+        self.aux = False
+        self.samples = array.array('h')
+        self.max_level = 0
+        self.level_total = 0
+        self.level_count = 0
+
+    @property
+    def level(self):
+        ''' The number of samples that can be read '''
+        return len(self.samples)
+
+    def space(self):
+        ''' The number of samples that can be written '''
+        return self.size - self.level
+
+    def write(self, samples):
+        ''' Write samples '''
+        self.samples.extend(samples)
+        self.max_level = max(self.max_level, self.level)
+
+    def read(self, amount):
+        ''' Read amount samples '''
+        samples = self.samples[:amount]
+        del self.samples[:amount]
+        return samples
+
+    def sample_level(self):
+        ''' Accumulate the occupancy statistics '''
+        self.level_total += self.level
+        self.level_count += 1
+
+    def mean_level(self):
+        ''' Mean occupancy at the end of each period '''
+        return self.level_total / self.level_count if self.level_count else 0
+
+
+class HostOperator(object):
+    ''' Portable model of a capability's data flow.
+        The default behaviour is that of basic_passthrough: each sink
+        terminal is copied to the source terminal with the same number.
+        A source with no such sink is fed from the first sink, and a sink
+        with no such source is consumed and discarded. '''
+    block = 1
+    model = "basic_passthrough"
+
+    def __init__(self, name, cap_id):
+        self.name = name
+        self.cap_id = cap_id
+        self.sinks = {}
+        self.sources = {}
+        self.samples = 0
+
+    def available(self, terminals):
+        ''' The number of samples that can be consumed from and produced to all the given terminals '''
+        if not terminals[0]:
+            return 0
+        amount = min([self.sinks[t].level for t in terminals[0]] +
+                     [self.sources[t].space() for t in terminals[1]])
+        return amount - amount % self.block
+
+    def routes(self):
+        ''' List of (sink terminals, source terminals) processed together '''
+        if not self.sinks:
+            return []
+        first = min(self.sinks)
+        return [([t], [s for s in sorted(self.sources) if s == t or (s not in self.sinks and t == first)])
+                for t in sorted(self.sinks)]
+
+    def combine(self, inputs):
+        ''' Combine the samples read from each sink of a route '''
+        return inputs[0]
+
+    def process_data(self):
+        ''' Move as much data as possible. Returns TRUE if anything was moved '''
+        moved = 0
+        for route in self.routes():
+            amount = self.available(route)
+            if amount <= 0:
+                continue
+            samples = self.combine([self.sinks[t].read(amount) for t in route[0]])
+            for terminal in route[1]:
+                self.sources[terminal].write(samples)
+            moved += amount
+        self.samples += moved
+        return moved > 0
+
+
+class HostSplitter(HostOperator):
+    ''' splitter: sink 0 is copied to every source '''
+    model = "splitter"
+
+    def routes(self):
+        return [([0], sorted(self.sources))] if 0 in self.sinks else []
+
+
+class HostMixer(HostOperator):
+    ''' mixer (and volume control): the sinks with data are summed to every source '''
+    model = "mixer"
+
+    def routes(self):
+        return [([t for t in sorted(self.sinks) if self.sinks[t].level], sorted(self.sources))]
+
+    def combine(self, inputs):
+        mixed = array.array('h')
+        for samples in zip(*inputs):
+            mixed.append(max(-32768, min(32767, sum(samples))))
+        return mixed
+
+
+class HostSourceSync(HostOperator):
+    ''' source_sync: routes sinks to sources one output period at a time '''
+    model = "source_sync"
+
+    def __init__(self, name, cap_id, period):
+        super(HostSourceSync, self).__init__(name, cap_id)
+        self.block = period
+
+
+# Capabilities with a portable model. Anything else, including rate_adjust and
+# rtp_decode, is stood in for by a passthrough and labelled as such in the report.
+MODELS = {
+    'CAP_ID_BASIC_PASS': HostOperator,
+    'EB_CAP_ID_SWITCHED_PASSTHROUGH': HostOperator,
+    'CAP_ID_SPLITTER': HostSplitter,
+    'CAP_ID_MIXER': HostMixer,
+    'EB_CAP_ID_VOL_CTRL_VOL': HostMixer,
+    'CAP_ID_SOURCE_SYNC': HostSourceSync,
+}
+
+
+def is_aux_input(metadata):
+    ''' Whether a chain input is an auxiliary one, such as a prompt or tone '''
+    return 'AUX' in metadata['role'].upper() or 'AUX' in metadata['terminal'].upper()
+
+
+def _read_wav(filename):
+    ''' Read a 16-bit PCM WAV file. Returns (rate, channels, samples) '''
+    wav = wave.open(filename, 'rb')
+    if wav.getsampwidth() != 2:
+        raise ChainOccupancyException("Only 16-bit PCM WAV input is supported: {}".format(filename))
+    rate = wav.getframerate()
+    channels = wav.getnchannels()
+    pcm = array.array('h', wav.readframes(wav.getnframes()))
+    if sys.byteorder == 'big':
+        pcm.byteswap()
+    wav.close()
+    return rate, channels, pcm
+
+
+class ChainOccupancyChecker(object):  # pylint: disable=too-many-instance-attributes
+    ''' Checks the data flow through a chain on the host, a period at a time.
+        Each chain input is fed from a WAV file, or silence, and every chain
+        output is drained. Only topology and buffer occupancy are reported;
+        the models say nothing about processing time or latency on the target. '''
+    def __init__(self, generator, period_ms=1, buffer_size=None, outfile=None):
+        self.generator = generator
+        self.period_ms = period_ms
+        self.buffer_size = buffer_size
+        self.outfile = outfile
+        self.operators = {}
+        self.buffers = []
+        self.inputs = []
+        self.outputs = []
+        self.unmodelled = []
+
+    def _create_operators(self, period):
+        for op_item in self.generator.operators:
+            name = op_item.attrib['name']
+            cap_id = op_item.attrib['id']
+            model = MODELS.get(cap_id)
+            if model is None:
+                self.unmodelled.append(name)
+                model = HostOperator
+            if model is HostSourceSync:
+                self.operators[name] = model(name, cap_id, period)
+            else:
+                self.operators[name] = model(name, cap_id)
+
+    def _operator(self, metadata):
+        try:
+            return self.operators[metadata['operator']]
+        except KeyError:
+            raise ChainOccupancyException("Unknown operator '{operator}'".format(**metadata))
+
+    def _create_buffers(self, size):
+        for connection in self.generator.connections:
+            source = self.generator.metadata(connection, False)
+            sink = self.generator.metadata(connection)
+            buff = HostBuffer("{operator}.{terminal}".format(**source) + " -> " +
+                              "{operator}.{terminal}".format(**sink), size)
+            self._operator(source).sources[int(source['terminal_num'])] = buff
+            self._operator(sink).sinks[int(sink['terminal_num'])] = buff
+            self.buffers.append(buff)
+        for inpt in self.generator.inputs:
+            sink = self.generator.metadata(inpt)
+            buff = HostBuffer(sink['role'], size)
+            buff.aux = is_aux_input(sink)
+            self._operator(sink).sinks[int(sink['terminal_num'])] = buff
+            self.inputs.append(buff)
+        for outpt in self.generator.outputs:
+            source = self.generator.metadata(outpt, False)
+            buff = HostBuffer(source['role'], size)
+            self._operator(source).sources[int(source['terminal_num'])] = buff
+            self.outputs.append(buff)
+
+    def _input_signals(self, rate, channels, pcm, input_files):
+        ''' The samples to feed to each chain input.
+            An input named in input_files is fed from that file. Otherwise the
+            channels of the main WAV file feed the inputs in order, except that
+            auxiliary inputs are fed silence. '''
+        frames = len(pcm) // channels
+        unused = set(input_files)
+        signals = []
+        channel = 0
+        for buff in self.inputs:
+            if buff.name in input_files:
+                unused.discard(buff.name)
+                file_rate, file_channels, file_pcm = _read_wav(input_files[buff.name])
+                if file_rate != rate:
+                    raise ChainOccupancyException("{} is {} Hz, not {} Hz".format(input_files[buff.name],
+                                                                               file_rate, rate))
+                signal = file_pcm[::file_channels][:frames]
+                signal.extend([0] * (frames - len(signal)))
+            elif buff.aux:
+                signal = array.array('h', [0] * frames)
+            else:
+                signal = pcm[channel % channels::channels]
+                channel += 1
+            signals.append(signal)
+        if unused:
+            raise ChainOccupancyException("Chain has no input {}".format(", ".join(sorted(unused))))
+        return frames, signals
+
+    def _kick(self):
+        ''' Process operators until no more data moves, as kicks propagate on the target '''
+        progress = True
+        while progress:
+            progress = False
+            for operator in self.operators.values():
+                progress = operator.process_data() or progress
+
+    def check(self, wav_filename, output_filename=None, input_files=None):
+        ''' Run the whole WAV file through the chain.
+            input_files maps chain input roles to WAV files to feed them instead. '''
+        rate, channels, pcm = _read_wav(wav_filename)
+
+        period = max(1, rate * self.period_ms // 1000)
+        self._create_operators(period)
+        self._create_buffers(self.buffer_size or 4 * period)
+        if not self.inputs:
+            raise ChainOccupancyException("Chain has no inputs")
+        frames, signals = self._input_signals(rate, channels, pcm, input_files or {})
+
+        recorded = array.array('h')
+        fed = [0] * len(self.inputs)
+        now = 0
+        draining = True
+        while now < frames or draining:
+            for index, buff in enumerate(self.inputs):
+                amount = min(period, frames - fed[index], buff.space())
+                if amount > 0:
+                    buff.write(signals[index][fed[index]:fed[index] + amount])
+                    fed[index] += amount
+            self._kick()
+            now += period
+            draining = any(buff.level for buff in self.outputs)
+            for index, buff in enumerate(self.outputs):
+                samples = buff.read(buff.level)
+                if index == 0:
+                    recorded.extend(samples)
+            for buff in self.buffers + self.inputs:
+                buff.sample_level()
+
+        if output_filename:
+            out = wave.open(output_filename, 'wb')
+            out.setnchannels(1)
+            out.setsampwidth(2)
+            out.setframerate(rate)
+            if sys.byteorder == 'big':
+                recorded.byteswap()
+            out.writeframes(recorded.tobytes() if hasattr(recorded, 'tobytes') else recorded.tostring())
+            out.close()
+
+        self.report(rate, now)
+        return recorded
+
+    def report(self, rate, duration):
+        ''' Print the samples moved by each operator and the buffer occupancy '''
+        print("Chain {} ({} Hz, {} ms period, {:.1f} s of data)".format(self.generator.chain_name, rate,
+                                                                        self.period_ms, duration / rate),
+              file=self.outfile)
+        print("\n{:<40} {:<40} {:>12}".format("Operator", "Model", "samples"), file=self.outfile)
+        for name in sorted(self.operators):
+            operator = self.operators[name]
+            if name in self.unmodelled:
+                model = "passthrough stand-in for " + operator.cap_id
+            else:
+                model = operator.model
+            print("{:<40} {:<40} {:>12}".format(name, model, operator.samples), file=self.outfile)
+        print("\n{:<72} {:>6} {:>6} {:>6}".format("Buffer", "size", "max", "mean"), file=self.outfile)
+        for buff in self.inputs + self.buffers:
+            print("{:<72} {:>6} {:>6} {:>6.1f}".format(buff.name, buff.size, buff.max_level, buff.mean_level()),
+                  file=self.outfile)
+        if not any(operator.samples for operator in self.operators.values()):
+            print("\nNo data moved through the chain", file=self.outfile)
@@ -13,7 +13,7 @@ MEDIR = os.path.dirname(ME)
 sys.path.insert(0, MEDIR)
 
 # pylint: disable=wrong-import-position,relative-import
-from chaingen_mod import process_file
+from chaingen_mod import process_file, check_occupancy_file
 
 
 def main():
@@ -42,14 +42,54 @@ def main():
                         default=None,
                         help='Folder to generate source. Use location of source xml file if not specified')
 
+    parser.add_argument('--occupancy',
+                        type=str,
+                        default=None,
+                        metavar='WAV',
+                        help='Check the topology and buffer occupancy of the chain with Python models of '
+                             'its operators, feeding 16-bit PCM from WAV to its inputs (silence to auxiliary '
+                             'inputs). Does not run Kymera and reports no processing time or latency')
+
+    parser.add_argument('--occupancy_input',
+                        type=str,
+                        action='append',
+                        default=[],
+                        metavar='ROLE=WAV',
+                        help='Feed the chain input ROLE of --occupancy from WAV instead. May be repeated')
+
+    parser.add_argument('--occupancy_output',
+                        type=str,
+                        default=None,
+                        metavar='WAV',
+                        help='Write the first chain output of --occupancy to WAV')
+
+    parser.add_argument('--period_ms',
+                        type=int,
+                        default=1,
+                        help='Period at which --occupancy feeds and drains the chain. Default is 1ms')
+
+    parser.add_argument('--buffer_size',
+                        type=int,
+                        default=None,
+                        help='Size in samples of each buffer used by --occupancy. Default is four periods')
+
     args = parser.parse_args()
 
+    for item in args.occupancy_input:
+        if '=' not in item:
+            parser.error("--occupancy_input expects ROLE=WAV, not '{}'".format(item))
+
     files = glob.glob(args.filename)
     if not files:
         print('WARNING: Files argument does not match any files: {}'.format(args.filename), file=sys.stderr)
 
     for filename in files:
-        process_file(args.header, args.source, args.uml, args.write_to_file, filename, args.output_folder)
+        if args.occupancy:
+            input_files = dict(item.split('=', 1) for item in args.occupancy_input)
+            if not check_occupancy_file(filename, args.occupancy, args.occupancy_output, args.period_ms, args.buffer_size, input_files):
+                return False
+        else:
+            process_file(args.header, args.source, args.uml, args.write_to_file, filename, args.output_folder)
 
     return True
 
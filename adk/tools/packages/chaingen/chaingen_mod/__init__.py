@@ -21,8 +21,9 @@ sys.path.insert(0, PARENT)
 # pylint: disable=import-error,wrong-import-position
 from codegen.c_codegen import CommentBlockDoxygen, HeaderGuards, Enumeration, Array
 from plant_uml_chain_diagram import PlantUmlChainDiagram
+from chain_occupancy import ChainOccupancyChecker, ChainOccupancyException
 
-__all__ = ["process_file"]
+__all__ = ["process_file", "check_occupancy_file"]
 
 
 class ChainTerminalException(Exception):
@@ -390,3 +391,17 @@ def process_file(header, source, uml, write_to_file, filename, output_folder):
     # Generate the source file
     if uml:
         generate_uml(element_tree_root, write_to_file, filename, output_folder)
+
+
+def check_occupancy_file(filename, wav_filename, output_filename=None, period_ms=1, buffer_size=None, input_files=None):  # pylint: disable=too-many-arguments
+    element_tree_root = _get_element_tree(filename)
+    if element_tree_root is None:
+        return False
+
+    try:
+        checker = ChainOccupancyChecker(ChainGenerator(element_tree_root), period_ms, buffer_size)
+        checker.check(wav_filename, output_filename, input_files)
+    except (ChainTerminalException, ChainOccupancyException) as err:
+        print(err, file=sys.stderr)
+        return False
+    return True
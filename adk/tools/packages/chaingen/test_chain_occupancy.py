@@ -0,0 +1,141 @@
+'''
+ Copyright (c) 2020 Qualcomm Technologies International, Ltd.
+    %%version
+
+ Tests for the chaingen --occupancy checker. Run with
+    python -m unittest discover -s adk/tools/packages/chaingen
+'''
+
+from __future__ import print_function, division
+
+import os
+import sys
+import wave
+import array
+import shutil
+import tempfile
+import unittest
+import xml.etree.ElementTree as ET
+
+try:
+    from StringIO import StringIO
+except ImportError:
+    from io import StringIO
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+# pylint: disable=import-error,wrong-import-position
+from chaingen_mod import ChainGenerator
+from chain_occupancy import ChainOccupancyChecker, ChainOccupancyException
+
+RATE = 8000
+
+OUTPUT_VOLUME_CHAIN = '''
+<chain name="CHAIN_OUTPUT_VOLUME" id="0">
+    <operator name="OPR_LATENCY_BUFFER" id="CAP_ID_BASIC_PASS">
+        <sink name="IN" terminal="0"/>
+        <source name="OUT" terminal="0"/>
+    </operator>
+    <operator name="OPR_SOURCE_SYNC" id="CAP_ID_SOURCE_SYNC">
+        <sink name="IN" terminal="0"/>
+        <source name="OUT" terminal="0"/>
+    </operator>
+    <operator name="OPR_VOLUME_CONTROL" id="EB_CAP_ID_VOL_CTRL_VOL">
+        <sink name="MAIN_IN" terminal="0"/>
+        <sink name="AUX_IN" terminal="1"/>
+        <source name="OUT" terminal="0"/>
+    </operator>
+    <input sink="OPR_LATENCY_BUFFER.IN" role="EPR_SINK_MIXER_MAIN_IN"/>
+    <input sink="OPR_VOLUME_CONTROL.AUX_IN" role="EPR_VOLUME_AUX"/>
+    <connection source="OPR_LATENCY_BUFFER.OUT" sink="OPR_SOURCE_SYNC.IN"/>
+    <connection source="OPR_SOURCE_SYNC.OUT" sink="OPR_VOLUME_CONTROL.MAIN_IN"/>
+    <output source="OPR_VOLUME_CONTROL.OUT" role="EPR_SOURCE_MIXER_OUT"/>
+</chain>
+'''
+
+RATE_ADJUST_CHAIN = '''
+<chain name="CHAIN_RATE_ADJUST" id="0">
+    <operator name="OPR_RATE_ADJUST" id="CAP_ID_RATE_ADJUST">
+        <sink name="IN" terminal="0"/>
+        <source name="OUT" terminal="0"/>
+    </operator>
+    <operator name="OPR_SPLITTER" id="CAP_ID_SPLITTER">
+        <sink name="IN" terminal="0"/>
+        <source name="OUT_0" terminal="0"/>
+        <source name="OUT_1" terminal="1"/>
+    </operator>
+    <input sink="OPR_RATE_ADJUST.IN" role="EPR_RATE_ADJUST_IN"/>
+    <connection source="OPR_RATE_ADJUST.OUT" sink="OPR_SPLITTER.IN"/>
+    <output source="OPR_SPLITTER.OUT_0" role="EPR_SPLITTER_OUT_0"/>
+    <output source="OPR_SPLITTER.OUT_1" role="EPR_SPLITTER_OUT_1"/>
+</chain>
+'''
+
+
+class ChainOccupancyTest(unittest.TestCase):
+    ''' Check small chains '''
+    def setUp(self):
+        self.folder = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.folder)
+
+    def write_wav(self, name, samples):
+        filename = os.path.join(self.folder, name)
+        pcm = array.array('h', samples)
+        if sys.byteorder == 'big':
+            pcm.byteswap()
+        wav = wave.open(filename, 'wb')
+        wav.setnchannels(1)
+        wav.setsampwidth(2)
+        wav.setframerate(RATE)
+        wav.writeframes(pcm.tobytes() if hasattr(pcm, 'tobytes') else pcm.tostring())
+        wav.close()
+        return filename
+
+    @staticmethod
+    def checker(chain):
+        return ChainOccupancyChecker(ChainGenerator(ET.fromstring(chain)), outfile=StringIO())
+
+    def test_aux_input_is_silent(self):
+        ''' The main WAV is not also fed to the auxiliary input '''
+        signal = [(i % 200) - 100 for i in range(RATE // 2)]
+        checker = self.checker(OUTPUT_VOLUME_CHAIN)
+        recorded = checker.check(self.write_wav('main.wav', signal))
+        self.assertEqual(list(recorded), signal)
+
+    def test_aux_input_from_file(self):
+        ''' A file given for the auxiliary input is mixed with the main input '''
+        signal = [100] * (RATE // 2)
+        prompt = [10] * (RATE // 4)
+        checker = self.checker(OUTPUT_VOLUME_CHAIN)
+        recorded = checker.check(self.write_wav('main.wav', signal), None,
+                              {'EPR_VOLUME_AUX': self.write_wav('prompt.wav', prompt)})
+        self.assertEqual(len(recorded), len(signal))
+        self.assertEqual(sum(recorded), 100 * len(signal) + 10 * len(prompt))
+
+    def test_unknown_input_file(self):
+        checker = self.checker(OUTPUT_VOLUME_CHAIN)
+        with self.assertRaises(ChainOccupancyException):
+            checker.check(self.write_wav('main.wav', [0] * 80), None,
+                       {'EPR_NO_SUCH_INPUT': self.write_wav('prompt.wav', [0] * 80)})
+
+    def test_report_labels_passthrough_stand_ins(self):
+        checker = self.checker(RATE_ADJUST_CHAIN)
+        checker.check(self.write_wav('main.wav', [1] * 800))
+        report = checker.outfile.getvalue()
+        rate_adjust = [line for line in report.splitlines() if line.startswith('OPR_RATE_ADJUST')]
+        splitter = [line for line in report.splitlines() if line.startswith('OPR_SPLITTER')]
+        self.assertIn('passthrough stand-in for CAP_ID_RATE_ADJUST', rate_adjust[0])
+        self.assertNotIn('stand-in', splitter[0])
+
+    def test_report_makes_no_timing_claims(self):
+        checker = self.checker(OUTPUT_VOLUME_CHAIN)
+        checker.check(self.write_wav('main.wav', [1] * 800))
+        report = checker.outfile.getvalue()
+        for claim in ('us total', 'us/kick', 'End-to-end latency'):
+            self.assertNotIn(claim, report)
+
+
+if __name__ == '__main__':
+    unittest.main()
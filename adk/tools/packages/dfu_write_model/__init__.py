@@ -0,0 +1 @@
+""" dfu_write_model """
@@ -0,0 +1,89 @@
+'''
+Copyright (c) 2020 Qualcomm Technologies International, Ltd.
+    %%version
+
+Model how long the data of a DFU file takes to reach SQIF when each block
+of partition data is written before the next one is requested (synchronous)
+and when blocks are queued and written while the next ones are requested
+(see QueueBlock in upgrade_partition_data.c).
+
+    python dfu_write_model.py --size 1280000 --round_trip 0.015 0.030
+        --write 0.0005 0.002 --depth 3
+
+The model follows the rules the upgrade library uses:
+
+- one block is requested at a time and arrives a round trip later,
+- queued blocks are written one at a time, in order,
+- when the queue is full the oldest block is written before the next
+  block is requested,
+- the last block is only acknowledged once every block is written.
+
+The link and write times are inputs, not measurements. CPU time spent
+handling messages, multiple-block requests and flash erase are not
+modelled, so the figures are estimates to compare the two ways of writing,
+not on-device timings.
+'''
+
+from __future__ import print_function
+import argparse
+import sys
+
+
+def synchronous(blocks, round_trip, write):
+    ''' Each block is written before the next one is requested '''
+    return blocks * (round_trip + write)
+
+
+def queued(blocks, round_trip, write, depth):
+    ''' Blocks are written in the background, depth at most waiting '''
+    written = []
+    request = 0.0
+    for i in range(blocks):
+        arrival = request + round_trip
+        start = max(arrival, written[-1] if written else 0.0)
+        written.append(start + write)
+        request = arrival
+        if i >= depth - 1:
+            # The queue is full: the oldest waiting block goes first
+            request = max(request, written[i - depth + 1])
+    return max(written[-1], request)
+
+
+def parse_args(args):
+    parser = argparse.ArgumentParser(description='Model the time to write '
+                                     'the partition data of a DFU file')
+    parser.add_argument('--size', type=int, default=1280000,
+                        help='Bytes of partition data (default 1280000)')
+    parser.add_argument('--block', type=int, default=48,
+                        help='Bytes in each block (default 48, '
+                        'UPGRADE_MAX_PARTITION_DATA_BLOCK_SIZE)')
+    parser.add_argument('--round_trip', type=float, nargs='+',
+                        default=[0.015, 0.030],
+                        help='Seconds from requesting a block to having it')
+    parser.add_argument('--write', type=float, nargs='+',
+                        default=[0.0005, 0.002, 0.010],
+                        help='Seconds to write one block to SQIF')
+    parser.add_argument('--depth', type=int, default=3,
+                        help='Blocks the write queue holds (default 3, '
+                        'UPGRADE_PARTITION_DATA_WRITE_QUEUE_DEPTH)')
+    return parser.parse_args(args)
+
+
+def main(args):
+    args = parse_args(args)
+    blocks = (args.size + args.block - 1) // args.block
+
+    print('{:>10} {:>10} {:>12} {:>12} {:>6}'.format(
+        'trip ms', 'write ms', 'synchronous', 'queued', 'saved'))
+    for round_trip in args.round_trip:
+        for write in args.write:
+            before = synchronous(blocks, round_trip, write)
+            after = queued(blocks, round_trip, write, args.depth)
+            print('{:>10.1f} {:>10.1f} {:>11.0f}s {:>11.0f}s {:>5.1f}%'.format(
+                round_trip * 1000, write * 1000, before, after,
+                100 * (before - after) / before))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1 @@
+""" peer_dfu_model """
@@ -0,0 +1,113 @@
+'''
+Copyright (c) 2020 Qualcomm Technologies International, Ltd.
+    %%version
+
+Model how long a two-device (primary and peer) DFU takes, with the peer
+upgraded after the primary has validated and copied the DFU file
+(sequential) and with the file relayed to the peer while it is still being
+received from the host (cut-through, see UpgradePeerStartCutThroughDfu).
+
+    python peer_dfu_model.py --partitions 30000 200000 600000 400000 50000
+        --host_rate 8000 --peer_rate 8000
+
+The model follows the rules the upgrade library uses in cut-through mode:
+
+- the headers are relayed once they are stored on the primary,
+- each partition is relayed only once the primary has closed it,
+- relaying pauses while the primary copies the image after validating it,
+- the peer's transfer only completes once the primary has validated.
+
+It only accounts for link rates and the validation and copy times given.
+Flash erase, link contention between the two transfers and retransmissions
+are not modelled, so the figures are estimates to compare the two modes,
+not on-device timings.
+'''
+
+from __future__ import print_function
+import argparse
+import sys
+
+
+def transfer_end(start, size, rate, pause):
+    ''' When a transfer of size bytes at rate bytes/s, started at start,
+        ends if it is suspended during the (begin, end) pause interval. '''
+    end = start + size / float(rate)
+    if pause is not None and end > pause[0] and start < pause[1]:
+        end += pause[1] - max(start, pause[0])
+    return end
+
+
+def primary_timeline(args):
+    ''' Returns when the headers are stored, when each partition is closed
+        and when the primary has validated the file. '''
+    headers_stored = args.header / float(args.host_rate)
+    closed = []
+    now = headers_stored
+    for size in args.partitions:
+        now += size / float(args.host_rate)
+        closed.append(now)
+    return headers_stored, closed, now + args.primary_validation
+
+
+def sequential(args):
+    ''' The peer DFU starts once the primary has validated and copied '''
+    _, _, validated = primary_timeline(args)
+    relay_start = validated + args.copy
+    relay_end = transfer_end(relay_start, args.header + sum(args.partitions),
+                             args.peer_rate, None)
+    return relay_end + args.peer_validation
+
+
+def cut_through(args):
+    ''' The peer DFU is relayed as the primary stores each part '''
+    headers_stored, closed, validated = primary_timeline(args)
+    copy = (validated, validated + args.copy)
+    relay_end = transfer_end(headers_stored, args.header, args.peer_rate, copy)
+    for size, available in zip(args.partitions, closed):
+        relay_end = transfer_end(max(relay_end, available), size,
+                                 args.peer_rate, copy)
+    return max(relay_end + args.peer_validation, copy[1])
+
+
+def parse_args(args):
+    parser = argparse.ArgumentParser(description='Model the duration of a '
+                                     'two-device DFU')
+    parser.add_argument('--partitions', type=int, nargs='+',
+                        default=[30000, 200000, 600000, 400000, 50000],
+                        help='Size in bytes of each partition in the DFU file')
+    parser.add_argument('--header', type=int, default=1000,
+                        help='Size in bytes of the DFU headers (default 1000)')
+    parser.add_argument('--host_rate', type=float, nargs='+', default=[8000],
+                        help='Host to primary data rates to model, in bytes/s')
+    parser.add_argument('--peer_rate', type=float, nargs='+', default=[8000],
+                        help='Primary to peer data rates to model, in bytes/s')
+    parser.add_argument('--primary_validation', type=float, default=5,
+                        help='Seconds the primary takes to validate the file')
+    parser.add_argument('--peer_validation', type=float, default=5,
+                        help='Seconds the peer takes to validate the file')
+    parser.add_argument('--copy', type=float, default=10,
+                        help='Seconds the primary takes to copy the image')
+    return parser.parse_args(args)
+
+
+def main(args):
+    args = parse_args(args)
+    host_rates = args.host_rate
+    peer_rates = args.peer_rate
+
+    print('{:>10} {:>10} {:>12} {:>12} {:>6}'.format(
+        'host B/s', 'peer B/s', 'sequential', 'cut-through', 'saved'))
+    for host_rate in host_rates:
+        for peer_rate in peer_rates:
+            args.host_rate = host_rate
+            args.peer_rate = peer_rate
+            before = sequential(args)
+            after = cut_through(args)
+            print('{:>10.0f} {:>10.0f} {:>11.0f}s {:>11.0f}s {:>5.0f}%'.format(
+                host_rate, peer_rate, before, after,
+                100 * (before - after) / before))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1 @@
+""" pmalloc_pools """
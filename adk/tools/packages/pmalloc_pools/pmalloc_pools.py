@@ -0,0 +1,261 @@
+'''
+Copyright (c) 2020 Qualcomm Technologies International, Ltd.
+    %%version
+
+Size the application pmalloc pools from a binary allocation trace.
+
+The firmware records every pmalloc/pfree in a RAM ring buffer when it is
+built with PMALLOC_TRACE_BINARY (see pmalloc_debug.h). Dump the
+pmalloc_trace_log_count word followed by the pmalloc_trace_log array to a
+file, for example from a pydbg session, and replay it here together with the
+pool tables the firmware was built with:
+
+    python pmalloc_pools.py trace.bin
+        --base os/src/fw/src/core/pmalloc/pmalloc_config_P1.h
+        --app earbud/src/earbud_pmalloc_pools.c
+        --headroom 25
+
+The tool reports, for each run-time pool, the high-water mark of blocks in
+use, the peak demand from requests that ideally belong in that pool, the
+number of requests that fell back to a larger pool, the bytes lost to
+rounding up to the block size and the mean block lifetime. It then prints an
+app_pools table that, merged with the base pools, covers the peak demand of
+every pool plus the requested headroom. Pools the trace never asked for are
+left at their base size, so the trace should exercise every use case the
+product needs.
+
+Peaks are only exact when the trace covers the whole run. If the ring buffer
+wrapped, blocks allocated before the oldest record are not seen and the
+figures are lower bounds.
+'''
+
+from __future__ import print_function
+import argparse
+import re
+import struct
+import sys
+
+# Layout of pmalloc_trace_record: time, block, owner, size, pool, event
+RECORD_FORMAT = '<IHHHBB'
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+COUNT_FORMAT = '<I'
+COUNT_SIZE = struct.calcsize(COUNT_FORMAT)
+
+# pmalloc_trace_event
+EVENT_ALLOC = 0
+EVENT_FREE = 1
+EVENT_FAIL = 2
+
+TIME_MODULUS = 1 << 32
+
+POOL_ENTRY = re.compile(r'\{\s*(\d+)\s*,\s*(\d+)\s*\}')
+POOL_TABLE = re.compile(r'pmalloc_pool_config\s+\w+\s*\[\s*\]\s*=\s*\{(.*?)\};',
+                        re.DOTALL)
+COMMENT = re.compile(r'/\*.*?\*/|//[^\n]*', re.DOTALL)
+
+
+def read_pool_table(filename):
+    """ Return the (size, blocks) entries of the pmalloc_pool_config table in
+        a C source or header file """
+    with open(filename) as f:
+        text = COMMENT.sub('', f.read())
+    table = POOL_TABLE.search(text)
+    if not table:
+        raise ValueError('No pmalloc_pool_config table in {0}'.format(filename))
+    return [(int(size), int(blocks))
+            for size, blocks in POOL_ENTRY.findall(table.group(1))]
+
+
+def merge_pools(*tables):
+    """ Combine pool tables the way get_pmalloc_config() does: blocks of
+        equal size accumulate and the result is sorted by size """
+    pools = {}
+    for table in tables:
+        for size, blocks in table:
+            if blocks:
+                pools[size] = pools.get(size, 0) + blocks
+    return sorted(pools.items())
+
+
+def read_trace(filename):
+    """ Return the records of a trace dump, oldest first, and whether the
+        ring buffer wrapped """
+    with open(filename, 'rb') as f:
+        data = f.read()
+    if len(data) < COUNT_SIZE:
+        raise ValueError('{0} is too short to be a trace'.format(filename))
+    count, = struct.unpack_from(COUNT_FORMAT, data)
+    entries = (len(data) - COUNT_SIZE) // RECORD_SIZE
+    if not entries:
+        raise ValueError('{0} holds no trace records'.format(filename))
+    records = [struct.unpack_from(RECORD_FORMAT, data,
+                                  COUNT_SIZE + i * RECORD_SIZE)
+               for i in range(entries)]
+    if count <= entries:
+        return records[:count], False
+    oldest = count % entries
+    return records[oldest:] + records[:oldest], True
+
+
+class PoolUsage(object):
+    """ Usage figures for one run-time pool """
+    def __init__(self, size, blocks):
+        self.size = size
+        self.blocks = blocks
+        self.in_use = 0
+        self.high_water = 0
+        self.ideal = 0
+        self.ideal_peak = 0
+        self.allocs = 0
+        self.fallbacks = 0
+        self.failures = 0
+        self.waste = 0
+        self.peak_waste = 0
+        self.lifetime = 0
+        self.lifetimes = 0
+
+
+def replay(records, pools):
+    """ Replay the trace against the pool configuration and return the usage
+        of each pool, plus the number of frees that had no matching
+        allocation in the trace """
+    usage = [PoolUsage(size, blocks) for size, blocks in pools]
+    sizes = [size for size, _ in pools]
+    live = {}
+    unmatched = 0
+
+    def ideal_pool(size):
+        for index, pool_size in enumerate(sizes):
+            if size <= pool_size:
+                return index
+        return None
+
+    for time, block, _, size, pool, event in records:
+        if event == EVENT_ALLOC:
+            if pool >= len(usage):
+                raise ValueError('Trace uses pool {0} but only {1} pools '
+                                 'are configured'.format(pool, len(usage)))
+            actual = usage[pool]
+            actual.allocs += 1
+            actual.in_use += 1
+            actual.high_water = max(actual.high_water, actual.in_use)
+            actual.waste += actual.size - size
+            actual.peak_waste = max(actual.peak_waste, actual.waste)
+            ideal = ideal_pool(size)
+            usage[ideal].ideal += 1
+            usage[ideal].ideal_peak = max(usage[ideal].ideal_peak,
+                                          usage[ideal].ideal)
+            if ideal != pool:
+                usage[ideal].fallbacks += 1
+            live[block] = (time, size, pool, ideal)
+        elif event == EVENT_FREE:
+            if block not in live:
+                unmatched += 1
+                continue
+            start, size, pool, ideal = live.pop(block)
+            actual = usage[pool]
+            actual.in_use -= 1
+            actual.waste -= actual.size - size
+            actual.lifetime += (time - start) % TIME_MODULUS
+            actual.lifetimes += 1
+            usage[ideal].ideal -= 1
+        elif event == EVENT_FAIL:
+            ideal = ideal_pool(size)
+            if ideal is not None:
+                usage[ideal].failures += 1
+            else:
+                usage[-1].failures += 1
+
+    return usage, unmatched
+
+
+def size_pools(usage, base, headroom):
+    """ Return the app pool table that, merged with the base pools, gives
+        every pool enough blocks for its peak demand plus headroom percent """
+    base_blocks = dict(base)
+    app = []
+    for pool in usage:
+        if not pool.ideal_peak:
+            continue
+        needed = (pool.ideal_peak * (100 + headroom) + 99) // 100
+        extra = needed - base_blocks.get(pool.size, 0)
+        if extra > 0:
+            app.append((pool.size, extra))
+    return app
+
+
+def print_report(usage, unmatched, wrapped, out):
+    print('  size  blocks   hwm  ideal  fallbacks  failures  waste  '
+          'mean life (ms)', file=out)
+    for pool in usage:
+        life = (float(pool.lifetime) / pool.lifetimes / 1000
+                if pool.lifetimes else 0.0)
+        print('{0:6d}  {1:6d} {2:5d}  {3:5d}  {4:9d}  {5:8d}  {6:5d}  '
+              '{7:14.1f}'.format(pool.size, pool.blocks, pool.high_water,
+                                 pool.ideal_peak, pool.fallbacks,
+                                 pool.failures, pool.peak_waste, life),
+              file=out)
+    print('', file=out)
+    print('hwm: most blocks in use, ideal: peak requests sized for the pool,',
+          file=out)
+    print('fallbacks: requests served by a larger pool, waste: peak bytes',
+          file=out)
+    print('lost to rounding up to the block size', file=out)
+    if wrapped or unmatched:
+        print('', file=out)
+        print('Warning: the trace wrapped or started after boot ({0} frees '
+              'without an allocation); peaks are lower bounds'
+              .format(unmatched), file=out)
+
+
+def print_pool_table(app, base, out):
+    merged = merge_pools(base, app)
+    slots = sum(blocks for _, blocks in merged)
+    total = sum(size * blocks for size, blocks in merged)
+    print('static const pmalloc_pool_config app_pools[] =', file=out)
+    print('{', file=out)
+    for i, (size, blocks) in enumerate(app):
+        separator = ',' if i < len(app) - 1 else ''
+        print('    {{ {0:3d}, {1:2d} }}{2}'.format(size, blocks, separator),
+              file=out)
+    print('', file=out)
+    print('    /* Including the pools in pmalloc_config_P1.h:', file=out)
+    print('       Total slots: {0}'.format(slots), file=out)
+    print('       Total bytes: {0}'.format(total), file=out)
+    print('    */', file=out)
+    print('};', file=out)
+
+
+def parse_args(args):
+    parser = argparse.ArgumentParser(
+        description='Size pmalloc pools from a binary allocation trace')
+    parser.add_argument('trace',
+                        help='Dump of pmalloc_trace_log_count followed by '
+                             'pmalloc_trace_log')
+    parser.add_argument('--base', required=True,
+                        help='File holding the OS pool table '
+                             '(pmalloc_config_P1.h)')
+    parser.add_argument('--app', required=True,
+                        help='File holding the application pool table the '
+                             'trace was captured with')
+    parser.add_argument('--headroom', type=int, default=25,
+                        help='Percentage of spare blocks to add to each '
+                             'pool\'s peak demand (default 25)')
+    return parser.parse_args(args)
+
+
+def main(args):
+    args = parse_args(args)
+    base = read_pool_table(args.base)
+    pools = merge_pools(base, read_pool_table(args.app))
+    records, wrapped = read_trace(args.trace)
+    usage, unmatched = replay(records, pools)
+
+    print_report(usage, unmatched, wrapped, sys.stdout)
+    print('', file=sys.stdout)
+    print_pool_table(size_pools(usage, base, args.headroom), base, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,142 @@
+#! /usr/bin/env python
+############################################################################
+# CONFIDENTIAL
+#
+# Copyright (c) 2020 Qualcomm Technologies International, Ltd.
+#   %%version
+#
+#############################################################################
+
+from __future__ import print_function
+
+# Build the RWCP server from rwcp_server.c on the host and run the loss and
+# reorder simulator against it. Every library header the server includes is
+# replaced by an empty file; rwcp_loss_simulator_host.h supplies what is
+# really needed. With --baseline the server from another git revision is
+# built and run too, so the two can be compared. That revision must be from
+# before the reorder buffer was added, or have the same GAIA interface as the
+# tree.
+
+import optparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+ADK_DIR = os.path.normpath(os.path.join(SCRIPT_DIR, "..", ".."))
+RWCP_SERVER_DIR = os.path.join(ADK_DIR, "src", "libs", "rwcp_server")
+RWCP_SERVER_FILES = ("rwcp_server.c", "rwcp_server.h")
+HOST_HEADER = os.path.join(SCRIPT_DIR, "rwcp_loss_simulator_host.h")
+SIMULATOR_SOURCE = os.path.join(SCRIPT_DIR, "rwcp_loss_simulator.c")
+
+# Headers taken from the host C library rather than replaced
+HOST_HEADERS = ("stdio.h", "stdlib.h", "string.h")
+
+INCLUDE_RE = re.compile(r'^\s*#\s*include\s+[<"]([^>"]+)[>"]', re.M)
+
+def add_cmd_line_options(parser):
+    parser.add_option("-c", "--cc",
+                      dest="cc",
+                      type="string",
+                      help="Host C compiler and any extra flags",
+                      default="gcc")
+    parser.add_option("-b", "--baseline",
+                      dest="baseline",
+                      type="string",
+                      help="Git revision of the RWCP server to compare with",
+                      default=None)
+    parser.add_option("-f", "--flow-off",
+                      dest="flow_off",
+                      type="int",
+                      help="Percentage of held segments the upgrade "
+                           "library flows off for a tick",
+                      default=0)
+    parser.add_option("-s", "--segments",
+                      dest="segments",
+                      type="int",
+                      help="Segments sent in each run",
+                      default=20000)
+
+def get_server_sources(revision, source_dir):
+    """
+    Write the RWCP server source and header at the given git revision, or
+    those in the tree if revision is None
+    """
+    os.makedirs(source_dir)
+    for name in RWCP_SERVER_FILES:
+        path = os.path.join(RWCP_SERVER_DIR, name)
+        if revision is None:
+            shutil.copy(path, source_dir)
+        else:
+            relative = os.path.relpath(path, ADK_DIR).replace(os.sep, "/")
+            content = subprocess.check_output(
+                ["git", "show", "%s:./%s" % (revision, relative)],
+                cwd=ADK_DIR)
+            with open(os.path.join(source_dir, name), "wb") as f:
+                f.write(content)
+
+def make_stub_headers(source_dir, stub_dir):
+    """
+    Create an empty file for each library header the server includes
+    """
+    if not os.path.isdir(stub_dir):
+        os.makedirs(stub_dir)
+    for name in RWCP_SERVER_FILES:
+        with open(os.path.join(source_dir, name)) as f:
+            for header in INCLUDE_RE.findall(f.read()):
+                if header in HOST_HEADERS or header in RWCP_SERVER_FILES:
+                    continue
+                open(os.path.join(stub_dir, header), "w").close()
+
+def build_and_run(options, revision, work_dir):
+    """
+    Build the simulator against the server at revision and run it
+    """
+    name = revision or "tree"
+    source_dir = os.path.join(work_dir, re.sub(r"[^\w.-]", "_", name))
+    stub_dir = os.path.join(source_dir, "stubs")
+    get_server_sources(revision, source_dir)
+    make_stub_headers(source_dir, stub_dir)
+
+    defines = []
+    with open(os.path.join(source_dir, "rwcp_server.c")) as f:
+        if "RwcpServerProcessBufferedSegment" not in f.read():
+            defines.append("-DRWCP_LOSS_SIMULATOR_NO_REORDER_BUFFER")
+
+    exe = os.path.join(source_dir, "rwcp_loss_simulator")
+    if subprocess.call(options.cc.split() + ["-O2", "-g", "-Wall",
+                        "-Wno-unused-function"] + defines +
+                       ["-include", HOST_HEADER,
+                        "-I", stub_dir, "-I", source_dir,
+                        "-o", exe, SIMULATOR_SOURCE]) != 0:
+        return 1
+
+    print("RWCP server from %s:" % name)
+    sys.stdout.flush()
+    return subprocess.call([exe,
+                            "--segments", str(options.segments),
+                            "--flow-off", str(options.flow_off)])
+
+def main():
+    parser = optparse.OptionParser()
+    add_cmd_line_options(parser)
+    options, _ = parser.parse_args()
+
+    work_dir = tempfile.mkdtemp()
+    try:
+        revisions = [None]
+        if options.baseline:
+            revisions.insert(0, options.baseline)
+        for revision in revisions:
+            result = build_and_run(options, revision, work_dir)
+            if result != 0:
+                return result
+        return 0
+    finally:
+        shutil.rmtree(work_dir)
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,269 @@
+/* Copyright (c) 2020 Qualcomm Technologies International, Ltd. */
+/*   %%version */
+/**
+ * \file
+ * Loss and reorder simulator for the RWCP server in rwcp_server.c.
+ *
+ * An RWCP client with a fixed window sends DATA segments to the server over
+ * a link that drops some of them and delays others past the segments sent
+ * after them. The client sends one segment per tick while its window is
+ * open, moves its window on with each cumulative DATA ACK and goes back to
+ * the oldest unacknowledged segment on a GAP or after a timeout. The return
+ * path is lossless.
+ *
+ * GAIA is modelled as the upgrade library taking every command straight
+ * away, except that a command held in the reorder buffer can be flowed off
+ * for a tick. Every command reaching GAIA is checked to be the next one in
+ * order, and each run stops with an error if one is out of order.
+ *
+ * Build and run with run_rwcp_loss_simulator.py.
+ */
+
+#include "rwcp_server.c"
+
+#include <stdio.h>
+#include <string.h>
+
+#define SEGMENT_SIZE (20)
+#define MAX_IN_FLIGHT (256)
+#define TIMEOUT_TICKS (60)
+#define MAX_TICKS (10000000)
+
+typedef struct
+{
+    unsigned index;
+    unsigned arrival;
+} in_flight_t;
+
+static struct
+{
+    unsigned segments;
+    unsigned window;
+    unsigned latency;
+    unsigned flow_off;
+    unsigned long long seed;
+} config = { 20000, 15, 4, 0, 12345 };
+
+static unsigned long long rng;
+static unsigned delivered;
+static unsigned order_errors;
+static int last_ack;
+static int last_gap;
+
+/* Held command flowed off by the upgrade library, NULL if none */
+static uint8 *flowed_off_command;
+static uint16 flowed_off_size;
+
+static unsigned random_percent(void)
+{
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned)(rng >> 33) % 100;
+}
+
+static void deliver(const uint8 *command, uint16 size)
+{
+    unsigned index;
+
+    memcpy(&index, command, sizeof(index));
+    if (index != delivered || size != SEGMENT_SIZE)
+    {
+        order_errors++;
+    }
+    delivered++;
+}
+
+void GaiaRwcpProcessCommand(uint8 *command, uint16 size_command)
+{
+    deliver(command, size_command);
+}
+
+bool GaiaRwcpProcessBufferedCommand(uint8 *command, uint16 size_command)
+{
+    if (random_percent() < config.flow_off)
+    {
+        flowed_off_command = command;
+        flowed_off_size = size_command;
+        return FALSE;
+    }
+    deliver(command, size_command);
+    return TRUE;
+}
+
+void GaiaRwcpSendNotification(uint8 *payload, uint16 payload_length)
+{
+    UNUSED(payload_length);
+
+    if ((payload[0] & RWCP_COMMAND_MASK) == RWCP_SERVER_CMD_DATA_ACK)
+    {
+        last_ack = payload[0] & RWCP_SEQUENCE_MASK;
+    }
+    else if ((payload[0] & RWCP_COMMAND_MASK) == RWCP_SERVER_CMD_GAP)
+    {
+        last_gap = payload[0] & RWCP_SEQUENCE_MASK;
+    }
+    free(payload);
+}
+
+/* What gaiaTransportGattProcessSource does on each UPGRADE_TRANSPORT_DATA_CFM:
+ * pass held segments on before reading the next packet */
+static void process_held_segments(void)
+{
+#ifndef RWCP_LOSS_SIMULATOR_NO_REORDER_BUFFER
+    if (flowed_off_command)
+    {
+        deliver(flowed_off_command, flowed_off_size);
+        flowed_off_command = NULL;
+        RwcpServerBufferedSegmentTaken();
+    }
+    while (!flowed_off_command && RwcpServerProcessBufferedSegment())
+    {
+    }
+#endif
+}
+
+static void send_segment(unsigned index)
+{
+    uint8 packet[RWCP_HEADER_SIZE + SEGMENT_SIZE];
+
+    packet[0] = RWCP_CLIENT_CMD_DATA | (index % RWCP_SEQUENCE_NUMBER_MAX);
+    memset(&packet[RWCP_PAYLOAD_OFFSET], 0, SEGMENT_SIZE);
+    memcpy(&packet[RWCP_PAYLOAD_OFFSET], &index, sizeof(index));
+    (void)RwcpServerHandleMessage(packet, sizeof(packet));
+}
+
+/* Returns the segments delivered per tick */
+static double run(unsigned loss, unsigned reorder)
+{
+    in_flight_t in_flight[MAX_IN_FLIGHT];
+    unsigned num_in_flight = 0;
+    unsigned base = 0;
+    unsigned next = 0;
+    unsigned timer = 0;
+    unsigned tick;
+    uint8 syn = RWCP_CLIENT_CMD_SYN | (RWCP_SEQUENCE_NUMBER_MAX - 1);
+
+    rng = config.seed;
+    delivered = 0;
+    order_errors = 0;
+    flowed_off_command = NULL;
+
+    RwcpServerInit(0);
+    (void)RwcpServerHandleMessage(&syn, sizeof(syn));
+    last_ack = -1;
+    last_gap = -1;
+
+    for (tick = 0; delivered < config.segments && tick < MAX_TICKS; tick++)
+    {
+        unsigned i;
+
+        process_held_segments();
+
+        if (next < base + config.window && next < config.segments)
+        {
+            if (random_percent() >= loss && num_in_flight < MAX_IN_FLIGHT)
+            {
+                in_flight[num_in_flight].index = next;
+                in_flight[num_in_flight].arrival = tick + config.latency;
+                if (random_percent() < reorder)
+                {
+                    in_flight[num_in_flight].arrival += 1 + random_percent() % 4;
+                }
+                num_in_flight++;
+            }
+            next++;
+        }
+
+        for (i = 0; i < num_in_flight; )
+        {
+            if (in_flight[i].arrival <= tick)
+            {
+                send_segment(in_flight[i].index);
+                process_held_segments();
+                in_flight[i] = in_flight[--num_in_flight];
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        if (last_ack >= 0)
+        {
+            unsigned acked = base;
+            while (acked < next && acked % RWCP_SEQUENCE_NUMBER_MAX != (unsigned)last_ack)
+            {
+                acked++;
+            }
+            if (acked < next)
+            {
+                base = acked + 1;
+                timer = 0;
+            }
+            last_ack = -1;
+        }
+        if (last_gap >= 0)
+        {
+            next = base;
+            timer = 0;
+            last_gap = -1;
+        }
+        if (base < next && ++timer > TIMEOUT_TICKS)
+        {
+            next = base;
+            timer = 0;
+        }
+    }
+
+    if (order_errors || delivered < config.segments)
+    {
+        printf("loss %u%% reorder %u%%: %u commands out of order, %u of %u delivered\n",
+               loss, reorder, order_errors, delivered, config.segments);
+        exit(1);
+    }
+    return (double)delivered / tick;
+}
+
+static void parse_args(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i + 1 < argc; i += 2)
+    {
+        unsigned long value = strtoul(argv[i + 1], NULL, 0);
+
+        if (!strcmp(argv[i], "--segments"))
+            config.segments = (unsigned)value;
+        else if (!strcmp(argv[i], "--window"))
+            config.window = (unsigned)value;
+        else if (!strcmp(argv[i], "--latency"))
+            config.latency = (unsigned)value;
+        else if (!strcmp(argv[i], "--flow-off"))
+            config.flow_off = (unsigned)value;
+        else if (!strcmp(argv[i], "--seed"))
+            config.seed = value;
+        else
+        {
+            printf("unknown option %s\n", argv[i]);
+            exit(2);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const unsigned loss[] = { 0, 1, 2, 5, 10 };
+    static const unsigned reorder[] = { 0, 20 };
+    unsigned i, j;
+
+    parse_args(argc, argv);
+
+    for (j = 0; j < sizeof(reorder) / sizeof(reorder[0]); j++)
+    {
+        for (i = 0; i < sizeof(loss) / sizeof(loss[0]); i++)
+        {
+            printf("loss %2u%% reorder %2u%%: %.3f segments/tick\n",
+                   loss[i], reorder[j], run(loss[i], reorder[j]));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+/* Copyright (c) 2020 Qualcomm Technologies International, Ltd. */
+/*   %%version */
+/**
+ * \file
+ * Host definitions standing in for the library and firmware headers that
+ * rwcp_server.c includes, so the RWCP server can be built and exercised on
+ * a PC. run_rwcp_loss_simulator.py replaces each of those headers with an
+ * empty file and forces this one in first.
+ *
+ * Only what the server needs is modelled: GAIA is provided by the
+ * simulator, and a failed allocation aborts as Panic() would.
+ */
+
+#ifndef RWCP_LOSS_SIMULATOR_HOST_H_
+#define RWCP_LOSS_SIMULATOR_HOST_H_
+
+#include <stdlib.h>
+
+#define TRUE (1)
+#define FALSE (0)
+#define UNUSED(x) ((void)(x))
+
+typedef unsigned char uint8;
+typedef unsigned short uint16;
+typedef unsigned int uint32;
+typedef int bool;
+
+typedef struct TaskData *Task;
+
+#define RWCP_MSG_BASE (0x100)
+
+#define Panic() abort()
+
+static void *PanicUnlessMalloc(size_t size)
+{
+    void *p = malloc(size);
+    if (!p)
+    {
+        Panic();
+    }
+    return p;
+}
+
+/* The RWCP entry points of gaia.h */
+void GaiaRwcpProcessCommand(uint8 *command, uint16 size_command);
+bool GaiaRwcpProcessBufferedCommand(uint8 *command, uint16 size_command);
+void GaiaRwcpSendNotification(uint8 *payload, uint16 payload_length);
+
+#endif /* RWCP_LOSS_SIMULATOR_HOST_H_ */
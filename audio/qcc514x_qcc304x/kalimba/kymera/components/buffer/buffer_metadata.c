@@ -34,6 +34,12 @@ Private Macro Declarations
 /* Get a pointer to the next private data item in the array */
 #define PRIV_ITEM_NEXT(item) (metadata_priv_item *)((unsigned *)(item) + PRIV_ITEM_LENGTH((item)->length)/sizeof(unsigned));
 
+/* Private data of up to this many octets is allocated in blocks of exactly
+ * this size, so the blocks can be recycled. This covers an item count plus
+ * one item of up to two words, e.g. a TTP offset or an EOF callback reference.
+ */
+#define PRIV_DATA_CACHE_BLOCK_SIZE (4 * sizeof(unsigned))
+
 /* Attempt to limit the total number of allocated tags
  * This number is checked against the allocation count in buff_metadata_tag_threshold_exceeded()
  * Note: Not static or the compiler will optimise it out, and we want it in memory for easy patchability
@@ -43,6 +49,16 @@ Private Macro Declarations
 #else
 unsigned tag_alloc_threshold = DEFAULT_TAG_ALLOC_THRESHOLD;
 #endif
+
+/* Number of freed tags (and of freed small private data blocks) kept for
+ * reuse rather than returned to the heap, unless buff_metadata_init()
+ * says otherwise. Not static, for the same reason as tag_alloc_threshold.
+ */
+#ifndef DEFAULT_TAG_CACHE_LIMIT
+#define DEFAULT_TAG_CACHE_LIMIT 16
+#endif
+unsigned tag_cache_limit = DEFAULT_TAG_CACHE_LIMIT;
+
 /****************************************************************************
 Private Variable Definitions
 */
@@ -50,6 +66,18 @@ Private Variable Definitions
 /* Count of currently-allocated tags */
 static unsigned tag_alloc_count = 0;
 
+/* Tag churn statistics, readable with buff_metadata_get_tag_stats() */
+static metadata_tag_stats tag_stats;
+
+/* Freed tags kept for reuse, linked through their next field */
+static metadata_tag *tag_cache = NULL;
+static unsigned tag_cache_count = 0;
+
+/* Freed private data blocks of PRIV_DATA_CACHE_BLOCK_SIZE kept for reuse,
+ * linked through their first word */
+static metadata_priv_data *priv_data_cache = NULL;
+static unsigned priv_data_cache_count = 0;
+
 /****************************************************************************
 Private Function Declarations
 */
@@ -58,6 +86,68 @@ Private Function Declarations
 Private Function Definitions
 */
 
+/**
+ * \brief Allocate a block for private data, from the cache if it is small
+ */
+static metadata_priv_data *priv_data_alloc(unsigned size)
+{
+    metadata_priv_data *data = NULL;
+
+    if (size <= PRIV_DATA_CACHE_BLOCK_SIZE)
+    {
+        LOCK_INTERRUPTS;
+        data = priv_data_cache;
+        if (data != NULL)
+        {
+            priv_data_cache = *(metadata_priv_data **)data;
+            priv_data_cache_count--;
+            tag_stats.heap_calls_avoided++;
+        }
+        UNLOCK_INTERRUPTS;
+
+        if (data == NULL)
+        {
+            data = (metadata_priv_data *)xpmalloc(PRIV_DATA_CACHE_BLOCK_SIZE);
+        }
+    }
+    else
+    {
+        data = (metadata_priv_data *)xpmalloc(size);
+    }
+    return data;
+}
+
+/**
+ * \brief Free a block of private data, to the cache if it can be reused
+ */
+static void priv_data_free(metadata_priv_data *data)
+{
+    unsigned size;
+
+    if (data == NULL)
+    {
+        return;
+    }
+
+    /* pmalloc may round the block up, so accept anything
+     * that is at least the block size but not wastefully larger */
+    size = (unsigned)psizeof(data);
+    if ((size >= PRIV_DATA_CACHE_BLOCK_SIZE) && (size < 2 * PRIV_DATA_CACHE_BLOCK_SIZE))
+    {
+        LOCK_INTERRUPTS;
+        if (priv_data_cache_count < tag_cache_limit)
+        {
+            *(metadata_priv_data **)data = priv_data_cache;
+            priv_data_cache = data;
+            priv_data_cache_count++;
+            tag_stats.heap_calls_avoided++;
+            data = NULL;
+        }
+        UNLOCK_INTERRUPTS;
+    }
+    pfree(data);
+}
+
 /**
  * \brief Get total length (in allocation units) of existing private data
  */
@@ -126,16 +216,25 @@ void buff_metadata_init(unsigned count)
      * making space for the number of tags specified by count
      */
 #ifdef METADATA_USE_PMALLOC
-     /* Eventually this will probably use some private storage
-     * but for initial prototyping we'll just use pmalloc
-     * to allocate the tags on demand
-     * so this doesn't need to do anything
+    /* Tags are allocated from pmalloc on demand, but up to count of
+     * them are kept for reuse once freed, rather than returned to the heap.
      */
+    tag_cache_limit = count;
 #else
     /* TODO some stuff to initialise local storage */
 #endif
 }
 
+/*
+ * buff_metadata_get_tag_stats
+ */
+void buff_metadata_get_tag_stats(metadata_tag_stats *stats)
+{
+    LOCK_INTERRUPTS;
+    *stats = tag_stats;
+    UNLOCK_INTERRUPTS;
+}
+
 /*
  * buff_metadata_tag_threshold_exceeded
  */
@@ -148,12 +247,33 @@ metadata_tag *buff_metadata_new_tag(void)
 {
     patch_fn_shared(buff_metadata);
 #ifdef METADATA_USE_PMALLOC
-    /* See above, just use the normal dynamic memory system for now */
-    metadata_tag *tag = xzpnew(metadata_tag);
+    /* See above, reuse a freed tag if there is one */
+    metadata_tag *tag;
+
+    LOCK_INTERRUPTS;
+    tag = tag_cache;
+    if (tag != NULL)
+    {
+        tag_cache = tag->next;
+        tag_cache_count--;
+        tag_stats.heap_calls_avoided++;
+    }
+    UNLOCK_INTERRUPTS;
+
+    if (tag != NULL)
+    {
+        memset(tag, 0, sizeof(metadata_tag));
+    }
+    else
+    {
+        tag = xzpnew(metadata_tag);
+    }
+
     if (tag != NULL)
     {
         LOCK_INTERRUPTS;
         tag_alloc_count++;
+        tag_stats.tags_created++;
         UNLOCK_INTERRUPTS;
 
         return tag;
@@ -174,9 +294,9 @@ void buff_metadata_delete_tag(metadata_tag *tag, bool process_eof)
         {
             metadata_handle_eof_tag_deletion(tag);
         }
-        pdelete(tag->xdata);
+        priv_data_free(tag->xdata);
 #ifdef METADATA_USE_PMALLOC
-        /* See above, just use the normal dynamic memory system for now */
+        /* See above, keep the tag for reuse if there is room */
         LOCK_INTERRUPTS;
         if (tag_alloc_count > 0)
         {
@@ -189,6 +309,14 @@ void buff_metadata_delete_tag(metadata_tag *tag, bool process_eof)
             L2_DBG_MSG("Metadata tag deleted but count is already zero ?");
 #endif
         }
+        if (tag_cache_count < tag_cache_limit)
+        {
+            tag->next = tag_cache;
+            tag_cache = tag;
+            tag_cache_count++;
+            tag_stats.heap_calls_avoided++;
+            tag = NULL;
+        }
         UNLOCK_INTERRUPTS;
         pdelete(tag);
 #endif /* METADATA_USE_PMALLOC */
@@ -227,7 +355,7 @@ metadata_tag *buff_metadata_copy_tag(metadata_tag *tag)
         if (tag->xdata != NULL)
         {
             unsigned length = buff_metadata_get_priv_data_length(tag);
-            metadata_priv_data *new_data = (metadata_priv_data *)xpmalloc(length);
+            metadata_priv_data *new_data = priv_data_alloc(length);
 
             /* If there isn't enough RAM for this, tough the data gets lost */
             if (new_data != NULL)
@@ -1074,7 +1202,7 @@ void* buff_metadata_add_private_data(metadata_tag *tag, METADATA_PRIV_KEY key, u
     if (new_size > psizeof(tag->xdata))
     {
         /* New allocation needed */
-        if ((new_data = (metadata_priv_data *)xpmalloc(new_size)) == NULL)
+        if ((new_data = priv_data_alloc(new_size)) == NULL)
         {
             /* Allocation failed, just return NULL without changing anything */
             return NULL;
@@ -1088,7 +1216,7 @@ void* buff_metadata_add_private_data(metadata_tag *tag, METADATA_PRIV_KEY key, u
             /* Copy all of the existing data (including the item count)... */
             memcpy(new_data, tag->xdata, old_size);
             /* ...and free the old data */
-            pfree(tag->xdata);
+            priv_data_free(tag->xdata);
             tag->xdata = new_data;
         }
         /* Increment the item count for the new item */
@@ -226,6 +226,15 @@ struct metadata_list_struct
 
 };
 
+/* Cumulative metadata tag statistics. Sampling them periodically gives
+ * the tag churn per second and how many heap calls recycling avoided.
+ */
+typedef struct
+{
+    unsigned tags_created;          /**< tags returned by buff_metadata_new_tag() */
+    unsigned heap_calls_avoided;    /**< pmalloc/pfree calls saved by reusing tags and private data */
+} metadata_tag_stats;
+
 /****************************************************************************
 Public Variable Definitions
 */
@@ -238,10 +247,17 @@ Public Function Declarations
 /**
  * Initialise the buffer metadata system.
  *
- * \param count Maximum metadata tags (system-wide) to support.
+ * \param count Maximum freed metadata tags (system-wide) to keep for reuse.
  */
 extern void buff_metadata_init(unsigned count);
 
+/**
+ * Get the cumulative metadata tag statistics.
+ *
+ * \param stats Filled in with the statistics.
+ */
+extern void buff_metadata_get_tag_stats(metadata_tag_stats *stats);
+
 /**
  * Create a new (empty) metadata tag
  *
@@ -36,6 +36,11 @@ Private Variable Definitions
  */
 OPERATOR_DATA* oplist_head = NULL;
 
+/** Operators in oplist_head indexed by internal operator id, so that looking
+ *  one up does not need to walk the list. The list is kept for iteration.
+ */
+static OPERATOR_DATA* op_table[OPMGR_MAX_OPID_VALUE + 1];
+
 /* Pointer to head of 'remote' operators list - only used by P0 OpMgr.
  * If separate images are built, then this is compiled out in P1, otherwise in
  * the case of common image, it will be present in P1 but not used.
@@ -46,7 +51,9 @@ OPERATOR_DATA* oplist_head = NULL;
  *  as operator extra data is not allocated on P0 for remote ops.
  */
 DM_P0_RW_ZI OPERATOR_DATA* remote_oplist_head = NULL;
-static OPERATOR_DATA* find_op_data_in_list(unsigned int id, OPERATOR_DATA* list_head);
+
+/** Operators in remote_oplist_head indexed by internal operator id. */
+DM_P0_RW_ZI static OPERATOR_DATA* remote_op_table[OPMGR_MAX_OPID_VALUE + 1];
 #endif
 
 
@@ -472,7 +479,7 @@ unsigned int opmgr_get_list_remote_ops_count(unsigned int num_ops,
     for (i=0; i<num_ops; i++)
     {
         id = EXT_TO_INT_OPID(op_list[i]);
-        entry = find_op_data_in_list(id, remote_oplist_head);
+        entry = get_remote_op_data_from_id(id);
         n += ((entry != NULL)&&(entry->processor_id==proc_id));
     }
 
@@ -512,7 +519,11 @@ PROC_ID_NUM opmgr_get_processor_id(unsigned ep_id)
  */
 OPERATOR_DATA* get_remote_op_data_from_id(unsigned int id)
 {
-    return (PROC_PRIMARY_CONTEXT() ? find_op_data_in_list(id, remote_oplist_head) : NULL);
+    if (PROC_PRIMARY_CONTEXT() && (id <= OPMGR_MAX_OPID_VALUE))
+    {
+        return remote_op_table[id];
+    }
+    return NULL;
 }
 #endif /* defined(SUPPORTS_MULTI_CORE) */
 
@@ -523,8 +534,6 @@ OPERATOR_DATA* get_remote_op_data_from_id(unsigned int id)
  */
 bool opmgr_does_op_exist(void* op_data)
 {
-    OPERATOR_DATA* temp;
-
     patch_fn_shared(opmgr);
 
     if(op_data != NULL)
@@ -534,12 +543,9 @@ bool opmgr_does_op_exist(void* op_data)
          * cores, create a new function, but currently nothing needs
          * to use such a function.
          */
-        for(temp = oplist_head; temp != NULL; temp = temp->next)
+        if (get_op_data_from_id(((OPERATOR_DATA*)op_data)->id) == op_data)
         {
-            if (op_data == temp)
-            {
-                return TRUE;
-            }
+            return TRUE;
         }
     }
 
@@ -791,30 +797,36 @@ bool opmgr_destroy_op_endpoints(OPERATOR_DATA* op_data)
 }
 
 
-static OPERATOR_DATA* find_op_data_in_list(unsigned int id, OPERATOR_DATA* list_head)
+/**
+ * \brief    Get the id-indexed table of the operators in an operator list
+ *
+ * \param    op_list  the operator list
+ */
+static OPERATOR_DATA** get_op_table_of_list(OPERATOR_DATA** op_list)
 {
-    OPERATOR_DATA* entry = list_head;
-
-    while ((entry != NULL) && (entry->id != id))
+#if defined(SUPPORTS_MULTI_CORE)
+    if (op_list == &remote_oplist_head)
     {
-        entry = entry->next;
+        return remote_op_table;
     }
-
-    return entry;
+#endif
+    PL_ASSERT(op_list == &oplist_head);
+    return op_table;
 }
 
 /****************************************************************************
  *
  * get_op_data_from_id
  *
- * SINGLECORE: it searches local list and return the entry.
- * MULTICORE: it searches in local and remote op lists and return the entry.
- *            (It only exist on P0 when separate image is built).
+ * It looks up the local list and returns the entry.
  */
 OPERATOR_DATA* get_op_data_from_id(unsigned int id)
 {
-    OPERATOR_DATA* entry = find_op_data_in_list(id, oplist_head);
-    return entry;
+    if (id > OPMGR_MAX_OPID_VALUE)
+    {
+        return NULL;
+    }
+    return op_table[id];
 }
 
 /****************************************************************************
@@ -827,16 +839,53 @@ OPERATOR_DATA* get_op_data_from_id(unsigned int id)
  */
 OPERATOR_DATA* get_anycore_op_data_from_id(unsigned int id)
 {
-    OPERATOR_DATA* entry = find_op_data_in_list(id, oplist_head);
+    OPERATOR_DATA* entry = get_op_data_from_id(id);
 
     /* If we are on P0, and haven't found in local list then look among remote ops */
-    if (PROC_PRIMARY_CONTEXT() && (entry == NULL))
+    if (entry == NULL)
     {
-        entry = find_op_data_in_list(id, remote_oplist_head);
+        entry = get_remote_op_data_from_id(id);
     }
     return entry;
 }
 
+/**
+ * \brief    Add the operator data to the head of an operator list
+ *
+ * \param    op_data  operator data, with its id set
+ * \param    op_list  the operator list
+ */
+void add_op_data_to_list(OPERATOR_DATA* op_data, OPERATOR_DATA** op_list)
+{
+    OPERATOR_DATA** table = get_op_table_of_list(op_list);
+
+    PL_ASSERT(op_data->id <= OPMGR_MAX_OPID_VALUE);
+
+    op_data->next = *op_list;
+    *op_list = op_data;
+    table[op_data->id] = op_data;
+}
+
+/**
+ * \brief    Take the operator data out of an operator list without freeing it
+ *
+ * \param    op_data  operator data
+ * \param    op_list  the operator list
+ */
+void unlink_op_data_from_list(OPERATOR_DATA* op_data, OPERATOR_DATA** op_list)
+{
+    OPERATOR_DATA **p;
+    OPERATOR_DATA** table = get_op_table_of_list(op_list);
+
+    p = op_list;
+    while(*p && *p != op_data) p = &((*p)->next);
+    if(*p)
+    {
+        *p = op_data->next;
+        table[op_data->id] = NULL;
+    }
+}
+
 /**
  * \brief    Remove the operator data from the operator list
  *
@@ -844,21 +893,18 @@ OPERATOR_DATA* get_anycore_op_data_from_id(unsigned int id)
  */
 void remove_op_data_from_list(unsigned int id, OPERATOR_DATA** op_list)
 {
-    OPERATOR_DATA **p, *cur_op;
+    OPERATOR_DATA *cur_op = NULL;
     patch_fn_shared(opmgr);
 
-    /* Delete the entry from remote operator list */
-    cur_op = find_op_data_in_list(id, *op_list);
+    if (id <= OPMGR_MAX_OPID_VALUE)
+    {
+        cur_op = get_op_table_of_list(op_list)[id];
+    }
 
     if(cur_op != NULL)
     {
-        p = op_list;
-        while(*p && *p != cur_op) p = &((*p)->next);
-        if(*p)
-        {
-            *p = cur_op->next;
-            pfree(cur_op);
-        }
+        unlink_op_data_from_list(cur_op, op_list);
+        pfree(cur_op);
     }
     else
     {
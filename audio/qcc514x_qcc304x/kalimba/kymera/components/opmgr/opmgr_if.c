@@ -119,11 +119,6 @@ Private Constant Definitions
 #define GET_CONID_PACKED_OPID(conid, opid)  \
             ((conid & CONID_PACKED_RECV_PROC_ID_MASK) | opid);
 
-/* The highest opid value allowed to be generated. It wraps to 1 after this.
- * Currently this is 0x1fc0 >> 6 = 0x007F = 127.
- */
-#define OPMGR_MAX_OPID_VALUE (STREAM_EP_OPID_MASK >> STREAM_EP_OPID_POSN)
-
 /* Values used for 2nd parameter in 'opmgr_issue_list_cmd' (uint16 kip_msg_id).
  * When using dual-core build, use KIP_MSG_ID_xxx. When not using dual-core
  * build, the 2nd parameter is not actually used, yet define some reasonable
@@ -1044,8 +1039,8 @@ static void opmgr_create_operator_post_dnld(CONNECTION_LINK con_id,
         }
 
         /* hook pointer to specific part into the standard operator data
-         * - always next address after the extra op data pointer */
-        new_op->extra_op_data = (void*)((uintptr_t)&new_op->extra_op_data + sizeof(void*));
+         * - always next address after the standard operator data */
+        new_op->extra_op_data = (void*)(new_op + 1);
     }
 
     PL_PRINT_P0(TR_OPMGR, "Opmgr: Hook in cap data pointer into op data.\n");
@@ -1128,8 +1123,7 @@ static void opmgr_create_operator_post_dnld(CONNECTION_LINK con_id,
      * prior to this point.
      */
     {
-        new_op->next = remote_oplist_head;
-        remote_oplist_head = new_op;
+        add_op_data_to_list(new_op, &remote_oplist_head);
 
         /* Send KIP message to create it on remote processor. The KIP response
          * will lead to the API callback being called, so use some housekeeping
@@ -1140,7 +1134,7 @@ static void opmgr_create_operator_post_dnld(CONNECTION_LINK con_id,
         {
             /* All these operations happen in the background so new_op is still top
              * of the list, no need to check. */
-            remote_oplist_head = new_op->next;
+            unlink_op_data_from_list(new_op, &remote_oplist_head);
             pfree(new_op);
 
             L2_DBG_MSG("CREATE_OPERATOR failed to send remote request");
@@ -1153,8 +1147,7 @@ static void opmgr_create_operator_post_dnld(CONNECTION_LINK con_id,
     else
 #endif /* defined(SUPPORTS_MULTI_CORE) */
     {
-        new_op->next = oplist_head;
-        oplist_head = new_op;
+        add_op_data_to_list(new_op, &oplist_head);
 
         /* Create a task for the operator (BUT only if we are on the processor where the op is created).
          * All "local" operator tasks have one queue for control messages.
@@ -1170,7 +1163,7 @@ static void opmgr_create_operator_post_dnld(CONNECTION_LINK con_id,
         {
             /* All these operations happen in the background so new_op is still top
              * of the list, no need to check. */
-            oplist_head = oplist_head->next;
+            unlink_op_data_from_list(new_op, &oplist_head);
             pfree(new_op);
 
             L2_DBG_MSG("CREATE_OPERATOR failed to create new task");
@@ -1191,7 +1184,7 @@ static void opmgr_create_operator_post_dnld(CONNECTION_LINK con_id,
 
             /* All these operations happen in the background so new_op is still top
              * of the list, no need to check. */
-            oplist_head = oplist_head->next;
+            unlink_op_data_from_list(new_op, &oplist_head);
             pfree(new_op);
 
             L2_DBG_MSG("CREATE_OPERATOR failed to send message to operator");
@@ -1215,7 +1208,7 @@ static void opmgr_create_operator_post_dnld(CONNECTION_LINK con_id,
 
             /* All these operations happen in the background so new_op is still top
              * of the list, no need to check. */
-            oplist_head = oplist_head->next;
+            unlink_op_data_from_list(new_op, &oplist_head);
             pfree(new_op);
 
             L2_DBG_MSG("CREATE_OPERATOR failed, unable to save context");
@@ -302,7 +302,7 @@ static void msg_from_op_handler(tRoutingInfo *rinfo, uint16f *msg)
  */
 static void destroy_resp_handler(unsigned int op_id)
 {
-    OPERATOR_DATA **p, *cur_op;
+    OPERATOR_DATA *cur_op;
 
     cur_op = get_op_data_from_id(op_id);
     if (cur_op == NULL)
@@ -337,11 +337,9 @@ static void destroy_resp_handler(unsigned int op_id)
     delete_task(cur_op->task_id);
 
     /* Now everything is gone so delete the entry from local operator list */
-    p = &oplist_head;
-    while(*p && *p != cur_op) p = &((*p)->next);
-    if(*p)
+    if (get_op_data_from_id(cur_op->id) == cur_op)
     {
-        *p = cur_op->next;
+        unlink_op_data_from_list(cur_op, &oplist_head);
         PROFILER_DEREGISTER(cur_op->profiler);
         PROFILER_DELETE(cur_op->profiler);
         pfree(cur_op);
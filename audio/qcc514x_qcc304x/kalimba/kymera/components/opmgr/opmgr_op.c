@@ -30,6 +30,9 @@ Private constant definitions
 #define KP_TABLE_EP_SOURCES_SECTION 3
 #define KP_TABLE_EP_SINKS_SECTION 4
 
+/** The most operators that are run back to back from one background interrupt
+ * when they are fused. Anything further down the chain is kicked as normal. */
+#define OPMGR_MAX_FUSED_OPS 4
 
 /****************************************************************************
 Private variable definitions
@@ -517,6 +520,42 @@ static void remove_new_kick_prop_table_entry(OPERATOR_DATA *cur_op, unsigned tab
 }
 
 
+/**
+ * \brief Decides whether an operator runs the operator connected to its
+ * sources directly, instead of kicking it.
+ *
+ * The operators are fused if next_op is the only thing the source terminals of
+ * cur_op kick, and both run at the same priority. Otherwise any fusion is
+ * cancelled.
+ *
+ * \param cur_op The upstream operator
+ * \param next_op The operator to fuse after cur_op, NULL to cancel fusion.
+ */
+static void update_fused_op(OPERATOR_DATA *cur_op, OPERATOR_DATA *next_op)
+{
+    KP_TABLE *kpt = cur_op->kick_propagation_table;
+    unsigned fused_sources = 0;
+    BGINT_TASK task;
+
+    if ((next_op != NULL) && (next_op != cur_op) && (kpt != NULL) &&
+        (1 == kpt->num_op_sources) && (0 == kpt->num_ep_sources) &&
+        (GET_TASK_PRIORITY(next_op->task_id) == GET_TASK_PRIORITY(cur_op->task_id)) &&
+        sched_find_bgint(next_op->task_id, &task) &&
+        (kpt->table[0].kt.op_bgint_task == task))
+    {
+        fused_sources = kpt->table[0].t_mask;
+    }
+    else
+    {
+        next_op = NULL;
+    }
+
+    LOCK_INTERRUPTS;
+    cur_op->fused_op = next_op;
+    cur_op->fused_sources = fused_sources;
+    UNLOCK_INTERRUPTS;
+}
+
 /*
  * opmgr_kick_prop_table_add
  */
@@ -693,6 +732,12 @@ void opmgr_kick_prop_table_remove(unsigned endpoint_id)
         section = KP_TABLE_OP_SOURCES_SECTION;
         terminal_mask = TOUCHED_SOURCE_0 << terminal;
 
+        /* A fused operator is the only thing on the sources, so this must be
+         * its connection going away. Go back to kicking before it does. */
+        if (NULL != cur_op->fused_op)
+        {
+            update_fused_op(cur_op, NULL);
+        }
     }
     else
     {
@@ -1019,33 +1064,21 @@ void opmgr_kick_from_operator(OPERATOR_DATA *op_data,unsigned source_kicks,unsig
 LOG_STRING(operator_name, "Operator");
 #endif
 
-/****************************************************************************
+/**
+ * \brief Runs the process data function of an operator, if it is running.
  *
- * opmgr_operator_bgint_handler
+ * \param current_op The operator to run
+ * \param touched Populated with the terminals the operator touched
  *
- * Handler for all background interrupts raised on operators.
+ * \return TRUE if the operator was run, FALSE if it is stopped or suspended.
  */
 RUN_FROM_PM_RAM
-void opmgr_operator_bgint_handler(void **bg_data)
+static inline bool opmgr_run_operator(OPERATOR_DATA *current_op, TOUCHED_TERMINALS *touched)
 {
-    TOUCHED_TERMINALS touched;
-    OPERATOR_DATA* current_op = (OPERATOR_DATA*)*bg_data;
-
-    PL_PRINT_P0(TR_OPMGR, "opmgr_operator_bgint_handler, bg_int received\n");
-
-    patch_fn(opmgr_bgint_patchpoint);
-
-    /* Check that we have a valid context. If it's NULL then we've coded
-     * something badly. */
-    if (current_op == NULL)
-    {
-        panic_diatribe(PANIC_AUDIO_INVALID_OPERATOR_CONTEXT, (DIATRIBE_TYPE)((uintptr_t)bg_data));
-    }
-
     /* nothing to do if the operator is not in the running state*/
     if (OP_RUNNING != current_op->state)
     {
-        return;
+        return FALSE;
     }
 
 #if OPMGR_SYNC_KICKED_IMPLEMENTATION == OPMGR_SYNC_KICKED_BASIC
@@ -1055,7 +1088,7 @@ void opmgr_operator_bgint_handler(void **bg_data)
     if (current_op->processing_suspended)
     {
         current_op->processing_rerun_requested = TRUE;
-        return;
+        return FALSE;
     }
 #endif /* OPMGR_SYNC_KICKED_IMPLEMENTATION == OPMGR_SYNC_KICKED_BASIC */
 
@@ -1066,8 +1099,8 @@ void opmgr_operator_bgint_handler(void **bg_data)
     /* call the operator data processing function */
     /* The operator process_data handler will populate the bitfields in touched which indicate
      * which source/sink terminals to propagate kicks along.*/
-    touched.sources = TOUCHED_NOTHING;
-    touched.sinks = TOUCHED_NOTHING;
+    touched->sources = TOUCHED_NOTHING;
+    touched->sinks = TOUCHED_NOTHING;
 
 #ifdef PROFILER_ON
     if (current_op->profiler == NULL) 
@@ -1092,32 +1125,83 @@ void opmgr_operator_bgint_handler(void **bg_data)
 
     if (current_op->profiler != NULL)
     {
-        PROFILER_MEASURE(current_op->profiler, current_op->local_process_data(current_op, &touched)); 
+        PROFILER_MEASURE(current_op->profiler, current_op->local_process_data(current_op, touched)); 
     }
     else
 #endif /* PROFILER_ON */
     {
-        current_op->local_process_data(current_op, &touched);
+        current_op->local_process_data(current_op, touched);
     }
 
-    /* A quick check to see if there is anything to do. If there is no kick table
-     * or nothing was touched then there is no work to do.
-     */
-
-    /* NOTE: There might be a potential optimisation to be made here based on
-     * the fact that most capabilities only kick 1 operator up/down stream. All
-     * the loop setup could be avoided in these cases. The extra logic and some
-     * jumps may be avoidable.
-     */
-    if (touched.sources || touched.sinks)
-    {
 #ifdef PROFILER_ON
-       if ((touched.sources) && (current_op->profiler != NULL))
-       {
-            current_op->profiler->kick_inc++;
-       }
+    if ((touched->sources) && (current_op->profiler != NULL))
+    {
+        current_op->profiler->kick_inc++;
+    }
 #endif
-        opmgr_kick_from_operator(current_op,touched.sources,touched.sinks);
+    return TRUE;
+}
+
+/****************************************************************************
+ *
+ * opmgr_operator_bgint_handler
+ *
+ * Handler for all background interrupts raised on operators.
+ */
+RUN_FROM_PM_RAM
+void opmgr_operator_bgint_handler(void **bg_data)
+{
+    TOUCHED_TERMINALS touched;
+    OPERATOR_DATA* current_op = (OPERATOR_DATA*)*bg_data;
+    unsigned fused_count = 0;
+
+    PL_PRINT_P0(TR_OPMGR, "opmgr_operator_bgint_handler, bg_int received\n");
+
+    patch_fn(opmgr_bgint_patchpoint);
+
+    /* Check that we have a valid context. If it's NULL then we've coded
+     * something badly. */
+    if (current_op == NULL)
+    {
+        panic_diatribe(PANIC_AUDIO_INVALID_OPERATOR_CONTEXT, (DIATRIBE_TYPE)((uintptr_t)bg_data));
+    }
+
+    while (opmgr_run_operator(current_op, &touched))
+    {
+        /* If the operator downstream is fused to this one, run it next
+         * rather than raising a background interrupt for it. */
+        OPERATOR_DATA *next_op = current_op->fused_op;
+
+        if ((next_op != NULL) && ((touched.sources & current_op->fused_sources) != 0) &&
+            (fused_count < OPMGR_MAX_FUSED_OPS))
+        {
+            touched.sources &= ~current_op->fused_sources;
+            fused_count++;
+        }
+        else
+        {
+            next_op = NULL;
+        }
+
+        /* A quick check to see if there is anything to do. If there is no kick table
+         * or nothing was touched then there is no work to do.
+         */
+
+        /* NOTE: There might be a potential optimisation to be made here based on
+         * the fact that most capabilities only kick 1 operator up/down stream. All
+         * the loop setup could be avoided in these cases. The extra logic and some
+         * jumps may be avoidable.
+         */
+        if (touched.sources || touched.sinks)
+        {
+            opmgr_kick_from_operator(current_op,touched.sources,touched.sinks);
+        }
+
+        if (next_op == NULL)
+        {
+            break;
+        }
+        current_op = next_op;
     }
 }
 
@@ -1230,6 +1314,22 @@ bool opmgr_connect_buffer_to_endpoint(unsigned int endpoint_id, tCbuffer *Cbuffe
             }
             return FALSE;
         }
+
+        if (!get_is_sink_from_opidep(endpoint_id))
+        {
+            /* An operator source sharing an in-place buffer with the sink of
+             * another operator can run that operator directly. Any other source
+             * connection only needs the existing fusion checking. */
+            OPERATOR_DATA *cur_op = get_op_data_from_id(get_opid_from_opidep(endpoint_id));
+            OPERATOR_DATA *next_op = cur_op->fused_op;
+
+            if (((ep_id_to_kick & STREAM_EP_OP_BIT) != 0) &&
+                (Cbuffer_ptr != NULL) && BUF_DESC_IN_PLACE(Cbuffer_ptr->descriptor))
+            {
+                next_op = get_op_data_from_id(get_opid_from_opidep(ep_id_to_kick));
+            }
+            update_fused_op(cur_op, next_op);
+        }
     }
     return TRUE;
 }
@@ -158,8 +158,18 @@ struct OPERATOR_DATA
     /** Linked list of source terminals */
     ENDPOINT* source_terminals;
 
-    /** Some extra data needed by specific instance */
+    /** Some extra data needed by specific instance. Its offset is used by assembly
+     * and by downloadable capabilities, so new fields go after it. */
     void* extra_op_data;
+
+    /** Operator fused after this one. When the only thing downstream is a
+     * single operator of the same priority connected in place, it is run
+     * straight after this one instead of being kicked. NULL if not fused.
+     */
+    struct OPERATOR_DATA* fused_op;
+
+    /** Touched source terminals that lead to fused_op */
+    unsigned fused_sources;
 };
 
 #endif  /* OPMGR_OPERATOR_DATA_H */
@@ -100,6 +100,11 @@ Private Macro Declarations
 /* Maximum is 32, so that it fits in 5 bits in the connection id      */
 #define NUM_AGGREGATES      1
 
+/* The highest opid value allowed to be generated. It wraps to 1 after this.
+ * Currently this is 0x1fc0 >> 6 = 0x007F = 127.
+ */
+#define OPMGR_MAX_OPID_VALUE (STREAM_EP_OPID_MASK >> STREAM_EP_OPID_POSN)
+
 #if defined(SUPPORTS_MULTI_CORE)
 #define OPMGR_KIP_FREE_REQ_KEYS() opmgr_kip_free_req_keys()
 #else
@@ -220,6 +225,22 @@ extern void *opmgr_retrieve_in_progress_task(unsigned client_id, unsigned op_id)
  */
 extern OPERATOR_DATA* get_anycore_op_data_from_id(unsigned int id);
 
+/**
+ * \brief    Add the operator data to the head of an operator list
+ *
+ * \param    op_data  operator data, with its id set
+ * \param    op_list  the operator list
+ */
+extern void add_op_data_to_list(OPERATOR_DATA* op_data, OPERATOR_DATA** op_list);
+
+/**
+ * \brief    Take the operator data out of an operator list without freeing it
+ *
+ * \param    op_data  operator data
+ * \param    op_list  the operator list
+ */
+extern void unlink_op_data_from_list(OPERATOR_DATA* op_data, OPERATOR_DATA** op_list);
+
 /**
  * \brief    Remove the operator data from the operator list
  *
@@ -378,10 +378,10 @@ static void earbudHandover_Complete(const bool primary)
 /*! \brief Handover application's marshaling interface.
 
     \note Possible cases:
-    1. written is not incremented and return value is FALSE: this means buffer is insufficient.
-    2. written < buffer_size and return value is FALSE. This means buffer is insufficient.
-    3. written <= buffer_size and return value is TRUE. This mean marshaling is complete.
-    4. written is not incremented and return value is TRUE. This means marshaling not required.
+    1. written == buffer_size and return value is FALSE: the buffer is full, marshaling
+       continues (part way through the current object) in the next buffer.
+    2. written <= buffer_size and return value is TRUE. This mean marshaling is complete.
+    3. written is not incremented and return value is TRUE. This means marshaling not required.
 
     \param[in] addr address of handset.
     \param[in] buffer input buffer with data to be marshalled.
@@ -424,7 +424,10 @@ static bool earbudHandover_Marshal(const tp_bdaddr *addr, uint8 *buffer, uint16
         }
     }
 
-    MarshalSetBuffer(app_data->marshal.marshaller, buffer, buffer_size);
+    /* Stream the marshal data: when the buffer is full the current object is
+       continued in the next buffer, so every packet is filled completely and
+       no object is marshalled twice. */
+    MarshalSetStreamBuffer(app_data->marshal.marshaller, buffer, buffer_size);
     /* For all remaining registered interfaces. */
     while(marshalled && (app_data->curr_interface))
     {
@@ -439,8 +442,8 @@ static bool earbudHandover_Marshal(const tp_bdaddr *addr, uint8 *buffer, uint16
                 }
                 else
                 {
-                    /* Insufficient buffer for marshalling. */
-                    DEBUG_LOG_WARN("earbudHandover_Marshal - Insufficient buffer for type: %d!", *app_data->curr_type);
+                    /* Buffer full, the type continues in the next buffer. */
+                    EB_HANDOVER_DEBUG_VERBOSE_LOG("earbudHandover_Marshal - Buffer full during type: %d", *app_data->curr_type);
                     marshalled = FALSE;
                     break;
                 }
@@ -474,10 +477,9 @@ static bool earbudHandover_Marshal(const tp_bdaddr *addr, uint8 *buffer, uint16
 /*! \brief Handover application's unmarshaling interface.
 
     \note Possible cases,
-    1. consumed is not incremented and return value is FALSE. This means buffer is
-    insufficient to unmarshal.
-    2. consumed < buffer_size and return value is FALSE. Need more data from caller.
-    3. consumed == buffer_size and return value is TRUE. This means all data
+    1. consumed == buffer_size and return value is FALSE. The buffer ended part
+    way through an object, which is completed by the data in the next buffer.
+    2. consumed == buffer_size and return value is TRUE. This means all data
       unmarshalled successfully. There could still be more data with caller
       in which case this function is invoked again.
 
@@ -517,7 +519,8 @@ static bool earbudHandover_Unmarshal(const tp_bdaddr *addr, const uint8 *buffer,
         initializeUnmarshalDataList();
     }
 
-    UnmarshalSetBuffer(app_data->marshal.unmarshaller, buffer, buffer_size);
+    /* Objects may be split across buffers by the streaming marshaller */
+    UnmarshalSetStreamBuffer(app_data->marshal.unmarshaller, buffer, buffer_size);
 
     /* Loop until all types are extracted from buffer */
     while(unmarshalled && (*consumed < buffer_size))
@@ -544,8 +547,10 @@ static bool earbudHandover_Unmarshal(const tp_bdaddr *addr, const uint8 *buffer,
         }
         else
         {
-            /* No types found. Buffer has incomplete data, ask for remaining. */
-            DEBUG_LOG_WARN("earbudHandover_Unmarshal - Incomplete data for unmarshaling!");
+            /* Buffer ended part way through an object, the unmarshaller keeps
+               it until the remaining data is provided. */
+            EB_HANDOVER_DEBUG_VERBOSE_LOG("earbudHandover_Unmarshal - Object continues in next buffer");
+            *consumed = UnmarshalConsumed(app_data->marshal.unmarshaller);
             unmarshalled = FALSE;
         }
     }
@@ -98,6 +98,7 @@
 #include <bredr_scan_manager.h>
 #include <connection_manager.h>
 #include <device_list.h>
+#include <device_properties.h>
 #include <hfp_profile.h>
 #include <scofwd_profile.h>
 #include <handover_profile.h>
@@ -465,6 +466,11 @@ static bool appInitDeviceDbSerialiser(Task init_task)
 
     DeviceList_Init(appConfigMaxTrustedDevices());
 
+    /* Devices are looked up by address and type far more often than any
+       other property */
+    DeviceList_AddIndex(device_property_bdaddr);
+    DeviceList_AddIndex(device_property_type);
+
     DeviceDbSerialiser_Deserialise();
 
     return TRUE;
@@ -95,6 +95,14 @@ DEFINE_RULE(ruleNotifyOutCaseDFUAbort);
 DEFINE_RULE(ruleInEarCheckIncomingCall);
 /*! \} */
 
+/*! \{
+    Facts tested by several rules, evaluated at most once per pass. */
+DEFINE_RULE_FACT(factPeerInEar, StateProxy_IsPeerInEar);
+DEFINE_RULE_FACT(factPeerSigConnected, appPeerSigIsConnected);
+DEFINE_RULE_FACT(factHandsetConnected, appDeviceIsHandsetConnected);
+DEFINE_RULE_FACT(factPairedWithHandset, BtDevice_IsPairedWithHandset);
+/*! \} */
+
 /*! \brief Set of rules to run on Earbud startup. */
 const rule_entry_t primary_rules_set[] =
 {
@@ -273,7 +281,7 @@ static rule_action_t ruleAutoHandsetPair(void)
         return rule_action_ignore;
     }
 
-    if (BtDevice_IsPairedWithHandset())
+    if (RULE_FACT(factPairedWithHandset))
     {
         PRIMARY_RULE_LOG("ruleAutoHandsetPair, complete, already paired with handset");
         return rule_action_complete;
@@ -400,7 +408,7 @@ static rule_action_t ruleInEarA2dpRestart(void)
 */
 static rule_action_t ruleOutOfEarScoActive(void)
 {
-    if (PeerSco_IsActive() && StateProxy_IsPeerInEar())
+    if (PeerSco_IsActive() && RULE_FACT(factPeerInEar))
     {
         PRIMARY_RULE_LOG("ruleOutOfEarScoActive, ignore as we have peer sco running and peer is in ear");
         return rule_action_ignore;
@@ -459,7 +467,7 @@ static rule_action_t ruleInEarScoTransferToEarbud(void)
 
     /* For TWS+ transfer the audio the local earbud is in Ear.
      * For TWS Standard, transfer the audio if local earbud or peer is in Ear. */
-    if (appSmIsInEar() || (!appDeviceIsTwsPlusHandset(appHfpGetAgBdAddr()) && StateProxy_IsPeerInEar()))
+    if (appSmIsInEar() || (!appDeviceIsTwsPlusHandset(appHfpGetAgBdAddr()) && RULE_FACT(factPeerInEar)))
     {
         PRIMARY_RULE_LOG("ruleInEarScoTransferToEarbud, run as call is active and an earbud is in ear");
         return rule_action_run;
@@ -597,7 +605,7 @@ static rule_action_t ruleCheckUpgradable(void)
             PRIMARY_RULE_LOG("ruleCheckUpgradable, block as only allow DFU from UI (and in case)");
             return RULE_ACTION_RUN_PARAM(block_dfu);
         }
-        if (!appPeerSigIsConnected())
+        if (!RULE_FACT(factPeerSigConnected))
         {
             PRIMARY_RULE_LOG("ruleCheckUpgradable, block as peer not connected");
             return RULE_ACTION_RUN_PARAM(block_dfu);
@@ -612,7 +620,7 @@ static rule_action_t ruleCheckUpgradable(void)
             PRIMARY_RULE_LOG("ruleCheckUpgradable, allow as BLE connection");
             return RULE_ACTION_RUN_PARAM(allow_dfu);
         }
-        if (appDeviceIsHandsetConnected() && appConfigDfuAllowBredrUpgradeOutOfCase())
+        if (RULE_FACT(factHandsetConnected) && appConfigDfuAllowBredrUpgradeOutOfCase())
         {
             PRIMARY_RULE_LOG("ruleCheckUpgradable, allow as BREDR connection");
             return RULE_ACTION_RUN_PARAM(allow_dfu);
@@ -633,7 +641,7 @@ static rule_action_t ruleCheckUpgradable(void)
             PRIMARY_RULE_LOG("ruleCheckUpgradable, block as only allow DFU from UI");
             return RULE_ACTION_RUN_PARAM(block_dfu);
         }
-        if (!appPeerSigIsConnected())
+        if (!RULE_FACT(factPeerSigConnected))
         {
             PRIMARY_RULE_LOG("ruleCheckUpgradable, block as peer not connected");
             return RULE_ACTION_RUN_PARAM(block_dfu);
@@ -707,7 +715,7 @@ static rule_action_t ruleSelectMicrophone(void)
 {
     micSelection selected_mic = MIC_SELECTION_LOCAL;
 
-    if (!appSmIsInEar() && StateProxy_IsPeerInEar())
+    if (!appSmIsInEar() && RULE_FACT(factPeerInEar))
     {
         selected_mic = MIC_SELECTION_REMOTE;
         PRIMARY_RULE_LOG("ruleSelectMicrophone, SCOFWD master out of ear and slave in ear use remote microphone");
@@ -735,7 +743,7 @@ static rule_action_t rulePeerScoControl(void)
         return rule_action_ignore;
     }
 
-    if (!StateProxy_IsPeerInEar())
+    if (!RULE_FACT(factPeerInEar))
     {
 #ifdef ENABLE_DYNAMIC_HANDOVER
         /* For handover to succeed, if primary has active eSCO, the secondary must
@@ -752,7 +760,7 @@ static rule_action_t rulePeerScoControl(void)
         PRIMARY_RULE_LOG("rulePeerScoControl, run and disable as peer out of ear");
         return RULE_ACTION_RUN_PARAM(disabled);
     }
-    if (StateProxy_IsPeerInEar())
+    if (RULE_FACT(factPeerInEar))
     {
         PRIMARY_RULE_LOG("rulePeerScoControl, run and enable as peer in ear");
         return RULE_ACTION_RUN_PARAM(enabled);
@@ -767,7 +775,7 @@ static rule_action_t ruleSelectLocalAudioMix(void)
 {
     bool stereo_mix = TRUE;
 
-    if (appPeerSigIsConnected() && StateProxy_IsPeerInEar())
+    if (RULE_FACT(factPeerSigConnected) && RULE_FACT(factPeerInEar))
     {
         stereo_mix = FALSE;
     }
@@ -781,7 +789,7 @@ static rule_action_t ruleSelectRemoteAudioMix(void)
 {
     bool stereo_mix = TRUE;
 
-    if (appPeerSigIsConnected())
+    if (RULE_FACT(factPeerSigConnected))
     {
         if (appSmIsInEar())
         {
@@ -801,7 +809,7 @@ static rule_action_t ruleNotifyPeerMruHandset(void)
 {
     rule_action_t action = rule_action_ignore;
 
-    if (appPeerSigIsConnected() && BtDevice_IsPairedWithHandset())
+    if (RULE_FACT(factPeerSigConnected) && RULE_FACT(factPairedWithHandset))
     {
         action = rule_action_run;
     }
@@ -68,6 +68,11 @@ DEFINE_RULE(ruleInCaseAncTuning);
 
 /*! \} */
 
+/*! \{
+    Facts tested by several rules, evaluated at most once per pass. */
+DEFINE_RULE_FACT(factPeerSigConnected, appPeerSigIsConnected);
+/*! \} */
+
 /*! \brief Set of rules to run on Earbud startup. */
 const rule_entry_t secondary_rules_set[] =
 {
@@ -110,7 +115,7 @@ static rule_action_t ruleOutOfCasePeerSignallingConnect(void)
 {
     SECONDARY_RULE_LOG("ruleOutOfCasePeerSignallingConnect, run as out of case");
 
-    if (!appPeerSigIsConnected())
+    if (!RULE_FACT(factPeerSigConnected))
     {
         return /*rule_action_run*/rule_action_ignore;
     }
@@ -130,7 +135,7 @@ static rule_action_t ruleCheckUpgradable(void)
             SECONDARY_RULE_LOG("ruleCheckUpgradable, block as only allow DFU from UI (and in case)");
             return RULE_ACTION_RUN_PARAM(block_dfu);
         }
-        if (appPeerSigIsConnected() && 
+        if (RULE_FACT(factPeerSigConnected) && 
             (appConfigDfuAllowBredrUpgradeOutOfCase() || appConfigDfuAllowBleUpgradeOutOfCase()))
         {
             SECONDARY_RULE_LOG("ruleCheckUpgradable, allow as out of case permitted");
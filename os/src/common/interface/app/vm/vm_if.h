@@ -401,6 +401,23 @@ typedef enum
     VM_PERFORMANCE
 } vm_runtime_profile;
 
+/*!
+    @brief Usage statistics for one memory pool. Used in
+    VmGetMemoryPoolStatistics()
+*/
+typedef struct
+{
+    uint16 size;          /*!< Size of the blocks in the pool, in bytes */
+    uint16 blocks;        /*!< Total number of blocks in the pool */
+    uint16 allocated;     /*!< Number of blocks currently allocated */
+    uint16 max_allocated; /*!< Most blocks allocated at once since the
+                               statistics were last reset */
+    uint16 fallbacks;     /*!< Allocations that would ideally have come from
+                               this pool but were served by a larger pool */
+    uint16 failures;      /*!< Allocations that would ideally have come from
+                               this pool but could not be served */
+} vm_memory_pool_statistics;
+
 /*!
     @brief Component IDs. Used in VmGetFwVersion()
 */
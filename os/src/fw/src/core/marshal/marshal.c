@@ -45,6 +45,22 @@ typedef struct marshal_context
     /** Remaining bytes to be marshalled for current object */
     size_t remaining;
 
+    /** Streaming: bytes of the object being marshalled that were written to
+     *  previous buffers. Marshalling of the object resumes after these bytes.
+     */
+    size_t resume;
+
+    /** Streaming: bytes still to be skipped before writing resumes */
+    size_t skip;
+
+    /** Streaming: bytes of the object being marshalled written so far
+     *  (including those written to previous buffers) */
+    size_t object_bytes;
+
+    /** Set by \c marshal_set_stream_buffer. Objects are split across buffers
+     *  rather than being backed up and restored when the buffer is full */
+    bool stream;
+
     /** The current marshalling state */
     enum marshal_state state;
 
@@ -73,10 +89,26 @@ marshal_context_t *marshal_init(const marshal_type_descriptor_t * const *type_de
 void marshal_set_buffer(marshal_context_t *m, void *buf, size_t space)
 {
     assert(m);
+    /* Can't switch from streaming part way through an object */
+    assert(!m->resume);
 
     m->buf = buf;
     m->size = space;
     m->index = 0;
+    m->stream = FALSE;
+}
+
+void marshal_set_stream_buffer(marshal_context_t *m, void *buf, size_t space)
+{
+    assert(m);
+    assert(buf);
+
+    base_stream_init(&m->base);
+
+    m->buf = buf;
+    m->size = space;
+    m->index = 0;
+    m->stream = TRUE;
 }
 
 void marshal_destroy(marshal_context_t *m, bool free_all_objects)
@@ -92,22 +124,63 @@ void marshal_clear_store(marshaller_t m)
     base_clear_store(&m->base);
     m->next_values_index = MOB_INDEX_NULL+1;
     m->next_pointers_index = MOB_INDEX_NULL+1;
+    m->resume = 0;
 }
 
 static inline void marshal_backup(marshal_context_t *m)
 {
     m->backup_index = m->index;
+    m->skip = m->object_bytes = m->resume;
 }
 
 static inline void marshal_restore(marshal_context_t *m)
 {
-    m->index = m->backup_index;
+    if (m->stream)
+    {
+        /* Keep what was written, the object is resumed in the next buffer */
+        m->resume = m->object_bytes;
+    }
+    else
+    {
+        m->index = m->backup_index;
+    }
+}
+
+static inline void marshal_complete(marshal_context_t *m)
+{
+    m->resume = 0;
+}
+
+/* Skip the bytes already written to previous buffers, then write as much as
+   fits in the buffer. Returns TRUE when all the bytes have been written. */
+static bool write_stream(marshal_context_t *m, const uint8 *src, size_t size)
+{
+    size_t n;
+
+    if (m->skip >= size)
+    {
+        m->skip -= size;
+        return TRUE;
+    }
+    src += m->skip;
+    size -= m->skip;
+    m->skip = 0;
+
+    n = MIN(size, m->size - m->index);
+    memcpy(m->buf + m->index, src, n);
+    m->index += n;
+    m->object_bytes += n;
+    return (n == size);
 }
 
 static bool write(marshal_base_t *base, const void *object, size_t sizeof_object)
 {
     marshal_context_t *m = STRUCT_FROM_MEMBER(marshal_context_t, base, base);
 
+    if (m->stream)
+    {
+        return write_stream(m, object, sizeof_object);
+    }
     if (m->buf)
     {
         size_t next_index;
@@ -159,6 +232,29 @@ static bool write_value(marshal_base_t *base, mob_t *leaf)
 {
     marshal_context_t *m = STRUCT_FROM_MEMBER(marshal_context_t, base, base);
     const marshal_type_descriptor_t *type_desc = base->type_desc_list[leaf->type];
+    marshal_custom_copy_cb copy_cb = memcpy;
+    const marshal_custom_copy_cbs *cbs = type_desc->u.custom_copy_cbs;
+
+    if (cbs && cbs->marshal_copy)
+    {
+        copy_cb = cbs->marshal_copy;
+    }
+
+    if (m->stream && (copy_cb != memcpy) &&
+        (m->skip || (m->index + type_desc->size > m->size)))
+    {
+        /* The value is split across buffers, copy it to the scratch and
+           write the part that is due from there */
+        if (m->skip < type_desc->size)
+        {
+            (void)copy_cb(base->scratch, leaf->address, type_desc->size);
+        }
+        return write_stream(m, base->scratch, type_desc->size);
+    }
+    if (m->stream && (copy_cb == memcpy))
+    {
+        return write_stream(m, leaf->address, type_desc->size);
+    }
 
     if (m->buf)
     {
@@ -166,16 +262,12 @@ static bool write_value(marshal_base_t *base, mob_t *leaf)
         next_index = m->index + type_desc->size;
         if (next_index <= m->size)
         {
-            marshal_custom_copy_cb copy_cb = memcpy;
-            const marshal_custom_copy_cbs *cbs = type_desc->u.custom_copy_cbs;
-
-            if (cbs && cbs->marshal_copy)
-            {
-                copy_cb = cbs->marshal_copy;
-            }
-
             (void)copy_cb(m->buf + m->index, leaf->address, type_desc->size);
             m->index = next_index;
+            if (m->stream)
+            {
+                m->object_bytes += type_desc->size;
+            }
             return TRUE;
         }
     }
@@ -225,6 +317,7 @@ static bool marshal_pointer_indexes(mobs_t *set, mob_index_t index, mob_t *objec
     {
         assert(index < MOBS_MAX_OBJECTS);
         m->next_pointers_index = (mob_index_t)(index + 1);
+        marshal_complete(m);
         return TRUE;
     }
     marshal_restore(m);
@@ -254,6 +347,7 @@ static bool marshal_values(mobs_t *set, mob_index_t index, mob_t *object)
             {
                 assert(index < MOBS_MAX_OBJECTS);
                 m->next_values_index = (mob_index_t)(index + 1);
+                marshal_complete(m);
                 return TRUE;
             }
         }
@@ -437,7 +531,8 @@ size_t marshal_remaining(marshaller_t m)
             assert(mobs_iterate(set, m->next_pointers_index, count_remaining_indexes));
         break;
     }
-    return m->remaining;
+    /* Discount the part of the current object already streamed */
+    return m->remaining - m->resume;
 }
 
 #endif /* INSTALL_MARSHAL */
@@ -238,10 +238,11 @@ Dynamic
 -------
 The main memory usage by the marshaller/unmarshaller is the storage of
 object address/type in the object sets. The \c mobs_t stores objects
-in a linked-list where each node in the list stores a block of
-objects (\c mob_block_t) (to minimise overhead of list next pointer). The
+in blocks of objects (\c mob_block_t) referenced from a table of block
+pointers, so an object is found by index without walking the blocks. The
 number of objects in each block is configurable through the #BLOCK_SIZE
-definition.
+definition. Sets larger than #MOBS_HASH_MIN_ELEMENTS also keep a hash of
+object address to index (at most 2 bytes per object).
 
 Const
 -----
@@ -285,6 +286,23 @@ marshaller_t marshal_init(const marshal_type_descriptor_t * const *type_desc_lis
  */
 void marshal_set_buffer(marshaller_t m, void *buf, size_t space);
 
+/** Set the next buffer of a marshaling byte stream.
+ *  \param m Handle for the marshaller.
+ *  \param buf Address to which the marshaller will write the next part of the
+ *         marshalled byte stream. Must not be NULL.
+ *  \param space The number of bytes space in the buffer.
+ *  \note Unlike \c marshal_set_buffer, objects are not backed up when the
+ *        buffer is full: \c marshal fills the buffer completely and resumes
+ *        part way through the object when the next buffer is set. The
+ *        concatenated buffers form the same byte stream as marshalling to a
+ *        single buffer, so the stream may be transmitted in fixed size chunks
+ *        (e.g. straight from a Sink) as it is produced. The stream must be
+ *        unmarshalled with \c unmarshal_set_stream_buffer.
+ *  \note Only the values of leaf types with custom copy callbacks are staged
+ *        in scratch memory, which is bounded by the largest such type.
+ */
+void marshal_set_stream_buffer(marshaller_t m, void *buf, size_t space);
+
 /** Marshal a object hierarchy.
  *  \param m Handle for the marshaller.
  *  \param addr The address of the head object in the hierarchy.
@@ -367,6 +385,17 @@ unmarshaller_t unmarshal_init(const marshal_type_descriptor_t * const *type_desc
  */
 void unmarshal_set_buffer(unmarshaller_t u, const void *buf, size_t data_size);
 
+/** Set the next buffer of a marshalled byte stream.
+ *  \param u Handle for the unmarshaller.
+ *  \param buf Address from where the unmarshaller will read the next part of
+ *             the marshalled byte stream.
+ *  \param data_size The number of data bytes in the buffer.
+ *  \note Unlike \c unmarshal_set_buffer, objects may be split across buffers.
+ *        \c unmarshal consumes all the data in the buffer, keeping any
+ *        incomplete object until the rest of it is provided in the next buffer.
+ */
+void unmarshal_set_stream_buffer(unmarshaller_t u, const void *buf, size_t data_size);
+
 /** Unmarshal a marshalled byte stream.
  *  \param u Handle for the unmarshaller.
  *  \param addr The function will set addr to the address of the allocated object
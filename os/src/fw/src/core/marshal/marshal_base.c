@@ -38,9 +38,12 @@ static void base_initialise_type_filters(marshal_base_t *base)
             if (member_desc->is_shared)
             {
                 base->has_shared_objects = TRUE;
-                return;
             }
         }
+        if (!type_desc->members_len && type_desc->u.custom_copy_cbs)
+        {
+            base->scratch_size = MAX(base->scratch_size, type_desc->size);
+        }
     }
 }
 
@@ -72,14 +75,25 @@ void base_uninit(marshal_base_t *base, bool free_all_objects)
     }
     mobs_destroy(&base->object_set);
     mobs_destroy(&base->shared_member_set);
+    pfree(base->scratch);
+    base->scratch = NULL;
 }
 
 void base_clear_store(marshal_base_t *base)
 {
-    base_uninit(base, FALSE);
+    mobs_destroy(&base->object_set);
+    mobs_destroy(&base->shared_member_set);
     base_mobs_init(base);
 }
 
+void base_stream_init(marshal_base_t *base)
+{
+    if (base->scratch_size && !base->scratch)
+    {
+        base->scratch = pmalloc(base->scratch_size);
+    }
+}
+
 static bool register_shared_member(marshal_base_t *base, mob_t *shared)
 {
     assert(mobs_push(&base->shared_member_set, shared));
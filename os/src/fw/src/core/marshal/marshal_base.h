@@ -46,6 +46,13 @@ typedef struct marshal_base
         shared objects */
     unsigned has_shared_objects : 1;
 
+    /** Size of the largest leaf type with custom copy callbacks. */
+    uint8 scratch_size;
+
+    /** Staging for values of custom copied types which are split across
+        stream buffers. Allocated when a stream buffer is first set. */
+    uint8 *scratch;
+
 } marshal_base_t;
 
 /** Callback function from object_tree_traverse for indicating members.
@@ -114,6 +121,12 @@ void base_uninit(marshal_base_t *base, bool free_all_objects);
  */
 void base_clear_store(marshal_base_t *base);
 
+/** Prepare the base for streaming, allocating the scratch used to stage
+ *  values of custom copied types split across stream buffers.
+ *  \param base The base.
+ */
+void base_stream_init(marshal_base_t *base);
+
 /** Traverse objects in the tree/hierarchy of the object.
  *  \param base The base.
  *  \param object The object at which to start the traverse.
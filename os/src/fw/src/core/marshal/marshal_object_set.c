@@ -14,33 +14,153 @@
  *  of available pools. */
 #define BLOCK_SIZE 4
 
+/** Maximum number of blocks required to store MOBS_MAX_OBJECTS */
+#define MOBS_MAX_BLOCKS ((MOBS_MAX_OBJECTS + BLOCK_SIZE - 1) / BLOCK_SIZE)
+
+/** Initial number of entries in the table of block pointers */
+#define MOBS_MIN_BLOCKS 4
+
+/** Sets with more than this number of objects keep an address hash. Smaller
+ *  sets (e.g. the traversal stack) are cheaper to search linearly. */
+#define MOBS_HASH_MIN_ELEMENTS 16
+
+/** The hash is kept at most half full, so an empty slot terminates a probe
+ *  quickly. Multiplier for Fibonacci hashing of the address. */
+#define MOBS_HASH_MULTIPLIER 2654435761u
+
 struct marshal_object_block
 {
-    struct marshal_object_block *next;
     void *address[BLOCK_SIZE];
     marshal_type_t type[BLOCK_SIZE];
     uint8 disambiguator[BLOCK_SIZE];
 };
 
+/* The block storing the object at index */
+#define MOBS_BLOCK(set, index) ((set)->blocks[(index) / BLOCK_SIZE])
+
+static void *mobs_address(const mobs_t *set, mob_index_t index)
+{
+    return MOBS_BLOCK(set, index)->address[index % BLOCK_SIZE];
+}
+
+static uint32 mobs_hash_slot(const mobs_t *set, const void *address)
+{
+    /* Use the top bits of the product, so the alignment of the address does
+       not leave slots unused */
+    return ((uint32)address * MOBS_HASH_MULTIPLIER) >> (32 - set->hash_bits);
+}
+
+static void mobs_hash_insert(mobs_t *set, mob_index_t index)
+{
+    uint32 mask = (1UL << set->hash_bits) - 1;
+    uint32 slot = mobs_hash_slot(set, mobs_address(set, index));
+
+    while (set->hash[slot])
+    {
+        slot = (slot + 1) & mask;
+    }
+    set->hash[slot] = (mob_index_t)(index + 1);
+}
+
+/* Remove index from the hash, moving later entries of the probe sequence
+   back into the hole so that searches need no tombstones */
+static void mobs_hash_delete(mobs_t *set, mob_index_t index)
+{
+    uint32 mask = (1UL << set->hash_bits) - 1;
+    uint32 hole = mobs_hash_slot(set, mobs_address(set, index));
+    uint32 slot;
+
+    while (set->hash[hole] != (mob_index_t)(index + 1))
+    {
+        assert(set->hash[hole]);
+        hole = (hole + 1) & mask;
+    }
+
+    for (slot = (hole + 1) & mask; set->hash[slot]; slot = (slot + 1) & mask)
+    {
+        uint32 home = mobs_hash_slot(set, mobs_address(set, set->hash[slot] - 1));
+
+        /* Leave the entry if its home lies cyclically in (hole, slot] */
+        if ((hole <= slot) ? (hole < home && home <= slot)
+                           : (hole < home || home <= slot))
+        {
+            continue;
+        }
+        set->hash[hole] = set->hash[slot];
+        hole = slot;
+    }
+    set->hash[hole] = 0;
+}
+
+/* (Re)build the hash with 2^bits slots, inserting objects in index order so
+   that objects sharing an address are found lowest index first */
+static void mobs_hash_rebuild(mobs_t *set, uint8 bits)
+{
+    mob_index_t index;
+
+    pfree(set->hash);
+    set->hash_bits = bits;
+    set->hash = zpmalloc(sizeof(*set->hash) << bits);
+
+    for (index = 0; index < set->elements; index++)
+    {
+        mobs_hash_insert(set, index);
+    }
+}
+
+static void mobs_hash_free(mobs_t *set)
+{
+    pfree(set->hash);
+    set->hash = NULL;
+    set->hash_bits = 0;
+}
+
+/* Account for the object just pushed at the tail of the set */
+static void mobs_hash_pushed(mobs_t *set)
+{
+    if (set->hash)
+    {
+        if ((uint32)set->elements * 2 > (1UL << set->hash_bits))
+        {
+            mobs_hash_rebuild(set, (uint8)(set->hash_bits + 1));
+        }
+        else
+        {
+            mobs_hash_insert(set, (mob_index_t)(set->elements - 1));
+        }
+    }
+    else if (set->elements > MOBS_HASH_MIN_ELEMENTS)
+    {
+        uint8 bits = 1;
+        while ((1UL << bits) < (uint32)set->elements * 2)
+        {
+            bits++;
+        }
+        mobs_hash_rebuild(set, bits);
+    }
+}
+
 void mobs_init(mobs_t *set)
 {
-    set->head = NULL;
-    set->tail = NULL;
+    set->blocks = NULL;
+    set->hash = NULL;
     set->elements = 0;
+    set->blocks_size = 0;
+    set->hash_bits = 0;
 }
 
 void mobs_destroy(mobs_t *set)
 {
-    mob_block_t *block;
-    mob_block_t *next;
-    for (block = set->head; block; block = next)
+    uint32 block;
+    uint32 blocks = (set->elements + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    for (block = 0; block < blocks; block++)
     {
-        next = block->next;
-        pfree(block);
+        pfree(set->blocks[block]);
     }
-    set->head = NULL;
-    set->tail = NULL;
-    set->elements = 0;
+    pfree(set->blocks);
+    mobs_hash_free(set);
+    mobs_init(set);
 }
 
 mob_index_t mobs_size(mobs_t *set)
@@ -56,25 +176,27 @@ bool mobs_push(mobs_t *set, mob_t *object)
     /* No duplicates */
     if (!mobs_has_object(set, object, NULL))
     {
-        mob_block_t *tail = set->tail;
+        mob_block_t *tail;
         mob_index_t index = set->elements % BLOCK_SIZE;
+        uint32 block = set->elements / BLOCK_SIZE;
         if (index == 0)
         {
-            tail = zpmalloc(sizeof(*tail));
-            if (!set->head)
+            if (block == set->blocks_size)
             {
-                set->head = set->tail = tail;
-            }
-            else
-            {
-                set->tail = set->tail->next = tail;
+                uint32 size = set->blocks_size ? set->blocks_size * 2 : MOBS_MIN_BLOCKS;
+                set->blocks_size = (uint8)MIN(size, MOBS_MAX_BLOCKS);
+                set->blocks = prealloc(set->blocks,
+                                       set->blocks_size * sizeof(*set->blocks));
             }
+            set->blocks[block] = zpnew(mob_block_t);
         }
+        tail = set->blocks[block];
         tail->address[index] = object->address;
         tail->type[index] = object->type;
         tail->disambiguator[index] = object->disambiguator;
 
         set->elements++;
+        mobs_hash_pushed(set);
         return TRUE;
     }
     return FALSE;
@@ -82,11 +204,12 @@ bool mobs_push(mobs_t *set, mob_t *object)
 
 bool mobs_pop(mobs_t *set, mob_t *object)
 {
-    mob_block_t *tail = set->tail;
-    mob_index_t index = (set->elements - 1) % BLOCK_SIZE;
-
     if (set->elements)
     {
+        mob_index_t last = (mob_index_t)(set->elements - 1);
+        mob_index_t index = last % BLOCK_SIZE;
+        mob_block_t *tail = MOBS_BLOCK(set, last);
+
         if (object)
         {
             object->address = tail->address[index];
@@ -94,22 +217,15 @@ bool mobs_pop(mobs_t *set, mob_t *object)
             object->disambiguator = tail->disambiguator[index];
         }
 
+        if (set->hash)
+        {
+            mobs_hash_delete(set, last);
+        }
+
         if (index == 0)
         {
-            if (set->head == tail)
-            {
-                pfree(tail);
-                set->head = set->tail = NULL;
-            }
-            else
-            {
-                mob_block_t **b;
-                for (b = &set->head; (*b)->next != tail; b = &(*b)->next)
-                    ;
-                pfree((*b)->next);
-                (*b)->next = NULL;
-                set->tail = *b;
-            }
+            pfree(tail);
+            MOBS_BLOCK(set, last) = NULL;
         }
         --set->elements;
         return TRUE;
@@ -119,57 +235,47 @@ bool mobs_pop(mobs_t *set, mob_t *object)
 
 /* A consequence of using blocks (versus a single element list) is inefficient
    object removal, since elements after the removed have to be 'shunted' into
-   the place of the removed element */
+   the place of the removed element. Since the indexes of the shunted objects
+   change, the hash is rebuilt. */
 bool mobs_remove(mobs_t *set, const mob_t *object)
 {
     mob_index_t index;
-    mob_block_t *b = set->head;
-
-    /* Two element pipeline of values for shunting across blocks boundaries */
-    void **addr0 = b->address;
-    void **addr1;
-    marshal_type_t *type0 = b->type;
-    marshal_type_t *type1;
-    uint8 *disam0 = b->disambiguator;
-    uint8 *disam1;
-
-    bool shunt = FALSE;
 
     for (index = 0; index < set->elements; index++)
     {
+        mob_block_t *b = MOBS_BLOCK(set, index);
         mob_index_t block_index = index % BLOCK_SIZE;
 
-        if (!block_index)
+        if ((b->address[block_index] == object->address) &&
+            (b->type[block_index] == object->type))
         {
-            if (index)
-            {
-                b = b->next;
-                assert(b);
-            }
+            break;
         }
-        /* Pass addresses down the pipeline */
-        addr1 = addr0;
-        type1 = type0;
-        disam1 = disam0;
-        addr0 = b->address + block_index;
-        type0 = b->type + block_index;
-        disam0 = b->disambiguator + block_index;
-
-        if (shunt)
+    }
+
+    if (index < set->elements)
+    {
+        uint8 bits = set->hash_bits;
+
+        mobs_hash_free(set);
+
+        for (index++; index < set->elements; index++)
         {
-            /* Overwrite previous index's values with this index's values */
-            *addr1 = *addr0;
-            *type1 = *type0;
-            *disam1 = *disam0;
+            mob_block_t *from = MOBS_BLOCK(set, index);
+            mob_block_t *to = MOBS_BLOCK(set, index - 1);
+            mob_index_t from_index = index % BLOCK_SIZE;
+            mob_index_t to_index = (index - 1) % BLOCK_SIZE;
+
+            to->address[to_index] = from->address[from_index];
+            to->type[to_index] = from->type[from_index];
+            to->disambiguator[to_index] = from->disambiguator[from_index];
         }
-        else if ((*addr0 == object->address) && (*type0 == object->type))
+        assert(mobs_pop(set, NULL));
+
+        if (bits)
         {
-            shunt = TRUE;
+            mobs_hash_rebuild(set, bits);
         }
-    }
-    if (shunt)
-    {
-        assert(mobs_pop(set, NULL));
         return TRUE;
     }
     return FALSE;
@@ -178,10 +284,10 @@ bool mobs_remove(mobs_t *set, const mob_t *object)
 void mobs_difference_update(mobs_t *set, const mobs_t *remove)
 {
     mob_index_t index;
-    mob_block_t *b = remove->head;
 
     for (index = 0; index < remove->elements; index++)
     {
+        mob_block_t *b = MOBS_BLOCK(remove, index);
         mob_index_t block_index = index % BLOCK_SIZE;
         mob_t object;
 
@@ -189,27 +295,30 @@ void mobs_difference_update(mobs_t *set, const mobs_t *remove)
         object.type = b->type[block_index];
         /* Don't care if object was actually removed */
         (void)mobs_remove(set, &object);
-
-        if (block_index == (BLOCK_SIZE - 1))
-        {
-            b = b->next;
-        }
     }
 }
 
-bool mobs_has_object(mobs_t *set, const mob_t *object, mob_index_t *index_p)
+/* Does the object at index match object? A NULL address matches all types */
+static bool mobs_matches(mobs_t *set, mob_index_t index, const mob_t *object)
 {
-    mob_index_t index;
-    mob_block_t *b = set->head;
+    mob_block_t *b = MOBS_BLOCK(set, index);
+    mob_index_t block_index = index % BLOCK_SIZE;
 
-    for (index = 0; index < set->elements; index++)
+    return (object->address == b->address[block_index]) &&
+           ((b->type[block_index] == object->type) || (object->address == NULL));
+}
+
+bool mobs_has_object(mobs_t *set, const mob_t *object, mob_index_t *index_p)
+{
+    if (set->hash)
     {
-        mob_index_t block_index = index % BLOCK_SIZE;
+        uint32 mask = (1UL << set->hash_bits) - 1;
+        uint32 slot = mobs_hash_slot(set, object->address);
 
-        if (object->address == b->address[block_index])
+        for ( ; set->hash[slot]; slot = (slot + 1) & mask)
         {
-            /* NULL address matches all types */
-            if ((b->type[block_index] == object->type) || (object->address == NULL))
+            mob_index_t index = (mob_index_t)(set->hash[slot] - 1);
+            if (mobs_matches(set, index, object))
             {
                 if (index_p)
                 {
@@ -218,35 +327,33 @@ bool mobs_has_object(mobs_t *set, const mob_t *object, mob_index_t *index_p)
                 return TRUE;
             }
         }
+    }
+    else
+    {
+        mob_index_t index;
 
-        if (block_index == (BLOCK_SIZE - 1))
+        for (index = 0; index < set->elements; index++)
         {
-            b = b->next;
+            if (mobs_matches(set, index, object))
+            {
+                if (index_p)
+                {
+                    *index_p = index;
+                }
+                return TRUE;
+            }
         }
     }
     return FALSE;
 }
 
-static mob_block_t *get_block(mobs_t *set, mob_index_t index)
-{
-    mob_block_t *b = NULL;
-
-    if (index < set->elements)
-    {
-        uint32 steps = index / BLOCK_SIZE;
-        for (b = set->head; b && steps; b = b->next, --steps)
-            ;
-    }
-    return b;
-}
-
 bool mobs_get_object(mobs_t *set, mob_index_t index, mob_t *object)
 {
-    mob_block_t *b = get_block(set, index);
-    if (b)
+    if (index < set->elements)
     {
         if (object)
         {
+            mob_block_t *b = MOBS_BLOCK(set, index);
             mob_index_t block_index = index % BLOCK_SIZE;
             object->address = b->address[block_index];
             object->type = b->type[block_index];
@@ -259,27 +366,21 @@ bool mobs_get_object(mobs_t *set, mob_index_t index, mob_t *object)
 
 bool mobs_iterate(mobs_t *set, mob_index_t start, mobs_callback_t cb)
 {
-    mob_block_t *b = get_block(set, start);
-    if (b)
+    /* The set may grow during the iteration, so the block table may be
+       reallocated by the callback: look blocks up on each step */
+    for ( ; start < set->elements; start++)
     {
-        for ( ; start < set->elements; start++)
-        {
-            mob_t object;
-            mob_index_t block_index = start % BLOCK_SIZE;
-
-            object.address = b->address[block_index];
-            object.type = b->type[block_index];
-            object.disambiguator = b->disambiguator[block_index];
+        mob_t object;
+        mob_block_t *b = MOBS_BLOCK(set, start);
+        mob_index_t block_index = start % BLOCK_SIZE;
 
-            if (!cb(set, start, &object))
-            {
-                return FALSE;
-            }
+        object.address = b->address[block_index];
+        object.type = b->type[block_index];
+        object.disambiguator = b->disambiguator[block_index];
 
-            if (block_index == (BLOCK_SIZE - 1))
-            {
-                b = b->next;
-            }
+        if (!cb(set, start, &object))
+        {
+            return FALSE;
         }
     }
     return TRUE;
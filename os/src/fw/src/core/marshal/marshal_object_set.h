@@ -45,14 +45,23 @@ typedef uint8 mob_index_t;
 /** Opaque forward declaration of object block used in the object set */
 typedef struct marshal_object_block mob_block_t;
 
-/** The marshal object set stores unique marshal objects in a linked list of
- *  marshal object blocks.
+/** The marshal object set stores unique marshal objects in marshal object
+ *  blocks, found directly by index through a table of block pointers.
+ *  Once the set grows beyond a few blocks, an open-addressed hash of object
+ *  address to index is maintained so that lookups do not scan the set.
  */
 typedef struct marshal_object_set
 {
-    mob_block_t *head;
-    mob_block_t *tail;
+    /** Table of pointers to the blocks, in index order */
+    mob_block_t **blocks;
+    /** Hash of object address to (index + 1), zero marks an empty slot.
+        NULL while the set is small enough to search linearly. */
+    mob_index_t *hash;
     mob_index_t elements;
+    /** Number of entries allocated in the blocks table */
+    uint8 blocks_size;
+    /** The hash has (1 << hash_bits) slots */
+    uint8 hash_bits;
 } mobs_t;
 
 /** Type definition of the callback function from the mobs_iterate function.
@@ -45,6 +45,30 @@ typedef struct unmarshal_context
     /** Index of next object to have its pointers unmarshalled. */
     mob_index_t next_index;
 
+    /** Streaming: the object whose values are being unmarshalled, its address
+     *  is NULL until the object is allocated */
+    mob_t object;
+
+    /** Streaming: the type of \c object has been read, its disambiguator
+     *  has not */
+    bool object_typed;
+
+    /** Streaming: bytes of the object being unmarshalled that were read from
+     *  previous buffers. Unmarshalling of the object resumes after these bytes.
+     */
+    size_t resume;
+
+    /** Streaming: bytes still to be skipped before reading resumes */
+    size_t skip;
+
+    /** Streaming: bytes of the object being unmarshalled read so far
+     *  (including those read from previous buffers) */
+    size_t object_bytes;
+
+    /** Set by \c unmarshal_set_stream_buffer. Objects may be split across
+     *  buffers, all the data in each buffer is consumed */
+    bool stream;
+
 } unmarshal_context_t;
 
 unmarshal_context_t *unmarshal_init(const marshal_type_descriptor_t * const *type_desc_list,
@@ -67,14 +91,41 @@ void unmarshal_set_buffer(unmarshal_context_t *u, const void *buf, size_t data)
     assert(u);
     assert(buf);
 
+    /* Can't switch from streaming part way through an object */
+    assert(!u->resume && !u->object.address && !u->object_typed);
+
+    u->buf = buf;
+    u->size = data;
+    u->outdex = 0;
+    u->stream = FALSE;
+}
+
+void unmarshal_set_stream_buffer(unmarshal_context_t *u, const void *buf, size_t data)
+{
+    assert(u);
+    assert(buf);
+
+    base_stream_init(&u->base);
+
     u->buf = buf;
     u->size = data;
     u->outdex = 0;
+    u->stream = TRUE;
+}
+
+/* Free the partially unmarshalled streaming object */
+static void unmarshal_stream_reset(unmarshal_context_t *u)
+{
+    pfree(u->object.address);
+    u->object.address = NULL;
+    u->object_typed = FALSE;
+    u->resume = 0;
 }
 
 void unmarshal_destroy(unmarshal_context_t *u, bool free_all_objects)
 {
     assert(u);
+    unmarshal_stream_reset(u);
     base_uninit(&u->base, free_all_objects);
     pfree(u);
 }
@@ -82,6 +133,7 @@ void unmarshal_destroy(unmarshal_context_t *u, bool free_all_objects)
 void unmarshal_clear_store(unmarshaller_t u)
 {
     assert(u);
+    unmarshal_stream_reset(u);
     base_clear_store(&u->base);
     u->next_index = MOB_INDEX_NULL+1;
     u->root_index = MOB_INDEX_NULL+1;
@@ -90,11 +142,42 @@ void unmarshal_clear_store(unmarshaller_t u)
 static inline void unmarshal_backup(unmarshal_context_t *u)
 {
     u->backup_outdex = u->outdex;
+    u->skip = u->object_bytes = u->resume;
 }
 
 static inline void unmarshal_restore(unmarshal_context_t *u)
 {
-    u->outdex = u->backup_outdex;
+    if (u->stream)
+    {
+        /* Keep what was read, the object is resumed in the next buffer */
+        u->resume = u->object_bytes;
+    }
+    else
+    {
+        u->outdex = u->backup_outdex;
+    }
+}
+
+/* Skip the bytes already read from previous buffers, then read as much as is
+   available in the buffer. Returns TRUE when all the bytes have been read. */
+static bool read_stream(unmarshal_context_t *u, uint8 *dest, size_t size)
+{
+    size_t n;
+
+    if (u->skip >= size)
+    {
+        u->skip -= size;
+        return TRUE;
+    }
+    dest += u->skip;
+    size -= u->skip;
+    u->skip = 0;
+
+    n = MIN(size, u->size - u->outdex);
+    memcpy(dest, u->buf + u->outdex, n);
+    u->outdex += n;
+    u->object_bytes += n;
+    return (n == size);
 }
 
 static bool read(marshal_base_t *base, void *object, size_t sizeof_object)
@@ -103,6 +186,12 @@ static bool read(marshal_base_t *base, void *object, size_t sizeof_object)
     size_t next_outdex;
     assert(u);
     assert(object);
+    if (u->stream)
+    {
+        /* Partial reads are only resumed for values. Object headers and
+           pointer indexes are single bytes. */
+        return read_stream(u, object, sizeof_object);
+    }
     next_outdex = u->outdex + sizeof_object;
     if (next_outdex <= u->size)
     {
@@ -117,21 +206,47 @@ static bool read_value(marshal_base_t *base, mob_t *child)
 {
     unmarshal_context_t *u = STRUCT_FROM_MEMBER(unmarshal_context_t, base, base);
     const marshal_type_descriptor_t *type_desc = base->type_desc_list[child->type];
+    marshal_custom_copy_cb copy_cb = memcpy;
+    const marshal_custom_copy_cbs *cbs = type_desc->u.custom_copy_cbs;
     size_t next_outdex;
 
-    next_outdex = u->outdex + type_desc->size;
-    if (next_outdex <= u->size)
+    if (cbs && cbs->unmarshal_copy)
     {
-        marshal_custom_copy_cb copy_cb = memcpy;
-        const marshal_custom_copy_cbs *cbs = type_desc->u.custom_copy_cbs;
+        copy_cb = cbs->unmarshal_copy;
+    }
 
-        if (cbs && cbs->unmarshal_copy)
+    if (u->stream && (copy_cb != memcpy) &&
+        (u->skip || (u->outdex + type_desc->size > u->size)))
+    {
+        /* The value is split across buffers, assemble it in the scratch
+           (which holds the part read from the previous buffer) */
+        if (u->skip >= type_desc->size)
         {
-            copy_cb = cbs->unmarshal_copy;
+            u->skip -= type_desc->size;
+            return TRUE;
         }
+        if (!read_stream(u, base->scratch, type_desc->size))
+        {
+            return FALSE;
+        }
+        (void)copy_cb(child->address, base->scratch, type_desc->size);
+        return TRUE;
+    }
+    if (u->stream && (copy_cb == memcpy))
+    {
+        /* Partial values are read directly to the object */
+        return read_stream(u, child->address, type_desc->size);
+    }
 
+    next_outdex = u->outdex + type_desc->size;
+    if (next_outdex <= u->size)
+    {
         (void)copy_cb(child->address, u->buf + u->outdex, type_desc->size);
         u->outdex = next_outdex;
+        if (u->stream)
+        {
+            u->object_bytes += type_desc->size;
+        }
         return TRUE;
     }
     return FALSE;
@@ -142,10 +257,19 @@ static bool read_pointer_index(marshal_base_t *base,
                                const marshal_member_descriptor_t *desc,
                                mob_t *parent)
 {
+    unmarshal_context_t *u = STRUCT_FROM_MEMBER(unmarshal_context_t, base, base);
     mob_index_t referred_index;
 
     UNUSED(parent);
 
+    if (u->stream && u->skip)
+    {
+        /* The index was read from a previous buffer */
+        assert(u->skip >= sizeof(referred_index));
+        u->skip -= sizeof(referred_index);
+        return TRUE;
+    }
+
     if (read(base, &referred_index, sizeof(referred_index)))
     {
         mob_t referred;
@@ -243,6 +367,56 @@ static bool unmarshal_values(unmarshal_context_t *u)
     return FALSE;
 }
 
+/* Unmarshal object values from a stream buffer. All the data in the buffer is
+   consumed, an object that is incomplete is kept and resumed with the next
+   buffer. */
+static bool unmarshal_values_stream(unmarshal_context_t *u)
+{
+    const traverse_callbacks_t callbacks = {read_value, NULL, NULL};
+    mob_t *object = &u->object;
+
+    for (;;)
+    {
+        if (!object->address)
+        {
+            if (!u->object_typed)
+            {
+                if (!read(&u->base, &object->type, sizeof(object->type)))
+                {
+                    return FALSE;
+                }
+
+                /* Indicates end of marshalled object values */
+                if (MARSHAL_TYPES_MAX == object->type)
+                {
+                    return TRUE;
+                }
+
+                assert(object->type < u->base.type_desc_list_elements);
+                u->object_typed = TRUE;
+            }
+
+            if (!unmarshal_alloc(u, object))
+            {
+                return FALSE;
+            }
+            u->object_typed = FALSE;
+        }
+
+        unmarshal_backup(u);
+
+        if (!object_tree_traverse(&u->base, object, &callbacks))
+        {
+            unmarshal_restore(u);
+            return FALSE;
+        }
+
+        assert(mobs_push(&u->base.object_set, object));
+        object->address = NULL;
+        u->resume = 0;
+    }
+}
+
 static bool unmarshal_pointer_indexes(mobs_t *set, mob_index_t index, mob_t *object)
 {
     marshal_base_t *base = STRUCT_FROM_MEMBER(marshal_base_t, object_set, set);
@@ -255,6 +429,7 @@ static bool unmarshal_pointer_indexes(mobs_t *set, mob_index_t index, mob_t *obj
     {
         assert(index < MOBS_MAX_OBJECTS);
         u->next_index = (mob_index_t)(index + 1);
+        u->resume = 0;
         return TRUE;
     }
     unmarshal_restore(u);
@@ -272,7 +447,7 @@ bool unmarshal(unmarshal_context_t *u, void **addr, marshal_type_t *type)
     {
         case UNMARSHAL_VALUES:
         {
-            if (!unmarshal_values(u))
+            if (!(u->stream ? unmarshal_values_stream(u) : unmarshal_values(u)))
             {
                 break;
             }
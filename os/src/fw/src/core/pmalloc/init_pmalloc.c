@@ -59,6 +59,12 @@ pmalloc_owner_internal_ref pmalloc_owner[PMALLOC_MAX_DEBUG_BLOCKS];
 #ifdef PMALLOC_RECORD_USAGE_LEVEL
 uint16 pmalloc_current_bytes_out;
 uint16 pmalloc_highest_bytes_out;
+#endif
+
+/** Ring buffer for the binary allocation trace */
+#ifdef PMALLOC_TRACE_BINARY
+pmalloc_trace_record pmalloc_trace_log[PMALLOC_TRACE_BINARY_ENTRIES];
+uint32 pmalloc_trace_log_count;
 #endif
 
  /**
@@ -189,6 +195,9 @@ void init_pmalloc(void)
             pfree(hwm);
             hwm += pool->size; /*lint !e449 not really pfree'd above */
         }
+        pool->max_allocated = 0;
+        pool->fallbacks = 0;
+        pool->failures = 0;
 #ifdef PMALLOC_STATS
         pool->max_ideal_size = 0;
         pool->curr_ideal_size = 0;
@@ -174,6 +174,8 @@ void pfree(void *ptr)
         / pool->size;
 #endif /*PMALLOC_RECORD_LENGTHS*/
 
+    PMALLOC_TRACE_BINARY_RECORD(PMALLOC_TRACE_EVENT_FREE, pool, ptr, 0, 0);
+
     PMALLOC_BLOCK_INTERRUPTS();
 
 #ifdef PMALLOC_STATS
@@ -175,6 +175,54 @@ extern void *xprealloc_trace(void *ptr, size_t size, size_t caller);
 extern void *xprealloc_no_trace(void *ptr, size_t size);
 #endif /* PMALLOC_TRACE_OWNER_PC_ONLY */
 
+/** Usage statistics for a pmalloc pool */
+typedef struct
+{
+    /** Size of blocks in this pool */
+    uint16 size;
+
+    /** Total blocks in pool (free + allocated) */
+    uint16 blocks;
+
+    /** Number of blocks currently allocated */
+    uint16 allocated;
+
+    /** Most blocks allocated at once since the statistics were reset */
+    uint16 max_allocated;
+
+    /** Requests that would ideally have used this pool but were served
+        from a larger pool because this one was empty */
+    uint16 fallbacks;
+
+    /** Requests that would ideally have used this pool but could not be
+        served at all. Requests larger than every pool count against the
+        largest pool. */
+    uint16 failures;
+} pmalloc_pool_statistics;
+
+/**
+ * Read the usage statistics of the pools
+ *
+ * Copy the statistics of up to "count" pools, starting with pool number
+ * "first" (pools are numbered in order of increasing block size), to
+ * "stats". The fallback and failure counts saturate rather than wrap.
+ *
+ * Returns
+ *
+ * The total number of pools.
+ */
+extern size_t pmalloc_get_pool_statistics(size_t first,
+                                          pmalloc_pool_statistics *stats,
+                                          size_t count);
+
+/**
+ * Reset the usage statistics of the pools
+ *
+ * Restart the peak usage of every pool from its current usage and clear
+ * the fallback and failure counts.
+ */
+extern void pmalloc_reset_pool_statistics(void);
+
 #ifdef PMALLOC_MONITOR_POOLS
 /**
  * Set free block monitoring limits
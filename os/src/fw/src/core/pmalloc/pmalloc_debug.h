@@ -200,6 +200,88 @@ extern uint16 pmalloc_current_bytes_out;
 extern uint16 pmalloc_highest_bytes_out;
 #endif
 
+/**
+ * Record a compact binary trace of every allocation and free.
+ *
+ * Each event is a fixed size record written to a RAM ring buffer, which is
+ * read out with the debugger and replayed on the host by the pmalloc pool
+ * sizing tool (adk/tools/packages/pmalloc_pools). The trace only covers the
+ * most recent PMALLOC_TRACE_BINARY_ENTRIES events, so the buffer should be
+ * read out before it wraps if the complete lifetime of the blocks matters.
+ */
+#ifdef PMALLOC_TRACE_BINARY
+#ifndef PMALLOC_TRACE_BINARY_ENTRIES
+#define PMALLOC_TRACE_BINARY_ENTRIES (256)
+#endif
+
+/** Kinds of event recorded in the binary trace */
+typedef enum
+{
+    PMALLOC_TRACE_EVENT_ALLOC = 0,  /**< Block allocated */
+    PMALLOC_TRACE_EVENT_FREE = 1,   /**< Block returned to its pool */
+    PMALLOC_TRACE_EVENT_FAIL = 2    /**< No block available for the request */
+} pmalloc_trace_event;
+
+/** Value of pmalloc_trace_record::pool when no pool is involved */
+#define PMALLOC_TRACE_NO_POOL (0xff)
+
+/**
+ * A single binary trace record (12 bytes, stored in native little-endian
+ * order and decoded with the same layout by the host tool)
+ */
+typedef struct
+{
+    /** hal_get_time() at the time of the event, in microseconds */
+    uint32 time;
+    /** Offset of the block from pmalloc_blocks, in PMALLOC_ALIGN_BOUNDARY
+        units. Pairs each free with the allocation it releases. */
+    uint16 block;
+    /** Owner reference as stored in pmalloc_owner, or 0 if not traced */
+    uint16 owner;
+    /** Requested size for allocations and failures, 0 for frees */
+    uint16 size;
+    /** Index of the pool the block belongs to, or PMALLOC_TRACE_NO_POOL */
+    uint8 pool;
+    /** A pmalloc_trace_event */
+    uint8 event;
+} pmalloc_trace_record;
+
+/** Ring buffer of trace records */
+extern pmalloc_trace_record pmalloc_trace_log[PMALLOC_TRACE_BINARY_ENTRIES];
+/** Total number of records written; the next record goes to
+    pmalloc_trace_log[pmalloc_trace_log_count % PMALLOC_TRACE_BINARY_ENTRIES] */
+extern uint32 pmalloc_trace_log_count;
+
+/**
+ * Append a record to the binary trace
+ *
+ * \param event The pmalloc_trace_event being recorded
+ * \param pool The pool control block of the block, or NULL on failure
+ * \param ptr The block, or NULL on failure
+ * \param size The requested size, or 0 for a free
+ * \param owner The owner reference, or 0 if not traced
+ */
+extern void pmalloc_trace_binary_record(pmalloc_trace_event event,
+                                        const pmalloc_pool *pool,
+                                        const void *ptr,
+                                        size_t size,
+                                        uint16 owner);
+
+#define PMALLOC_TRACE_BINARY_RECORD(event, pool, ptr, size, owner) \
+    pmalloc_trace_binary_record((event), (pool), (ptr), (size), (owner))
+
+/** Owner reference to store in the trace (file name strings are not kept) */
+#if defined(PMALLOC_TRACE_OWNER_LINES_ONLY) \
+    || defined(PMALLOC_TRACE_OWNER_PC_ONLY)
+#define PMALLOC_TRACE_BINARY_OWNER(owner) \
+    ((uint16) ((owner) >> PC_TRACE_SHIFT))
+#else
+#define PMALLOC_TRACE_BINARY_OWNER(owner) (0)
+#endif
+#else
+#define PMALLOC_TRACE_BINARY_RECORD(event, pool, ptr, size, owner) ((void) 0)
+#endif /* PMALLOC_TRACE_BINARY */
+
 /**
  * Check sanity of all pools
  *
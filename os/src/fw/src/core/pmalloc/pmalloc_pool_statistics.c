@@ -0,0 +1,59 @@
+/* Copyright (c) 2020 Qualcomm Technologies International, Ltd. */
+/*   %%version */
+/**
+ * \file
+ * Read and reset the pool usage statistics
+ *
+ */
+
+#include "pmalloc/pmalloc_private.h"
+
+
+/**
+ * Read the usage statistics of the pools
+ */
+size_t pmalloc_get_pool_statistics(size_t first,
+                                   pmalloc_pool_statistics *stats,
+                                   size_t count)
+{
+    const pmalloc_pool *pools_end = pmalloc_pools + pmalloc_num_pools;
+    const pmalloc_pool *pool;
+
+    /* Copy each pool with interrupts blocked so that its figures are
+       consistent with each other */
+    for (pool = pmalloc_pools + MIN(first, pmalloc_num_pools);
+         count && pool < pools_end;
+         ++pool, ++stats, --count)
+    {
+        PMALLOC_BLOCK_INTERRUPTS();
+        stats->size = (uint16) pool->size;
+        stats->blocks = (uint16) pool->blocks;
+        stats->allocated = (uint16) pool->allocated;
+        stats->max_allocated = pool->max_allocated;
+        stats->fallbacks = pool->fallbacks;
+        stats->failures = pool->failures;
+        PMALLOC_UNBLOCK_INTERRUPTS();
+    }
+
+    return pmalloc_num_pools;
+}
+
+/**
+ * Reset the usage statistics of the pools
+ */
+void pmalloc_reset_pool_statistics(void)
+{
+    const pmalloc_pool *pools_end = pmalloc_pools + pmalloc_num_pools;
+    pmalloc_pool *pool;
+
+    PMALLOC_BLOCK_INTERRUPTS();
+
+    for (pool = pmalloc_pools; pool < pools_end; ++pool)
+    {
+        pool->max_allocated = (uint16) pool->allocated;
+        pool->fallbacks = 0;
+        pool->failures = 0;
+    }
+
+    PMALLOC_UNBLOCK_INTERRUPTS();
+}
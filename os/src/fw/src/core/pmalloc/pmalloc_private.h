@@ -89,6 +89,16 @@ extern char *pmalloc_app_size;
 #define PMALLOC_BLOCK_INTERRUPTS() block_interrupts();
 #define PMALLOC_UNBLOCK_INTERRUPTS() unblock_interrupts();
 
+/** Increment a uint16 usage statistic, sticking at its maximum value */
+#define PMALLOC_COUNT_SATURATING(count) \
+    do \
+    { \
+        if ((count) != 0xffff) \
+        { \
+            ++(count); \
+        } \
+    } while (0)
+
 
 /** Control block for a pool of blocks of the same size */
 typedef struct pmalloc_pool
@@ -108,6 +118,11 @@ typedef struct pmalloc_pool
     /** Number of blocks currently allocated */
     size_t allocated;
 
+    /** Usage statistics, see pmalloc_pool_statistics */
+    uint16 max_allocated;
+    uint16 fallbacks;
+    uint16 failures;
+
 #ifdef PMALLOC_STATS
     /** How big the pool needed to be to prevent overflows */
     uint16 max_ideal_size;
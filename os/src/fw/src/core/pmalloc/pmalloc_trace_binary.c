@@ -0,0 +1,46 @@
+/* Copyright (c) 2020 Qualcomm Technologies International, Ltd. */
+/*   %%version */
+/**
+ * \file
+ * Record a compact binary trace of allocations and frees
+ *
+ */
+
+#include "pmalloc/pmalloc_private.h"
+
+#ifdef PMALLOC_TRACE_BINARY
+
+#include "hal/haltime.h"
+
+/**
+ * Append a record to the binary trace
+ */
+void pmalloc_trace_binary_record(pmalloc_trace_event event,
+                                 const pmalloc_pool *pool,
+                                 const void *ptr,
+                                 size_t size,
+                                 uint16 owner)
+{
+    pmalloc_trace_record *record;
+
+    PMALLOC_BLOCK_INTERRUPTS();
+
+    record = &pmalloc_trace_log[pmalloc_trace_log_count
+                                % PMALLOC_TRACE_BINARY_ENTRIES];
+    ++pmalloc_trace_log_count;
+
+    record->time = hal_get_time();
+    record->block = ptr ? (uint16) ((size_t) ((const char *) ptr
+                                              - (const char *) pmalloc_blocks)
+                                    / PMALLOC_ALIGN_BOUNDARY)
+                        : 0;
+    record->owner = owner;
+    record->size = (uint16) MIN(size, 0xffff);
+    record->pool = pool ? (uint8) (pool - pmalloc_pools)
+                        : PMALLOC_TRACE_NO_POOL;
+    record->event = (uint8) event;
+
+    PMALLOC_UNBLOCK_INTERRUPTS();
+}
+
+#endif /* PMALLOC_TRACE_BINARY */
@@ -23,6 +23,10 @@ void *PMALLOC_TRACE_FN(xpmalloc, size_t size, pmalloc_owner_ref owner)
     void *ptr;
     const pmalloc_pool *pools_end = pmalloc_pools + pmalloc_num_pools;
     pmalloc_pool *pool;
+    pmalloc_pool *ideal;
+#ifdef PMALLOC_TRACE_BINARY
+    size_t trace_size = size;
+#endif
     
 #ifdef PMALLOC_RECORD_LENGTHS
     size_t requested_size = size;
@@ -121,6 +125,12 @@ void *PMALLOC_TRACE_FN(xpmalloc, size_t size, pmalloc_owner_ref owner)
            performing two comparisons per pool in the following loop */
         if (pools_end[-1].size < size)
         {
+            PMALLOC_BLOCK_INTERRUPTS();
+            PMALLOC_COUNT_SATURATING(pmalloc_pools[pmalloc_num_pools - 1].failures);
+            PMALLOC_UNBLOCK_INTERRUPTS();
+            PMALLOC_TRACE_BINARY_RECORD(PMALLOC_TRACE_EVENT_FAIL, NULL, NULL,
+                                        trace_size,
+                                        PMALLOC_TRACE_BINARY_OWNER(owner));
             return NULL;
         }
         /* Find the first of the remaining pools that contains sufficiently
@@ -134,6 +144,9 @@ void *PMALLOC_TRACE_FN(xpmalloc, size_t size, pmalloc_owner_ref owner)
         /* CONSTANTCONDITION */
     } while (0);
 
+    /* Remember the best fit pool for the usage statistics */
+    ideal = pool;
+
 #ifdef PMALLOC_STATS
     if (size <= PMALLOC_MAX_DEBUG_SIZE)
     {
@@ -187,6 +200,14 @@ void *PMALLOC_TRACE_FN(xpmalloc, size_t size, pmalloc_owner_ref owner)
 
             /* Update the count of allocated blocks in this pool */
             ++(pool->allocated);
+            if (pool->max_allocated < pool->allocated)
+            {
+                pool->max_allocated = (uint16) pool->allocated;
+            }
+            if (pool != ideal)
+            {
+                PMALLOC_COUNT_SATURATING(ideal->fallbacks);
+            }
 
 #ifdef PMALLOC_RECORD_USAGE_LEVEL
             pmalloc_current_bytes_out += pool->size;
@@ -258,6 +279,10 @@ void *PMALLOC_TRACE_FN(xpmalloc, size_t size, pmalloc_owner_ref owner)
 #endif
 
 
+            PMALLOC_TRACE_BINARY_RECORD(PMALLOC_TRACE_EVENT_ALLOC, pool, ptr,
+                                        trace_size,
+                                        PMALLOC_TRACE_BINARY_OWNER(owner));
+
 #if defined(MEMORY_PROFILING)
             {
                 static uint16 counter=0;
@@ -278,5 +303,11 @@ void *PMALLOC_TRACE_FN(xpmalloc, size_t size, pmalloc_owner_ref owner)
     } while (++pool < pools_end);
 
     /* No free blocks if this point reached */
+    PMALLOC_BLOCK_INTERRUPTS();
+    PMALLOC_COUNT_SATURATING(ideal->failures);
+    PMALLOC_UNBLOCK_INTERRUPTS();
+    PMALLOC_TRACE_BINARY_RECORD(PMALLOC_TRACE_EVENT_FAIL, NULL, NULL,
+                                trace_size,
+                                PMALLOC_TRACE_BINARY_OWNER(owner));
     return NULL;
 }
@@ -17,6 +17,9 @@
 
 #define MAX_MULTICAST_RECIPIENTS 15
 
+/** Most tasks a multicast set can hold (limited by AppMessage::multicast) */
+#define MAX_MULTICAST_SET_RECIPIENTS 255
+
 /**
  * Pass the given message to the given firmware message channel handler task,
  * applying filtering as required
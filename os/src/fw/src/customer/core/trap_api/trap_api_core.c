@@ -216,6 +216,42 @@ uint16 VmGetAvailableAllocations(void)
 #endif
 }
 
+uint16 VmGetMemoryPoolStatistics(vm_memory_pool_statistics *stats,
+                                 uint16 first, uint16 count)
+{
+#ifdef DESKTOP_TEST_BUILD
+    UNUSED(stats);
+    UNUSED(first);
+    UNUSED(count);
+    return 0;
+#else
+    /* The trap and pmalloc structures have the same layout but are kept
+       separate so that neither interface depends on the other */
+    pmalloc_pool_statistics pool;
+    size_t pools = pmalloc_get_pool_statistics(0, NULL, 0);
+    uint16 i;
+
+    for (i = 0; i < count && first + i < pools; ++i)
+    {
+        (void)pmalloc_get_pool_statistics(first + i, &pool, 1);
+        stats[i].size = pool.size;
+        stats[i].blocks = pool.blocks;
+        stats[i].allocated = pool.allocated;
+        stats[i].max_allocated = pool.max_allocated;
+        stats[i].fallbacks = pool.fallbacks;
+        stats[i].failures = pool.failures;
+    }
+    return (uint16)pools;
+#endif
+}
+
+void VmResetMemoryPoolStatistics(void)
+{
+#ifndef DESKTOP_TEST_BUILD
+    pmalloc_reset_pool_statistics();
+#endif
+}
+
 void OsInit(void)
 {
 #ifndef DESKTOP_TEST_BUILD
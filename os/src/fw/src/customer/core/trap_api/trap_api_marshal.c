@@ -36,6 +36,18 @@ void UnmarshalSetBuffer(unmarshaller_t u, const void *buf, size_t data_size)
 }
 /*@}*/
 
+/**@{ */
+/** Set the next buffer of a streamed byte stream. */
+void MarshalSetStreamBuffer(marshaller_t m, void *buf, size_t space)
+{
+    marshal_set_stream_buffer(m, buf, space);
+}
+void UnmarshalSetStreamBuffer(unmarshaller_t u, const void *buf, size_t data_size)
+{
+    unmarshal_set_stream_buffer(u, buf, data_size);
+}
+/*@}*/
+
 /**@{ */
 /** Marshal / unmarshal. */
 bool Marshal(marshaller_t m, void *addr, marshal_type_t type)
@@ -43,8 +43,91 @@ COMPILE_TIME_ASSERT(sizeof(Task)*CHAR_BIT == CONDITION_WIDTH_32BIT,
 /** Not currently used. Can be enabled for logging primitives. */
 #define vm_debug_message_cancel(x)
 
-/** Queue of messages waiting to be delivered */
-AppMessage *vm_message_queue;
+/**
+ * Number of buckets in the (Task, MessageId) index of queued messages, as a
+ * power of two
+ */
+#define VM_MESSAGE_INDEX_BUCKETS_LOG2 (5)
+
+/** Number of buckets in the (Task, MessageId) index of queued messages */
+#define VM_MESSAGE_INDEX_BUCKETS (1u << VM_MESSAGE_INDEX_BUCKETS_LOG2)
+
+/*
+ * Queued messages are the most numerous allocation on P1, so AppMessage is
+ * kept to seven words. The queue links messages through AppMessage::next
+ * alone and needs no memory of its own beyond the tables below.
+ */
+COMPILE_TIME_ASSERT(sizeof(AppMessage) <= 7 * sizeof(uint32),
+                    AppMessage_is_no_more_than_7_words);
+
+/**
+ * Entry in the registry of condition words that messages are waiting on.
+ * All the messages blocked on one word are parked on its FIFO, so the word
+ * only has to be read once per delivery however many messages it blocks.
+ */
+typedef struct VM_MESSAGE_CONDITION
+{
+    struct VM_MESSAGE_CONDITION *next; /**< Next entry in the registry */
+    const void *condition_addr;        /**< Pointer to condition value */
+    CONDITION_WIDTH c_width;           /**< Width of condition value */
+    AppMessage *head;                  /**< First message waiting */
+    AppMessage *tail;                  /**< Last message waiting */
+    AppMessage *walk;                  /**< Cursor for a VM_MESSAGE_WALK */
+} VM_MESSAGE_CONDITION;
+
+/** The registry of condition words with messages waiting on them */
+static VM_MESSAGE_CONDITION *vm_message_conditions;
+
+/** Sequence number given to the next message sent */
+static uint32 vm_message_seq;
+
+/**
+ * Messages waiting to be delivered are ordered by due time and then by the
+ * order they were sent in.
+ *
+ * Messages without a condition are linked into the index bucket for their
+ * (Task, MessageId), or for (NULL, MessageId) if they are multicast. Each
+ * bucket is a circular list in delivery order and is held by its last
+ * message, so both appending and finding the first message take one step.
+ *
+ * Conditional messages are always sent for immediate delivery, so they are
+ * held in send order on a FIFO per condition word where they can be stepped
+ * over without disturbing the buckets.
+ */
+static AppMessage *vm_message_index[VM_MESSAGE_INDEX_BUCKETS];
+
+/**
+ * Tournament tree over the index buckets, giving the bucket whose first
+ * message is delivered next. Node 1 is the root, the children of node i are
+ * nodes 2i and 2i+1, and bucket b is the leaf node
+ * VM_MESSAGE_INDEX_BUCKETS + b. Each inner node records the winning bucket
+ * below it as an offset from the first bucket below it, so the zeroed tree
+ * is already consistent. Entry 0 is unused.
+ */
+static uint8 vm_message_tree[VM_MESSAGE_INDEX_BUCKETS];
+
+/**
+ * Most recipients that can be blocked out of multicast messages whose shared
+ * set could not be copied
+ */
+#define VM_MESSAGE_BLOCKED_MAX (4)
+
+/**
+ * A recipient blocked out of a multicast message without changing its set.
+ * This is only used when there's no memory to copy a shared set, so that
+ * cancelling and flushing never need to allocate.
+ */
+typedef struct
+{
+    const AppMessage *a;    /**< The message */
+    Task task;              /**< Recipient it isn't to be delivered to */
+} VM_MESSAGE_BLOCKED;
+
+/** Recipients blocked out of messages, filtered out at delivery */
+static VM_MESSAGE_BLOCKED vm_message_blocked[VM_MESSAGE_BLOCKED_MAX];
+
+/** Number of entries in use in vm_message_blocked */
+static uint16 vm_message_blocked_count;
 
 /**
   Messages sent to the api message task to reschedule it in the background,
@@ -111,18 +194,613 @@ static void trap_api_remove_sink_source_hdlr_entries_for_task(Task task);
  * which take void *.  So we have to kludge away the const-ness via a uint32
  * cast.
  */
-COMPILE_TIME_ASSERT(sizeof(Message) == sizeof(uint32), Message_not_32_bits);
-COMPILE_TIME_ASSERT(sizeof(void *) == sizeof(uint32), Pointer_not_32_bits);
+COMPILE_TIME_ASSERT(sizeof(Message) == sizeof(uint32), Message_not_32_bits);
+COMPILE_TIME_ASSERT(sizeof(void *) == sizeof(uint32), Pointer_not_32_bits);
+
+static void vm_message_forget(Task task);
+static uint32 vm_message_next(void);
+static void vm_message_send_later(Task *task, bool multicast, uint16 id, void *message,
+                           uint32 delay, const void * c,
+                           CONDITION_WIDTH c_width);
+static void vm_message_queue(AppMessage *a, uint16 id, void *message,
+                             uint32 delay, const void * c,
+                             CONDITION_WIDTH c_width);
+static void vm_event_trigger(void);
+
+static uint32 get_message_condition_value(const void *c,
+                                          CONDITION_WIDTH c_width);
+
+/**
+ * Decide whether one queued message is delivered ahead of another
+ * @param a First message
+ * @param b Second message
+ * @return TRUE if @c a is due before @c b, or is due at the same time and
+ * was sent first
+ */
+static bool vm_message_before(const AppMessage *a, const AppMessage *b)
+{
+    int32 delta = VM_DIFF(a->due, b->due);
+    if (delta != 0)
+    {
+        return delta < 0;
+    }
+    return VM_DIFF(a->seq, b->seq) < 0;
+}
+
+/**
+ * Find the index bucket for messages with the given task and ID
+ * @param task Receiving task, or NULL for multicast messages
+ * @param id ID of the message
+ * @return The bucket
+ */
+static uint16 vm_message_index_bucket(Task task, uint16 id)
+{
+    uint32 key = ((uint32)task >> 2) ^ ((uint32)task >> 9) ^
+                 ((uint32)id * 0x9e5u);
+    return (uint16)(key & (VM_MESSAGE_INDEX_BUCKETS - 1));
+}
+
+/**
+ * Find the index bucket for a message without a condition
+ * @param a The message
+ * @return The bucket
+ */
+static uint16 vm_message_bucket_of(const AppMessage *a)
+{
+    return vm_message_index_bucket(a->multicast ? NULL : a->t.task, a->id);
+}
+
+/**
+ * Get the first message in an index bucket
+ * @param b The bucket
+ * @return The message in the bucket delivered first, or NULL if the bucket
+ * is empty
+ */
+static AppMessage *vm_message_bucket_first(uint16 b)
+{
+    AppMessage *last = vm_message_index[b];
+    return last ? last->next : NULL;
+}
+
+/**
+ * Step to the next message in an index bucket
+ * @param b The bucket
+ * @param a A message in the bucket
+ * @return The message delivered after @c a in the bucket, or NULL if @c a
+ * is the last
+ */
+static AppMessage *vm_message_bucket_next(uint16 b, const AppMessage *a)
+{
+    return (a == vm_message_index[b]) ? NULL : a->next;
+}
+
+/**
+ * Decide whether the first message in one index bucket is delivered ahead
+ * of the first message in another
+ * @param b First bucket
+ * @param c Second bucket
+ * @return TRUE if @c b is not empty and its first message is delivered
+ * before that of @c c, or @c c is empty
+ */
+static bool vm_message_bucket_before(uint16 b, uint16 c)
+{
+    const AppMessage *first_b = vm_message_bucket_first(b);
+    const AppMessage *first_c = vm_message_bucket_first(c);
+
+    return first_b != NULL &&
+           (first_c == NULL || vm_message_before(first_b, first_c));
+}
+
+/**
+ * Find the bucket that won the tournament below a node of the tree
+ * @param node Node of the tree, which may be a leaf
+ * @return The bucket whose first message is delivered first out of those
+ * below @c node
+ */
+static uint16 vm_message_tree_winner(uint32 node)
+{
+    uint32 base = node;
+
+    while (base < VM_MESSAGE_INDEX_BUCKETS)
+    {
+        base *= 2;
+    }
+    base -= VM_MESSAGE_INDEX_BUCKETS;
+
+    if (node < VM_MESSAGE_INDEX_BUCKETS)
+    {
+        base += vm_message_tree[node];
+    }
+    return (uint16)base;
+}
+
+/**
+ * Replay the tournament from a bucket to the root after the first message
+ * in the bucket has changed
+ * @param b The bucket
+ */
+static void vm_message_tree_update(uint16 b)
+{
+    uint32 node = (VM_MESSAGE_INDEX_BUCKETS + b) / 2;
+    uint32 half = 1;    /* Number of buckets below each child of node */
+
+    for (; node != 0; node /= 2, half *= 2)
+    {
+        uint32 base = 2 * node * half - VM_MESSAGE_INDEX_BUCKETS;
+        uint32 left = base;
+        uint32 right = base + half;
+
+        if (half > 1)
+        {
+            left += vm_message_tree[2 * node];
+            right += vm_message_tree[2 * node + 1];
+        }
+        uint32 old = base + vm_message_tree[node];
+        uint32 winner = vm_message_bucket_before((uint16)right, (uint16)left) ?
+                                                                right : left;
+
+        vm_message_tree[node] = (uint8)(winner - base);
+        if (old != b && winner != b)
+        {
+            /* Nothing above this node can have changed */
+            break;
+        }
+    }
+}
+
+/**
+ * Link a message without a condition into its index bucket, keeping the
+ * bucket in delivery order. New messages almost always go at the end.
+ * @param a Message being queued
+ */
+static void vm_message_index_add(AppMessage *a)
+{
+    uint16 b = vm_message_bucket_of(a);
+    AppMessage *last = vm_message_index[b];
+    AppMessage *prev;
+
+    if (last == NULL)
+    {
+        a->next = a;
+        vm_message_index[b] = a;
+        vm_message_tree_update(b);
+    }
+    else if (!vm_message_before(a, last))
+    {
+        a->next = last->next;
+        last->next = a;
+        vm_message_index[b] = a;
+    }
+    else
+    {
+        /* a is ahead of the last message, so this stops before wrapping */
+        for (prev = last; !vm_message_before(a, prev->next); prev = prev->next)
+        {
+        }
+        a->next = prev->next;
+        prev->next = a;
+        if (prev == last)
+        {
+            /* a is the new first message */
+            vm_message_tree_update(b);
+        }
+    }
+}
+
+/**
+ * Unlink a message without a condition from its index bucket
+ * @param a Message being removed from the queue
+ */
+static void vm_message_index_remove(AppMessage *a)
+{
+    uint16 b = vm_message_bucket_of(a);
+    AppMessage *last = vm_message_index[b];
+    AppMessage *prev = last;
+
+    while (prev->next != a)
+    {
+        prev = prev->next;
+    }
+
+    if (prev == a)
+    {
+        vm_message_index[b] = NULL;
+    }
+    else
+    {
+        prev->next = a->next;
+        if (last == a)
+        {
+            vm_message_index[b] = prev;
+        }
+    }
+
+    if (prev == last)
+    {
+        /* a was the first message */
+        vm_message_tree_update(b);
+    }
+}
+
+/**
+ * Find the registry entry for a condition word
+ * @param c Pointer to the condition value
+ * @param c_width Width of the condition value
+ * @param pprev Set to the link that points at the entry, so it can be
+ * removed or created there
+ * @return The entry, or NULL if no messages are waiting on the condition
+ */
+static VM_MESSAGE_CONDITION *vm_message_condition_find(
+                                            const void *c,
+                                            CONDITION_WIDTH c_width,
+                                            VM_MESSAGE_CONDITION ***pprev)
+{
+    VM_MESSAGE_CONDITION **p = &vm_message_conditions;
+
+    while (*p && ((*p)->condition_addr != c || (*p)->c_width != c_width))
+    {
+        p = &(*p)->next;
+    }
+    *pprev = p;
+    return *p;
+}
+
+/**
+ * Park a conditional message at the back of the FIFO for its condition word
+ * @param a The message
+ */
+static void vm_message_conditional_insert(AppMessage *a)
+{
+    VM_MESSAGE_CONDITION **p;
+    VM_MESSAGE_CONDITION *cond =
+                vm_message_condition_find(a->condition_addr,
+                                          (CONDITION_WIDTH)a->c_width, &p);
+    if (!cond)
+    {
+        cond = zpnew(VM_MESSAGE_CONDITION);
+        cond->condition_addr = a->condition_addr;
+        cond->c_width = (CONDITION_WIDTH)a->c_width;
+        *p = cond;
+    }
+
+    a->next = NULL;
+    if (cond->tail)
+    {
+        cond->tail->next = a;
+    }
+    else
+    {
+        cond->head = a;
+    }
+    cond->tail = a;
+}
+
+/**
+ * Take a message off the FIFO for its condition word, dropping the word from
+ * the registry if nothing else is waiting on it
+ * @param a The message
+ */
+static void vm_message_conditional_remove(AppMessage *a)
+{
+    VM_MESSAGE_CONDITION **pcond;
+    VM_MESSAGE_CONDITION *cond =
+                vm_message_condition_find(a->condition_addr,
+                                          (CONDITION_WIDTH)a->c_width, &pcond);
+    AppMessage **p = &cond->head, *prev = NULL;
+
+    while (*p != a)
+    {
+        prev = *p;
+        p = &prev->next;
+    }
+    *p = a->next;
+    if (cond->tail == a)
+    {
+        cond->tail = prev;
+    }
+
+    if (!cond->head)
+    {
+        *pcond = cond->next;
+        pfree(cond);
+    }
+}
+
+/**
+ * Take a message out of the queue. The message itself is left for the
+ * caller to deliver or free.
+ * @param a The message
+ */
+static void vm_message_unlink(AppMessage *a)
+{
+    if (a->condition_addr)
+    {
+        vm_message_conditional_remove(a);
+    }
+    else
+    {
+        vm_message_index_remove(a);
+    }
+}
+
+/**
+ * Create a multicast set holding a copy of a list of tasks
+ * @param tasks NULL-terminated list of tasks
+ * @param max Most tasks the list may hold
+ * @return The new set, holding one reference
+ */
+static MulticastSet vm_multicast_set_create(const Task *tasks, uint16 max)
+{
+    MulticastSet set;
+    const Task *tptr;
+    uint16 count = 0;
+
+    if (tasks == NULL || *tasks == NULL)
+    {
+        /* We can't tolerate no list or an empty list */
+        panic(PANIC_P1_VM_MESSAGE_NULL_TASK_LIST);
+    }
+
+    for (tptr = tasks; *tptr != NULL; tptr++)
+    {
+        count++;
+    }
+
+    if (count > max)
+    {
+        panic(PANIC_P1_VM_MESSAGE_TOO_MANY_RECIPIENTS);
+    }
+
+    /* The structure already has room for the terminating NULL */
+    set = pmalloc(sizeof(struct MulticastSetData) + sizeof(Task) * count);
+    set->refs = 1;
+    set->count = (uint8)count;
+    memcpy(set->tasks, tasks, sizeof(Task) * (count + 1));
+    return set;
+}
+
+/**
+ * Drop a reference to a multicast set, freeing it if it was the last
+ * @param set The set
+ */
+static void vm_multicast_set_release(MulticastSet set)
+{
+    if (--set->refs == 0)
+    {
+        pfree(set);
+    }
+}
+
+/**
+ * Check whether a recipient has been blocked out of a multicast message
+ * without changing its set
+ * @param a The message
+ * @param task The recipient
+ * @return TRUE if @c a mustn't be delivered to @c task
+ */
+static bool vm_message_is_blocked(const AppMessage *a, Task task)
+{
+    uint16 i;
+
+    for (i = 0; i < vm_message_blocked_count; i++)
+    {
+        if (vm_message_blocked[i].a == a && vm_message_blocked[i].task == task)
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Forget the recipients blocked out of a message that is leaving the queue
+ * @param a The message
+ */
+static void vm_message_unblock(const AppMessage *a)
+{
+    uint16 i = 0;
+
+    while (i < vm_message_blocked_count)
+    {
+        if (vm_message_blocked[i].a == a)
+        {
+            vm_message_blocked[i] =
+                            vm_message_blocked[--vm_message_blocked_count];
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+/**
+ * Check whether a multicast message is to be delivered to one entry of its set
+ * @param a The message
+ * @param task Entry of the set
+ * @return TRUE if @c task is a recipient that hasn't been blocked out
+ */
+static bool vm_message_is_recipient(const AppMessage *a, Task task)
+{
+    return task != (Task)INVALIDATED_TASK &&
+           (vm_message_blocked_count == 0 || !vm_message_is_blocked(a, task));
+}
+
+/**
+ * Check whether a queued message is for the given task
+ * @param a The message
+ * @param task The task
+ * @return TRUE if @c a is sent to @c task, directly or as one of the
+ * recipients of a multicast
+ */
+static bool vm_message_is_for_task(const AppMessage *a, Task task)
+{
+    if (a->multicast)
+    {
+        const Task *tptr;
+        for (tptr = a->t.set->tasks; *tptr != NULL; tptr++)
+        {
+            if (*tptr == task)
+            {
+                return vm_message_is_recipient(a, task);
+            }
+        }
+        return FALSE;
+    }
+    return a->t.task == task;
+}
+
+/**
+ * Remove a task from the recipients of a multicast message. This is called
+ * when cancelling and flushing, so it mustn't panic for lack of memory.
+ * @param a The message
+ * @param task Task to remove
+ * @return TRUE if the message still has recipients
+ */
+static bool vm_message_invalidate_task(AppMessage *a, Task task)
+{
+    Task *tptr;
+    bool valid_tasks = FALSE;
+
+    if (a->t.set->refs > 1 && vm_message_is_for_task(a, task))
+    {
+        /* Other messages or the application share the set, so give this
+         * message its own copy before blocking out the task */
+        MulticastSet set = xpmalloc(sizeof(struct MulticastSetData) +
+                                    sizeof(Task) * a->t.set->count);
+        if (set)
+        {
+            set->refs = 1;
+            set->count = a->t.set->count;
+            memcpy(set->tasks, a->t.set->tasks,
+                   sizeof(Task) * (a->t.set->count + 1));
+            vm_multicast_set_release(a->t.set);
+            a->t.set = set;
+        }
+        else
+        {
+            /* Keep sharing the set and filter the task out at delivery */
+            if (vm_message_blocked_count == VM_MESSAGE_BLOCKED_MAX)
+            {
+                panic(PANIC_HYDRA_PRIVATE_MEMORY_EXHAUSTION);
+            }
+            vm_message_blocked[vm_message_blocked_count].a = a;
+            vm_message_blocked[vm_message_blocked_count].task = task;
+            vm_message_blocked_count++;
+        }
+    }
+
+    for (tptr = a->t.set->tasks; *tptr != NULL; tptr++)
+    {
+        if (*tptr == task && a->t.set->refs == 1)
+        {
+            *tptr = (Task)INVALIDATED_TASK;
+        }
+
+        if (vm_message_is_recipient(a, *tptr))
+        {
+            valid_tasks = TRUE;
+        }
+    }
+    return valid_tasks;
+}
+
+/**
+ * Free a message that has been taken out of the queue without being
+ * delivered
+ * @param a The message
+ */
+static void vm_message_discard(AppMessage *a)
+{
+    vm_debug_message_cancel(a);
+    trap_api_message_log(TRAP_API_LOG_CANCEL, a);
+    handle_message_free(a->id, a->message);
+    if (a->multicast)
+    {
+        vm_message_unblock(a);
+        vm_multicast_set_release(a->t.set);
+    }
+    pfree(a);
+}
+
+/**
+ * Cursor for visiting the messages in up to two index buckets, and every
+ * conditional message, in delivery order. The cursors into the FIFOs of the
+ * condition words are kept in their registry entries.
+ */
+typedef struct
+{
+    AppMessage *a;      /**< Next message in the first bucket */
+    AppMessage *b;      /**< Next message in the second bucket */
+    uint16 bucket_a;    /**< The first bucket */
+    uint16 bucket_b;    /**< The second bucket */
+} VM_MESSAGE_WALK;
+
+/**
+ * Set up a cursor to walk the messages that could be for either of two
+ * index keys in delivery order
+ * @param walk The cursor
+ * @param task Task of the first key
+ * @param id Message ID of the first key
+ * @param other_task Task of the second key
+ * @param other_id Message ID of the second key
+ */
+static void vm_message_walk_start(VM_MESSAGE_WALK *walk,
+                                  Task task, uint16 id,
+                                  Task other_task, uint16 other_id)
+{
+    VM_MESSAGE_CONDITION *cond;
+
+    walk->bucket_a = vm_message_index_bucket(task, id);
+    walk->bucket_b = vm_message_index_bucket(other_task, other_id);
+    walk->a = vm_message_bucket_first(walk->bucket_a);
+    walk->b = (walk->bucket_b != walk->bucket_a) ?
+                            vm_message_bucket_first(walk->bucket_b) : NULL;
+
+    for (cond = vm_message_conditions; cond != NULL; cond = cond->next)
+    {
+        cond->walk = cond->head;
+    }
+}
+
+/**
+ * Step a cursor on to the next message
+ * @param walk The cursor
+ * @return The earliest message not yet visited, or NULL if there are none.
+ * The caller must filter out messages that are not for the keys it wants.
+ */
+static AppMessage *vm_message_walk_next(VM_MESSAGE_WALK *walk)
+{
+    AppMessage *a = walk->a;
+    VM_MESSAGE_CONDITION *cond, *from = NULL;
 
-static void vm_message_forget(Task task);
-static uint32 vm_message_next(void);
-static void vm_message_send_later(Task *task, bool multicast, uint16 id, void *message,
-                           uint32 delay, const void * c,
-                           CONDITION_WIDTH c_width);
-static void vm_event_trigger(void);
+    if (walk->b && (!a || vm_message_before(walk->b, a)))
+    {
+        a = walk->b;
+    }
+    for (cond = vm_message_conditions; cond != NULL; cond = cond->next)
+    {
+        if (cond->walk && (!a || vm_message_before(cond->walk, a)))
+        {
+            a = cond->walk;
+            from = cond;
+        }
+    }
 
-static uint32 get_message_condition_value(const void *c,
-                                          CONDITION_WIDTH c_width);
+    if (from)
+    {
+        from->walk = a->next;
+    }
+    else if (a && a == walk->a)
+    {
+        walk->a = vm_message_bucket_next(walk->bucket_a, a);
+    }
+    else if (a)
+    {
+        walk->b = vm_message_bucket_next(walk->bucket_b, a);
+    }
+    return a;
+}
 
 
 /**
@@ -152,19 +830,27 @@ static void vm_message_forget(Task task)
  */
 static uint32 vm_message_next(void)
 {
-    AppMessage *a;
-    AppMessage **p = &vm_message_queue;
+    AppMessage *a = 0, *p;
+    const VM_MESSAGE_CONDITION *cond;
 
-    /* Find the first message which isn't blocked on a condition */
-    while((a = *p) != 0)
+    /* Find the first conditional message which isn't blocked. Each condition
+     * word is read once and only the head of its FIFO can be next. */
+    for(cond = vm_message_conditions; cond != 0; cond = cond->next)
     {
-        const void * c = a->condition_addr;
-        if(c==0 ||
-                get_message_condition_value(c, a->c_width) == 0)
+        if(get_message_condition_value(cond->condition_addr,
+                                       cond->c_width) == 0 &&
+                (a == 0 || vm_message_before(cond->head, a)))
         {
-            break;/* No condition or it's satisfied */
+            a = cond->head;/* Condition is satisfied */
         }
-        p = &a->next;
+    }
+
+    /* Unconditional messages can't be blocked, so the first message in the
+     * bucket that won the tournament is the first of them */
+    p = vm_message_bucket_first(vm_message_tree_winner(1));
+    if(p != 0 && (a == 0 || vm_message_before(p, a)))
+    {
+        a = p;
     }
 
     if(a)
@@ -180,7 +866,7 @@ static uint32 vm_message_next(void)
         else
         {
             /* Unlink the message from the queue */
-            *p = a->next;
+            vm_message_unlink(a);
             /* Deliver the message to the handler(s) */
             if (!a->multicast)
             {
@@ -193,13 +879,13 @@ static uint32 vm_message_next(void)
             }
             else
             {
-                Task *tptr = a->t.tlist;
+                Task *tptr = a->t.set->tasks;
 
                 trap_api_message_log_now(TRAP_API_LOG_DELIVER, a, now);
                 /* Loop through the tasks in the list, despatching to all */
                 while (*tptr != NULL)
                 {
-                    if ((*tptr != (Task)INVALIDATED_TASK) && (*tptr)->handler)
+                    if (vm_message_is_recipient(a, *tptr) && (*tptr)->handler)
                     {
                         VALIDATE_FN_PTR((*tptr)->handler);
                         (*tptr)->handler(*tptr, a->id, a->message);
@@ -211,7 +897,8 @@ static uint32 vm_message_next(void)
             MessageFree(a->id, a->message);
             if (a->multicast)
             {
-                pfree(a->t.tlist);
+                vm_message_unblock(a);
+                vm_multicast_set_release(a->t.set);
             }
             pfree(a);
             return 0;
@@ -267,6 +954,26 @@ static bool similar(const AppMessage *a, const AppMessage *b)
     return FALSE;
 }
 
+/**
+ * Checks whether @c similar() can match a message with the given ID, so
+ * that only those are compared with the queue when they are sent
+ * @param id ID of the message
+ * @return TRUE if @c similar() handles the ID
+ */
+static bool similar_id(uint16 id)
+{
+    switch(id)
+    {
+        case MESSAGE_MORE_DATA:
+        case MESSAGE_MORE_SPACE:
+        case MESSAGE_PSFL_FAULT:
+        case MESSAGE_TX_POWER_CHANGE_EVENT:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
 /**
  * Replace one message with another. Used when a later message contains
  * more up to date information than an earlier one.
@@ -357,6 +1064,28 @@ static bool replace(AppMessage *a, const AppMessage *b)
     return FALSE;
 }
 
+/**
+ * Find the other message ID that @c replace() will combine with a message
+ * @param id ID of the message
+ * @return The interchangeable message ID, or @c id if there is none
+ */
+static uint16 replace_partner(uint16 id)
+{
+    switch(id)
+    {
+    case MESSAGE_USB_ENUMERATED:
+        return MESSAGE_USB_DECONFIGURED;
+    case MESSAGE_USB_DECONFIGURED:
+        return MESSAGE_USB_ENUMERATED;
+    case MESSAGE_USB_ATTACHED:
+        return MESSAGE_USB_DETACHED;
+    case MESSAGE_USB_DETACHED:
+        return MESSAGE_USB_ATTACHED;
+    default:
+        return id;
+    }
+}
+
 /**
  * Checks whether a message can be combined with one already in the message
  * queue by using the @c similar() and @c replace() functions.
@@ -369,44 +1098,196 @@ static bool already(Task task, uint16 id, uint16 *message)
 {
     AppMessage *p;
     AppMessage temp;
+    VM_MESSAGE_WALK walk;
+    uint16 other_id = replace_partner(id);
 
     temp.multicast = 0;
     temp.t.task  = task;
     temp.id      = id;
     temp.message = message;
-    for(p = vm_message_queue; p != 0; p = p->next)
-    if(similar(p, &temp) || replace(p, &temp))
+
+    /* Only messages to the same task with this ID, or with the ID replace()
+     * treats as interchangeable, can match. Visit them in queue order. */
+    vm_message_walk_start(&walk, task, id, task, other_id);
+    while((p = vm_message_walk_next(&walk)) != 0)
+    {
+        uint16 old_id = p->id;
+
+        if(p->multicast || p->t.task != task ||
+                (p->id != id && p->id != other_id))
+        {
+            continue;
+        }
+        if(similar(p, &temp))
+        {
+            return TRUE;
+        }
+        if(replace(p, &temp))
+        {
+            if(p->id != old_id && !p->condition_addr)
+            {
+                /* The message has moved to a different index key */
+                p->id = old_id;
+                vm_message_index_remove(p);
+                p->id = id;
+                vm_message_index_add(p);
+            }
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Checks whether any queued message is delivered strictly between two
+ * others. This is on the path of every MESSAGE_MORE_DATA and
+ * MESSAGE_MORE_SPACE, so only the messages due no later than @c last are
+ * looked at: subtrees of the tournament tree whose winner is not due before
+ * @c last are skipped, and each bucket and condition FIFO is only followed
+ * until it passes @c last.
+ * @param first The earlier message, which is queued
+ * @param last The later message, which is being sent so has the newest
+ * sequence number
+ * @return TRUE if a message falls between @c first and @c last
+ */
+static bool vm_message_any_between(const AppMessage *first,
+                                   const AppMessage *last)
+{
+    /* Enough for the sibling left at each level on the way to a leaf */
+    uint16 stack[VM_MESSAGE_INDEX_BUCKETS_LOG2 + 1];
+    uint16 depth = 0;
+    const AppMessage *p;
+    const VM_MESSAGE_CONDITION *cond;
+
+    if(first->due == last->due && first->seq + 1 == last->seq)
+    {
+        /* Back to back sends due at the same time: nothing can be between */
+        return FALSE;
+    }
+
+    stack[depth++] = 1;
+    while(depth != 0)
+    {
+        uint16 node = stack[--depth];
+        uint16 b = vm_message_tree_winner(node);
+
+        p = vm_message_bucket_first(b);
+        if(p == 0 || !vm_message_before(p, last))
+        {
+            /* Nothing below this node is due before last */
+            continue;
+        }
+        if(vm_message_before(first, p))
+        {
             return TRUE;
+        }
+        if(node >= VM_MESSAGE_INDEX_BUCKETS)
+        {
+            for(p = vm_message_bucket_next(b, p);
+                p != 0 && vm_message_before(p, last);
+                p = vm_message_bucket_next(b, p))
+            {
+                if(vm_message_before(first, p))
+                {
+                    return TRUE;
+                }
+            }
+        }
+        else
+        {
+            stack[depth++] = (uint16)(2 * node + 1);
+            stack[depth++] = (uint16)(2 * node);
+        }
+    }
+
+    /* Conditional messages are always immediate, so each FIFO is in delivery
+     * order */
+    for(cond = vm_message_conditions; cond != 0; cond = cond->next)
+    {
+        for(p = cond->head; p != 0 && vm_message_before(p, last); p = p->next)
+        {
+            if(vm_message_before(first, p))
+            {
+                return TRUE;
+            }
+        }
+    }
     return FALSE;
 }
 
 /**
- * Insert a message into the queue if a similar one isn't already present.
- * The queue is kept in time order.
+ * Find the last message for the same task and ID that is delivered ahead of
+ * a unicast message
+ * @param a The message
+ * @return The message, or NULL if there is none
+ */
+static AppMessage *vm_message_last_before(const AppMessage *a)
+{
+    uint16 b = vm_message_index_bucket(a->t.task, a->id);
+    const VM_MESSAGE_CONDITION *cond;
+    AppMessage *p, *prev = NULL;
+
+    /* The bucket is in queue order, so the last match is the latest */
+    for(p = vm_message_bucket_first(b);
+        p != 0 && vm_message_before(p, a);
+        p = vm_message_bucket_next(b, p))
+    {
+        if(!p->multicast && p->t.task == a->t.task && p->id == a->id)
+        {
+            prev = p;
+        }
+    }
+
+    for(cond = vm_message_conditions; cond != 0; cond = cond->next)
+    {
+        for(p = cond->head; p != 0 && vm_message_before(p, a); p = p->next)
+        {
+            if(!p->multicast && p->t.task == a->t.task && p->id == a->id &&
+                    (prev == 0 || vm_message_before(prev, p)))
+            {
+                prev = p;
+            }
+        }
+    }
+    return prev;
+}
+
+/**
+ * Insert a message into the queue if a similar one isn't already present
+ * immediately before it.
  * @param a Message being posted
  * @return TRUE if the message was inserted into the queue or
  * FALSE if there was already a similar one present.
  */
 static bool insert(AppMessage *a)
 {
-    uint32 due = a->due;
-    AppMessage **p = &vm_message_queue, *prev = NULL;
+    a->seq = vm_message_seq++;
+
+    if(!a->multicast && similar_id(a->id))
+    {
+        AppMessage *prev = vm_message_last_before(a);
 
-    while(*p && VM_DIFF(due, (*p)->due) >= 0)
-    { prev = *p; p = &prev->next; }
+        /* It only counts if nothing else is delivered in between */
+        if(prev && similar(prev, a) && !vm_message_any_between(prev, a))
+        {
+            return FALSE;
+        }
+    }
 
-    if(prev && similar(prev, a))
+    if(a->condition_addr)
     {
-        return FALSE;
+        /* Conditional messages are always immediate, so send order is
+         * queue order */
+        vm_message_conditional_insert(a);
     }
     else
     {
-        a->next = *p;
-        *p = a;
-        return TRUE;
+        vm_message_index_add(a);
     }
+    return TRUE;
 }
 
+
 /**
  * Send a message immediately
  * @param task Task to deliver the message to
@@ -443,38 +1324,17 @@ static void vm_message_send_later(Task *task, bool multicast, uint16 id, void *m
                            CONDITION_WIDTH c_width)
 {
     AppMessage *a;
-    uint32 timenow = get_milli_time();
-    Task *tptr;
-    uint8 lc = 1; /* Pre-account for the null entry */
 
     a = pnew(AppMessage);
     if (multicast)
     {
-        if (task == NULL || *task == NULL)
-        {
-            /* We can't tolerate no list or an empty list */
-            panic(PANIC_P1_VM_MESSAGE_NULL_TASK_LIST);
-        }
-
-        /* We need to walk the list we've been given to copy it */
-        tptr = task;
-
-        while (*tptr != NULL)
-        {   
-            tptr++;
-            lc +=1;
-        }
-
-        if (lc > MAX_MULTICAST_RECIPIENTS)
-        {
-            /* We can't cope with more than this many recipients (stack usage
-             * in the message logger)
-             */
-            panic(PANIC_P1_VM_MESSAGE_TOO_MANY_RECIPIENTS);
-        }
-        a->t.tlist    = pmalloc(sizeof(Task)*lc);
-        memcpy(a->t.tlist, task, sizeof(Task)*lc);
-        a->multicast  = (uint8)(lc-1);
+        /* Copy the list into a set of its own. We can't cope with more than
+         * MAX_MULTICAST_RECIPIENTS entries, including the NULL, through
+         * this interface.
+         */
+        a->t.set      = vm_multicast_set_create(task,
+                                                MAX_MULTICAST_RECIPIENTS - 1);
+        a->multicast  = a->t.set->count;
     }
     else
     {
@@ -488,10 +1348,30 @@ static void vm_message_send_later(Task *task, bool multicast, uint16 id, void *m
         a->t.task     = *task;
         a->multicast  = 0;
     }
+    vm_message_queue(a, id, message, delay, c, c_width);
+}
+
+/**
+ * Queue a message whose recipients have been filled in
+ * @param a The message, which the queue takes ownership of
+ * @param id ID of the message
+ * @param message The message contents
+ * @param delay Number of milliseconds to wait before delivering the message
+ * @param c Optional pointer to a condition which must be zero for the
+ * message to be delivered.
+ * @param c_width Whether to test the condition as a 16 or 32-bit variable
+ * or @c CONDITION_WIDTH_UNUSED if @c c is NULL.
+ */
+static void vm_message_queue(AppMessage *a, uint16 id, void *message,
+                             uint32 delay, const void * c,
+                             CONDITION_WIDTH c_width)
+{
+    uint32 timenow = get_milli_time();
+
     a->id             = id;
     a->message        = message;
     a->condition_addr = c;
-    a->c_width        = c_width;
+    a->c_width        = (uint8)c_width;
     a->due            = delay + timenow;
 
     if(insert(a))
@@ -503,9 +1383,9 @@ static void vm_message_send_later(Task *task, bool multicast, uint16 id, void *m
     else
     {
         handle_message_free(a->id, a->message);
-        if (multicast)
+        if (a->multicast)
         {
-            pfree(a->t.tlist);
+            vm_multicast_set_release(a->t.set);
         }
         pfree(a);
     }
@@ -652,6 +1532,36 @@ void MessageSendMulticastLater(Task *tasklist, MessageId id, void *message, uint
     vm_message_send_later(tasklist, TRUE, id, message, delay, NULL, CONDITION_WIDTH_UNUSED);
 }
 
+MulticastSet MessageMulticastSetCreate(const Task *tasks)
+{
+    return vm_multicast_set_create(tasks, MAX_MULTICAST_SET_RECIPIENTS);
+}
+
+void MessageMulticastSetRelease(MulticastSet set)
+{
+    if (set != NULL)
+    {
+        vm_multicast_set_release(set);
+    }
+}
+
+void MessageSendMulticastSetLater(MulticastSet set, MessageId id, void *message, uint32 delay)
+{
+    AppMessage *a;
+
+    if (set == NULL)
+    {
+        panic(PANIC_P1_VM_MESSAGE_NULL_TASK_LIST);
+    }
+
+    a = pnew(AppMessage);
+    /* The message shares the set rather than copying it */
+    set->refs++;
+    a->t.set     = set;
+    a->multicast = set->count;
+    vm_message_queue(a, id, message, delay, NULL, CONDITION_WIDTH_UNUSED);
+}
+
 
 /*
  * This isn't needed because our MessageLoop is the real scheduler.  However,
@@ -894,57 +1804,35 @@ static void trap_api_remove_sink_source_hdlr_entries_for_task(Task task)
  */
 bool MessageCancelFirst(Task task, uint16 id)
 {
-    struct AppMessage **p = &vm_message_queue;
+    AppMessage *a;
+    VM_MESSAGE_WALK walk;
 
-    while(*p)
+    /* Candidates are the unicast messages for this task and ID and the
+     * multicast messages with this ID. Visit them in queue order. */
+    vm_message_walk_start(&walk, task, id, NULL, id);
+    while ((a = vm_message_walk_next(&walk)) != NULL)
     {
-        struct AppMessage *a = *p;
         bool valid_tasks = TRUE;
 
         if (a->id == id)
         {
             if (a->multicast)
             {
-                /* Iterate over the task list to see if we want to remove it. */
-                Task *tptr = a->t.tlist;
-
-                valid_tasks = FALSE;
-                /* Loop through the tasks in the list to find one to cancel */
-                while (*tptr != NULL)
-                {
-                    if (*tptr == task)
-                    {
-                        *tptr = (Task)INVALIDATED_TASK;
-                    }
-
-                    if (*tptr != (Task)INVALIDATED_TASK)
-                    {
-                        valid_tasks = TRUE;
-                    }
-                    tptr++;
-                }
+                /* Remove the task from the list and see if anyone's left */
+                valid_tasks = vm_message_invalidate_task(a, task);
             }
-           
+
             /* If it's multicast, then t.task can't be task so we don't need
              * to complexify the check.
             */
             if (a->t.task == task || !valid_tasks)
             {
                 /* No tasks on this list, cancel/free the message */
-                *p = a->next;
-                vm_debug_message_cancel(a);
-                trap_api_message_log(TRAP_API_LOG_CANCEL, a);
-                handle_message_free(a->id, a->message);
-                if (a->multicast)
-                {
-                    pfree(a->t.tlist);
-                }
-                pfree(a);
+                vm_message_unlink(a);
+                vm_message_discard(a);
                 return TRUE;
             }
-
         }
-        p = &(*p)->next;
     }
     return FALSE;
 }
@@ -959,62 +1847,112 @@ uint16 MessageCancelAll(Task task, MessageId id)
     return count;
 }
 
+/**
+ * Checks whether a queued message should be flushed along with a task,
+ * removing the task from it if it is multicast.
+ * @param a The message
+ * @param task The task being flushed
+ * @return TRUE if the message should be cancelled
+ */
+static bool vm_message_flush_from_task(AppMessage *a, Task task)
+{
+    if (a->multicast)
+    {
+        return !vm_message_invalidate_task(a, task);
+    }
+    return a->t.task == task;
+}
+
 /*
  * From BC vm_trap_core.c
  */
 uint16 MessageFlushTask(Task task)
 {
     uint16 count = 0;
-    struct AppMessage **p = &vm_message_queue;
+    uint16 b;
+    VM_MESSAGE_CONDITION **pcond = &vm_message_conditions;
 
     vm_message_forget(task);
 
-    while(*p)
+    /* Flush the FIFO for each condition word */
+    while(*pcond)
     {
-        struct AppMessage *a = *p;
-        bool valid_tasks = TRUE;
+        VM_MESSAGE_CONDITION *cond = *pcond;
+        AppMessage **p = &cond->head;
 
-        if (a->multicast)
+        cond->tail = NULL;
+        while(*p)
         {
-            /* Iterate over the task list for this task */
-            Task *tptr = a->t.tlist;
+            AppMessage *a = *p;
 
-            valid_tasks = FALSE;
-            /* Loop through the tasks in the list, deleting ours */
-            while (*tptr != NULL)
+            if (vm_message_flush_from_task(a, task))
             {
-                if (*tptr == task)
-                {
-                    *tptr = (Task)INVALIDATED_TASK;
-                }
-
-                if (*tptr != (Task)INVALIDATED_TASK)
-                {
-                    valid_tasks = TRUE;
-                }
-                tptr++;
+                *p = a->next;
+                vm_message_discard(a);
+                ++count;
+            }
+            else
+            {
+                cond->tail = a;
+                p = &a->next;
             }
         }
 
-        /* Check if we want to flush the message */
-        if (a->t.task == task || !valid_tasks)
+        if (cond->head)
         {
-            *p = a->next;
-            vm_debug_message_cancel(a);
-            trap_api_message_log(TRAP_API_LOG_CANCEL, a);
-            handle_message_free(a->id, a->message);
-            if (a->multicast)
+            pcond = &cond->next;
+        }
+        else
+        {
+            *pcond = cond->next;
+            pfree(cond);
+        }
+    }
+
+    /* Rebuild each index bucket from the messages being kept */
+    for (b = 0; b < VM_MESSAGE_INDEX_BUCKETS; b++)
+    {
+        AppMessage *a, *next, *first = NULL, *last = vm_message_index[b];
+
+        if (!last)
+        {
+            continue;
+        }
+
+        /* Break the circle after the last message */
+        a = last->next;
+        last->next = NULL;
+        last = NULL;
+
+        for (; a != NULL; a = next)
+        {
+            next = a->next;
+            if (vm_message_flush_from_task(a, task))
             {
-                pfree(a->t.tlist);
+                vm_message_discard(a);
+                ++count;
+            }
+            else
+            {
+                if (last)
+                {
+                    last->next = a;
+                }
+                else
+                {
+                    first = a;
+                }
+                last = a;
             }
-            pfree(a);
-            ++count;
         }
-        else
+        if (last)
         {
-            p = &(*p)->next;
+            last->next = first;
         }
+        vm_message_index[b] = last;
+        vm_message_tree_update(b);
     }
+
     return count;
 }
 
@@ -1196,71 +2134,59 @@ Task MessageNfcTask(Task task)
 uint16 MessagesPendingForTask(Task task, int32 *first_due)
 {
     AppMessage *p;
+    const AppMessage *first = NULL;
+    const VM_MESSAGE_CONDITION *cond;
     uint16 count = 0;
+    uint16 b;
 
-    for (p = vm_message_queue; p; p = p->next)
+    for (cond = vm_message_conditions; cond; cond = cond->next)
     {
-        Task *tptr = NULL;
-
-        if (p->multicast)
+        for (p = cond->head; p; p = p->next)
         {
-            /* Iterate over the task list for this task */
-            tptr = p->t.tlist;
-
-            while (*tptr != NULL)
+            if (vm_message_is_for_task(p, task))
             {
-                if (*tptr == task)
+                if (!first || vm_message_before(p, first))
                 {
-                    break;
+                    first = p;
                 }
-                tptr++;
-            }
-            if (*tptr == NULL)
-            {
-                tptr = NULL;
+                ++count;
             }
         }
+    }
 
-        if (p->t.task == task || tptr != NULL)
+    for (b = 0; b < VM_MESSAGE_INDEX_BUCKETS; b++)
+    {
+        for (p = vm_message_bucket_first(b); p;
+             p = vm_message_bucket_next(b, p))
         {
-            if (!count && first_due)
+            if (vm_message_is_for_task(p, task))
             {
-                uint32 now  = get_milli_time();
-                *first_due = VM_DIFF(p->due, now);
+                if (!first || vm_message_before(p, first))
+                {
+                    first = p;
+                }
+                ++count;
             }
-            ++count;
         }
     }
+
+    if (first && first_due)
+    {
+        uint32 now  = get_milli_time();
+        *first_due = VM_DIFF(first->due, now);
+    }
     return count;
 }
 
 bool MessagePendingFirst(Task task, MessageId id, int32 *first_due)
 {
     AppMessage *p;
-    for (p = vm_message_queue; p; p = p->next)
-    {
-        Task *tptr = NULL;
-
-        if (p->multicast)
-        {
-            /* Iterate over the task list for this task */
-            tptr = p->t.tlist;
-
-            while (*tptr != NULL)
-            {
-                if (*tptr == task)
-                {
-                    break;
-                }
-                tptr++;
-            }
-            if (*tptr == NULL)
-            {
-                tptr = NULL;
-            }
-        }
+    VM_MESSAGE_WALK walk;
 
-        if ((p->t.task == task || tptr != NULL) && p->id == id)
+    vm_message_walk_start(&walk, task, id, NULL, id);
+    while ((p = vm_message_walk_next(&walk)) != NULL)
+    {
+        if (p->id == id && vm_message_is_for_task(p, task))
         {
             if (first_due)
             {
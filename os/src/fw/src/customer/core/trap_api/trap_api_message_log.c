@@ -107,6 +107,7 @@ void trap_api_message_log_now(TRAP_API_LOG_ACTION action, AppMessage *msg, uint3
     uint32  null_value=0;
     uint8   type = (uint8) action;
     Task   *tptr;
+    uint8   recipients = 0;
     unsigned int total_len;
 
     /*
@@ -149,9 +150,13 @@ void trap_api_message_log_now(TRAP_API_LOG_ACTION action, AppMessage *msg, uint3
 
     if (msg->multicast)
     {
+        /* A multicast set can hold more tasks than the record has room for,
+         * so only the first MAX_MULTICAST_RECIPIENTS are logged */
+        recipients = MIN(msg->multicast, MAX_MULTICAST_RECIPIENTS);
+
         /* Update the delimiter and increase the overall length */
-        delimiter |= msg->multicast;
-        total_len += (msg->multicast - 1) * (sizeof(msg->t)+sizeof(msg->t.task->handler));
+        delimiter |= recipients;
+        total_len += (recipients - 1) * (sizeof(msg->t)+sizeof(msg->t.task->handler));
     }
 
     rec_len = (uint16)(total_len - sizeof(rec_len));
@@ -174,15 +179,14 @@ void trap_api_message_log_now(TRAP_API_LOG_ACTION action, AppMessage *msg, uint3
         FAST_LOG_MSG_ELEMENT(type, bufpos);
         if (msg->multicast)
         {
-            tptr = msg->t.tlist;
-            while (*tptr != NULL)
+            for (tptr = msg->t.set->tasks;
+                 tptr < msg->t.set->tasks + recipients; tptr++)
             {
                 FAST_LOG_MSG_ELEMENT(*tptr, bufpos);
                 if (*tptr != (Task)INVALIDATED_TASK)
                     FAST_LOG_MSG_ELEMENT((*tptr)->handler, bufpos);
                 else
                     FAST_LOG_MSG_ELEMENT(null_value, bufpos);
-                tptr++;
             }
         }
         else
@@ -219,15 +223,14 @@ void trap_api_message_log_now(TRAP_API_LOG_ACTION action, AppMessage *msg, uint3
         FAST_LOG_MSG_ELEMENT(type, bufpos);
         if (msg->multicast)
         {
-            tptr = msg->t.tlist;
-            while (*tptr != NULL)
+            for (tptr = msg->t.set->tasks;
+                 tptr < msg->t.set->tasks + recipients; tptr++)
             {
                 FAST_LOG_MSG_ELEMENT(*tptr, bufpos);
                 if (*tptr != (Task)INVALIDATED_TASK)
                     FAST_LOG_MSG_ELEMENT((*tptr)->handler, bufpos);
                 else
                     FAST_LOG_MSG_ELEMENT(null_value, bufpos);
-                tptr++;
             }
         }
         else
@@ -69,20 +69,35 @@ typedef enum
  */
 typedef struct AppMessage
 {
-    struct AppMessage *next;
+    struct AppMessage *next;     /**< Next message in the same index bucket,
+                                      or waiting on the same condition */
     uint32 due;                  /**< Millisecond time to deliver this message */
+    uint32 seq;                  /**< Send order, orders messages with equal due */
     union
     {
         Task task;               /**< Receiving task (if unicast) */
-        Task *tlist;             /**< Ptr to receiving task list (if multicast) */
+        MulticastSet set;        /**< Receiving tasks (if multicast) */
     } t;
     void *message;               /**< Pointer to the message payload */
     const void *condition_addr;  /**< Pointer to condition value */
     uint16 id;                   /**< Message ID */
-    CONDITION_WIDTH c_width;     /**< Width of condition value */
-    uint8 multicast;             /**< If multicast, task is a null-terminated list */
+    uint8 c_width;               /**< Width of condition value, a
+                                      CONDITION_WIDTH */
+    uint8 multicast;             /**< If multicast, the number of tasks in set */
 } AppMessage;
 
+/**
+ * Immutable, reference-counted set of multicast recipients. Every queued
+ * multicast message holds a reference, so an application can send the same
+ * set many times without it being copied for each message.
+ */
+struct MulticastSetData
+{
+    uint16 refs;                 /**< Number of holders of the set */
+    uint8 count;                 /**< Number of tasks, excluding the NULL */
+    Task tasks[1];               /**< NULL-terminated list of tasks */
+};
+
 /** 
  * Magic value for blocking out a task in a multicast list
  */
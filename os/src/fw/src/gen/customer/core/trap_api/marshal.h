@@ -241,6 +241,37 @@ void MarshalSetBuffer(marshaller_t m, void * buf, size_t space);
  */
 void UnmarshalSetBuffer(unmarshaller_t u, const void * buf, size_t data_bytes);
 
+/**
+ *  \brief Set the next buffer of a streamed marshaling byte stream.
+ * Unlike \c MarshalSetBuffer, objects are not backed up when the buffer is full:
+ * \c Marshal fills the buffer completely and resumes part way through the object
+ * when the next buffer is set. The concatenated buffers form the same byte stream
+ * as marshalling to a single buffer, so it may be transmitted in fixed size
+ * chunks as it is produced. The stream must be unmarshalled using \c
+ * UnmarshalSetStreamBuffer.
+ *         
+ *  \param m Handle for the marshaller.
+ *  \param buf Address to which the marshaller will write the next part of the byte stream.
+ *  \param space The number of bytes space in the buffer.
+ * 
+ * \ingroup trapset_marshal
+ */
+void MarshalSetStreamBuffer(marshaller_t m, void * buf, size_t space);
+
+/**
+ *  \brief Set the next buffer of a streamed unmarshaling byte stream.
+ * Unlike \c UnmarshalSetBuffer, objects may be split across buffers. \c
+ * Unmarshal consumes all the data in the buffer, keeping any incomplete object
+ * until the rest of it is provided in the next buffer.
+ *         
+ *  \param u Handle for the unmarshaller.
+ *  \param buf Address from which the unmarshaller will read the next part of the byte stream.
+ *  \param data_bytes The number of data bytes in the buffer.
+ * 
+ * \ingroup trapset_marshal
+ */
+void UnmarshalSetStreamBuffer(unmarshaller_t u, const void * buf, size_t data_bytes);
+
 /**
  *  \brief Marshal a object hierarchy.
  * Hierarchies are marshalled piecemeal. The function \c MarshalProduced may be
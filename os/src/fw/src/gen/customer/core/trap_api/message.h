@@ -225,6 +225,42 @@ void MessageSendMulticastLater(Task * tasks, MessageId id, void * message, uint3
  * \ingroup trapset_core
  */
 void MessageSendMulticastConditionally(Task * tlist, MessageId id, Message m, const uint16 * c);
+
+/**
+ *  \brief Create a multicast recipient set that can be sent to many times with
+ *  MessageSendMulticastSetLater() without the recipients being copied for each message.
+ *  \param tasks Pointer to the NULL-terminated table of tasks in the set. You must not
+ *  include a task more than once in the list, and the maximum number of recipient tasks
+ *  is 255. The table is copied, so it may be changed or freed once the call returns.
+ *  \return The new set. The caller holds one reference to it, which must be dropped
+ *  with MessageMulticastSetRelease().
+ *
+ * \ingroup trapset_core
+ */
+MulticastSet MessageMulticastSetCreate(const Task * tasks);
+
+/**
+ *  \brief Drop the caller's reference to a multicast recipient set. The set is freed
+ *  once it has been released and every message sent to it has been delivered or
+ *  cancelled.
+ *  \param set The set to release. NULL is ignored.
+ *
+ * \ingroup trapset_core
+ */
+void MessageMulticastSetRelease(MulticastSet set);
+
+/**
+ *  \brief Send a message to the tasks in a multicast recipient set after the given
+ *  delay in ms. The message will be passed to free after delivery. The message refers
+ *  to the set rather than copying it, and the caller's reference is not consumed.
+ *  \param set The recipient set, from MessageMulticastSetCreate().
+ *  \param id The message type identifier.
+ *  \param message The message data (if any).
+ *  \param delay The delay in ms before the message will be sent.
+ *
+ * \ingroup trapset_core
+ */
+void MessageSendMulticastSetLater(MulticastSet set, MessageId id, void * message, uint32 delay);
 #endif /* TRAPSET_CORE */
 #if TRAPSET_NFC
 
@@ -22,5 +22,9 @@ typedef struct TaskData *Task;
 TaskData type.
 */
 typedef struct TaskData { void (*handler)(Task, MessageId, Message);} TaskData;
+/*!
+Multicast recipient set type.
+*/
+typedef struct MulticastSetData *MulticastSet;
 
 #endif
@@ -75,6 +75,28 @@ void VmPutChar(uint16 channel, uint16 c);
  */
 uint16 VmGetAvailableAllocations(void );
 
+/**
+ *  \brief Reads the usage statistics of the memory pools 
+ *  \param stats Array to receive the statistics. 
+ *  \param first Index of the first pool to read; pools are numbered in order of
+ *  increasing block size. 
+ *  \param count Number of entries in \e stats. 
+ *  \return The total number of memory pools. Entries of \e stats beyond the last pool
+ *  are left untouched.
+ * 
+ * \ingroup trapset_core
+ */
+uint16 VmGetMemoryPoolStatistics(vm_memory_pool_statistics * stats, uint16 first, uint16 count);
+
+/**
+ *  \brief Resets the usage statistics of the memory pools 
+ *  The peak usage of each pool restarts from its current usage and the fallback
+ *  and failure counts are cleared.
+ * 
+ * \ingroup trapset_core
+ */
+void VmResetMemoryPoolStatistics(void );
+
 /**
  *  \brief Read the current value of a 32-bit millisecond timer.
  *   Don't poll this; using MessageSendLater is much more efficient.
@@ -0,0 +1,120 @@
+#! /usr/bin/env python
+############################################################################
+# CONFIDENTIAL
+#
+# Copyright (c) 2020 Qualcomm Technologies International, Ltd.
+#   %%version
+#
+#############################################################################
+
+from __future__ import print_function
+
+# Build the VM message queue from trap_api_message.c on the host and run its
+# test and benchmark. Every firmware header the queue includes is replaced by
+# an empty file; vm_message_queue_host.h supplies what is really needed.
+# The layout of AppMessage is checked for a 32-bit target separately, since
+# it decides which pmalloc pool each queued message takes.
+
+import optparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+FW_SRC_DIR = os.path.normpath(os.path.join(SCRIPT_DIR, "..", "..", "src"))
+TRAP_API_DIR = os.path.join(FW_SRC_DIR, "customer", "core", "trap_api")
+PRIVATE_HEADER = os.path.join(TRAP_API_DIR, "trap_api_private.h")
+MESSAGE_SOURCE = os.path.join(TRAP_API_DIR, "trap_api_message.c")
+HOST_HEADER = os.path.join(SCRIPT_DIR, "vm_message_queue_host.h")
+TEST_SOURCE = os.path.join(SCRIPT_DIR, "vm_message_queue_test.c")
+
+# Smallest pmalloc pool in earbud_pmalloc_pools.c, which every queued
+# message should fit
+SMALLEST_POOL_SIZE = 28
+
+INCLUDE_RE = re.compile(r'^\s*#\s*include\s+[<"]([^>"]+)[>"]', re.M)
+
+LAYOUT_CHECK = """
+#include "trap_api/trap_api_private.h"
+typedef char app_message_size[sizeof(AppMessage) == %d ? 1 : -1];
+"""
+
+def add_cmd_line_options(parser):
+    parser.add_option("-c", "--cc",
+                      dest="cc",
+                      type="string",
+                      help="Host C compiler",
+                      default="gcc")
+    parser.add_option("-n", "--no-benchmark",
+                      dest="benchmark",
+                      action="store_false",
+                      help="Only run the tests",
+                      default=True)
+
+def make_stub_headers(stub_dir):
+    """
+    Create an empty file for each header the queue includes, apart from
+    trap_api_private.h which is forwarded to the real one
+    """
+    for source in (MESSAGE_SOURCE, PRIVATE_HEADER):
+        with open(source) as f:
+            for header in INCLUDE_RE.findall(f.read()):
+                path = os.path.join(stub_dir, header)
+                if not os.path.isdir(os.path.dirname(path)):
+                    os.makedirs(os.path.dirname(path))
+                with open(path, "w") as stub:
+                    if os.path.basename(header) == "trap_api_private.h":
+                        stub.write('#include "%s"\n' % PRIVATE_HEADER)
+
+def check_layout(cc, stub_dir):
+    """
+    Check AppMessage still fits the smallest pool on a 32-bit target. Only
+    a syntax check is possible, as the host may have no 32-bit libraries.
+    """
+    check = os.path.join(stub_dir, "layout_check.c")
+    with open(check, "w") as f:
+        f.write(LAYOUT_CHECK % SMALLEST_POOL_SIZE)
+    return subprocess.call([cc, "-m32", "-fsyntax-only",
+                            "-DVM_MESSAGE_QUEUE_LAYOUT_ONLY",
+                            "-include", HOST_HEADER, "-I", stub_dir,
+                            check]) == 0
+
+def main():
+    parser = optparse.OptionParser()
+    add_cmd_line_options(parser)
+    options, _ = parser.parse_args()
+
+    work_dir = tempfile.mkdtemp()
+    try:
+        stub_dir = os.path.join(work_dir, "stubs")
+        make_stub_headers(stub_dir)
+
+        if not check_layout(options.cc, stub_dir):
+            print("AppMessage is not %d bytes on a 32-bit target"
+                  % SMALLEST_POOL_SIZE)
+            return 1
+        print("layout: AppMessage is %d bytes on a 32-bit target"
+              % SMALLEST_POOL_SIZE)
+
+        exe = os.path.join(work_dir, "vm_message_queue_test")
+        if subprocess.call([options.cc, "-O2", "-g", "-Wall",
+                            "-Wno-unused-function",
+                            "-Wno-pointer-to-int-cast",
+                            "-Wno-int-to-pointer-cast",
+                            "-include", HOST_HEADER,
+                            "-I", stub_dir, "-I", TRAP_API_DIR,
+                            "-o", exe, TEST_SOURCE]) != 0:
+            return 1
+
+        args = [exe]
+        if not options.benchmark:
+            args.append("--no-benchmark")
+        return subprocess.call(args)
+    finally:
+        shutil.rmtree(work_dir)
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,150 @@
+/* Copyright (c) 2020 Qualcomm Technologies International, Ltd. */
+/*   %%version */
+/**
+ * \file
+ * Host definitions standing in for the firmware headers that
+ * trap_api_message.c and trap_api_private.h include, so the VM message queue
+ * can be built and exercised on a PC. run_vm_message_queue_test.py replaces
+ * every firmware header with an empty file and forces this one in first.
+ *
+ * Only what the queue needs is modelled: time comes from a clock the test
+ * drives, pmalloc from a host allocator and IPC and scheduler calls do
+ * nothing beyond freeing what P0 would.
+ */
+
+#ifndef VM_MESSAGE_QUEUE_HOST_H_
+#define VM_MESSAGE_QUEUE_HOST_H_
+
+#include <stddef.h>
+#ifndef VM_MESSAGE_QUEUE_LAYOUT_ONLY
+#include <limits.h>
+#include <string.h>
+#endif
+
+#define DESKTOP_TEST_BUILD
+#define SCHEDULER_WITHOUT_RUNLEVELS
+#define TRAPSET_STREAM 0
+#define TRAPSET_OPERATOR 0
+#define TRAPSET_NFC 0
+
+#ifndef NULL
+#define NULL ((void *)0)
+#endif
+#define TRUE (1)
+#define FALSE (0)
+
+typedef unsigned char uint8;
+typedef unsigned short uint16;
+typedef unsigned int uint32;
+typedef int int32;
+typedef int bool;
+
+typedef uint16 MessageId;
+typedef uint32 Delay;
+typedef const void *Message;
+typedef struct TaskData *Task;
+typedef struct TaskData { void (*handler)(Task, MessageId, Message);} TaskData;
+typedef struct MulticastSetData *MulticastSet;
+
+typedef struct SINK_T *Sink;
+typedef struct SOURCE_T *Source;
+typedef uint16 taskid;
+typedef uint32 pio_size_bits;
+
+typedef enum
+{
+    IPC_MSG_TYPE_SYSTEM,
+    IPC_MSG_TYPE_NFC,
+    NUM_IPC_MSG_TYPES
+} IPC_MSG_TYPE;
+
+/* Message IDs the queue treats specially. Anything below
+ * MESSAGE_BLUESTACK_BASE_ is an ordinary application message. */
+#define MESSAGE_BLUESTACK_BASE_         (0x7000)
+#define MESSAGE_BLUESTACK_END_          (0x7100)
+#define MESSAGE_MORE_DATA               (0x8000)
+#define MESSAGE_MORE_SPACE              (0x8001)
+#define MESSAGE_PSFL_FAULT              (0x8002)
+#define MESSAGE_TX_POWER_CHANGE_EVENT   (0x8003)
+#define MESSAGE_USB_SUSPENDED           (0x8010)
+#define MESSAGE_USB_ENUMERATED          (0x8011)
+#define MESSAGE_USB_DECONFIGURED        (0x8012)
+#define MESSAGE_USB_ATTACHED            (0x8013)
+#define MESSAGE_USB_DETACHED            (0x8014)
+#define MESSAGE_USB_ALT_INTERFACE       (0x8015)
+#define MESSAGE_PIO_CHANGED             (0x8020)
+
+typedef struct { Source source; } MessageMoreData;
+typedef struct { Sink sink; } MessageMoreSpace;
+typedef struct { bool has_left_suspend; } MessageUsbSuspended;
+typedef struct { uint16 config_value; } MessageUsbConfigValue;
+typedef struct { uint16 interface; uint16 altsetting; } MessageUsbAltInterface;
+typedef struct
+{
+    uint16 state;
+    uint32 time;
+    uint16 state16to31;
+    uint16 bank;
+} MessagePioChanged;
+
+#define D_IMMEDIATE ((uint32)0)
+#define MAX_MULTICAST_RECIPIENTS 15
+#define MAX_MULTICAST_SET_RECIPIENTS 255
+
+void MessageFree(MessageId id, Message data);
+void trap_api_send_message_to_task_filtered(Task task, uint16 id,
+                                            void *message,
+                                            bool allow_duplicates);
+
+#define COMPILE_TIME_ASSERT(expr, name)
+#define ARRAY_DIM(x) (sizeof(x) / sizeof((x)[0]))
+#define UNUSED(x) ((void)(x))
+#define VALIDATE_FN_PTR(f) ((void)0)
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+/* pmalloc */
+void *pmalloc(size_t size);
+void *zpmalloc(size_t size);
+void *xpmalloc(size_t size);
+void pfree(void *ptr);
+#define pnew(t) ((t *)pmalloc(sizeof(t)))
+#define zpnew(t) ((t *)zpmalloc(sizeof(t)))
+
+/* panic */
+typedef enum
+{
+    PANIC_P1_VM_MESSAGE_NULL_TASK_LIST = 1,
+    PANIC_P1_VM_MESSAGE_TOO_MANY_RECIPIENTS,
+    PANIC_HYDRA_PRIVATE_MEMORY_EXHAUSTION
+} panicid;
+void panic(panicid id);
+void panic_diatribe(panicid id, uint32 diatribe);
+#define assert(x) do { if (!(x)) panic_diatribe(0, __LINE__); } while (0)
+
+/* Time */
+uint32 get_milli_time(void);
+
+/* IPC */
+typedef enum
+{
+    IPC_SIGNAL_ID_BLUESTACK_PRIM_RECEIVED,
+    IPC_SIGNAL_ID_APP_MESSAGE_RECEIVED
+} IPC_SIGNAL_ID;
+typedef struct { uint16 protocol; void *prim; } IPC_BLUESTACK_PRIM;
+typedef struct { uint16 id; void *msg; } IPC_APP_MESSAGE_RECEIVED;
+void ipc_send(IPC_SIGNAL_ID id, const void *msg, uint32 len);
+
+/* Scheduler */
+typedef uint32 msgid;
+typedef uint32 INTERVAL;
+typedef uint16 qid;
+extern qid trap_api_sched_queue_id;
+msgid put_message(qid q, uint16 id, void *m);
+msgid put_message_in(INTERVAL delay, qid q, uint16 id, void *m);
+bool cancel_timed_message(qid q, msgid m, uint16 *id, void **pm);
+bool get_message(qid q, uint16 *id, void **pm);
+void sched(void);
+
+#endif /* VM_MESSAGE_QUEUE_HOST_H_ */
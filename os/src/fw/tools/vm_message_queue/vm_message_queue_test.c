@@ -0,0 +1,1123 @@
+/* Copyright (c) 2020 Qualcomm Technologies International, Ltd. */
+/*   %%version */
+/**
+ * \file
+ * Host test and benchmark for the VM message queue in trap_api_message.c.
+ *
+ * The queue is built from the firmware source and checked against a model of
+ * the original implementation, one time-ordered list that every call walks:
+ *  - random sends, filtered sends, cancels, flushes, pending queries,
+ *    condition changes and deliveries must give the same deliveries and
+ *    results from both,
+ *  - a stress run keeps well over 200 messages pending and checks that no
+ *    allocation is larger than the biggest P1 pmalloc pool,
+ *  - a benchmark times send, cancel, pending and delivery against the list
+ *    with different numbers of messages pending.
+ *
+ * Build and run with run_vm_message_queue_test.py.
+ */
+
+#include "trap_api_message.c"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+
+/** Largest pool in earbud_pmalloc_pools.c */
+#define LARGEST_POOL_SIZE (692)
+
+#define NUM_TASKS (6)
+#define MAX_LOG (1 << 16)
+
+/* ------------------------------------------------------------------------
+ * Memory
+ *
+ * The firmware passes pointers through uint32, as in MessageFree(), so every
+ * block the queue or its messages use comes from an arena below 4GB.
+ * ------------------------------------------------------------------------ */
+
+#define ARENA_SIZE (64u << 20)
+#define ARENA_GRAIN (16u)
+#define ARENA_CLASSES (64u)
+
+static uint8 *arena, *arena_top;
+static void *arena_free[ARENA_CLASSES + 1];
+
+static void *host_malloc(size_t size)
+{
+    size_t cls = (size + ARENA_GRAIN - 1) / ARENA_GRAIN;
+    uint8 *block;
+
+    if (cls > ARENA_CLASSES)
+    {
+        fprintf(stderr, "allocation of %u bytes is too big\n", (unsigned)size);
+        abort();
+    }
+    if (!arena)
+    {
+        arena = mmap(NULL, ARENA_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+        if (arena == MAP_FAILED)
+        {
+            perror("mmap");
+            abort();
+        }
+        arena_top = arena;
+    }
+    if (arena_free[cls])
+    {
+        block = arena_free[cls];
+        arena_free[cls] = *(void **)block;
+    }
+    else
+    {
+        if (arena_top + ARENA_GRAIN * (cls + 1) > arena + ARENA_SIZE)
+        {
+            fprintf(stderr, "arena exhausted\n");
+            abort();
+        }
+        block = arena_top + ARENA_GRAIN;
+        ((size_t *)block)[-1] = cls;
+        arena_top += ARENA_GRAIN * (cls + 1);
+    }
+    return block;
+}
+
+static void *host_calloc(size_t count, size_t size)
+{
+    void *p = host_malloc(count * size);
+    memset(p, 0, count * size);
+    return p;
+}
+
+static void host_free(void *p)
+{
+    if (p)
+    {
+        size_t cls = ((size_t *)p)[-1];
+        *(void **)p = arena_free[cls];
+        arena_free[cls] = p;
+    }
+}
+
+/* ------------------------------------------------------------------------
+ * Firmware services
+ * ------------------------------------------------------------------------ */
+
+qid trap_api_sched_queue_id;
+static uint32 host_now;
+static size_t host_largest_alloc;
+
+uint32 get_milli_time(void)
+{
+    return host_now;
+}
+
+void *pmalloc(size_t size)
+{
+    void *p = host_malloc(size);
+    if (size > host_largest_alloc)
+    {
+        host_largest_alloc = size;
+    }
+    if (!p)
+    {
+        panic(PANIC_HYDRA_PRIVATE_MEMORY_EXHAUSTION);
+    }
+    return p;
+}
+
+/**
+ * Allocation that may fail. Failures are injected in the random test to
+ * exercise cancelling and flushing without memory to copy a shared set.
+ */
+static bool host_fail_xpmalloc;
+static uint32 rnd(uint32 n);
+static unsigned host_xpmalloc_failures;
+
+void *xpmalloc(size_t size)
+{
+    if (host_fail_xpmalloc && (rnd(2) == 0) &&
+        vm_message_blocked_count < VM_MESSAGE_BLOCKED_MAX)
+    {
+        host_xpmalloc_failures++;
+        return NULL;
+    }
+    return pmalloc(size);
+}
+
+void *zpmalloc(size_t size)
+{
+    void *p = pmalloc(size);
+    memset(p, 0, size);
+    return p;
+}
+
+void pfree(void *ptr)
+{
+    host_free(ptr);
+}
+
+void panic(panicid id)
+{
+    fprintf(stderr, "panic %d\n", (int)id);
+    abort();
+}
+
+void panic_diatribe(panicid id, uint32 diatribe)
+{
+    fprintf(stderr, "panic %d (0x%x)\n", (int)id, diatribe);
+    abort();
+}
+
+void ipc_send(IPC_SIGNAL_ID id, const void *msg, uint32 len)
+{
+    /* P0 would free the payload once told the application has seen it */
+    if (id == IPC_SIGNAL_ID_APP_MESSAGE_RECEIVED)
+    {
+        host_free(((const IPC_APP_MESSAGE_RECEIVED *)msg)->msg);
+    }
+    else
+    {
+        host_free(((const IPC_BLUESTACK_PRIM *)msg)->prim);
+    }
+    UNUSED(len);
+}
+
+msgid put_message(qid q, uint16 id, void *m)
+{
+    UNUSED(q);
+    UNUSED(id);
+    UNUSED(m);
+    return 1;
+}
+
+msgid put_message_in(INTERVAL delay, qid q, uint16 id, void *m)
+{
+    UNUSED(delay);
+    return put_message(q, id, m);
+}
+
+bool cancel_timed_message(qid q, msgid m, uint16 *id, void **pm)
+{
+    UNUSED(q);
+    UNUSED(m);
+    UNUSED(id);
+    UNUSED(pm);
+    return TRUE;
+}
+
+bool get_message(qid q, uint16 *id, void **pm)
+{
+    UNUSED(q);
+    UNUSED(id);
+    UNUSED(pm);
+    return FALSE;
+}
+
+void sched(void)
+{
+}
+
+void trap_api_message_log_now(TRAP_API_LOG_ACTION action, AppMessage *msg,
+                              uint32 nowtime)
+{
+    UNUSED(action);
+    UNUSED(msg);
+    UNUSED(nowtime);
+}
+
+/* ------------------------------------------------------------------------
+ * Recipients and payloads
+ * ------------------------------------------------------------------------ */
+
+typedef struct
+{
+    int task;
+    uint16 id;
+    uint32 value;
+} DELIVERY;
+
+typedef struct
+{
+    DELIVERY entries[MAX_LOG];
+    unsigned count;
+} DELIVERY_LOG;
+
+static TaskData tasks[NUM_TASKS];
+static DELIVERY_LOG queue_log, list_log;
+static DELIVERY_LOG *current_log = &queue_log;
+
+static uint16 cond16[2];
+static uint32 cond32;
+
+/** Payload big enough for any of the messages sent */
+typedef union
+{
+    MessageMoreData more_data;
+    MessageMoreSpace more_space;
+    MessageUsbSuspended suspended;
+    MessageUsbConfigValue config;
+    MessageUsbAltInterface alt;
+    uint32 value;
+} PAYLOAD;
+
+static bool has_payload(uint16 id)
+{
+    return id != MESSAGE_USB_ATTACHED && id != MESSAGE_USB_DETACHED;
+}
+
+static void *make_payload(uint16 id, uint32 value)
+{
+    PAYLOAD *p;
+
+    if (!has_payload(id))
+    {
+        return NULL;
+    }
+    p = host_calloc(1, sizeof(*p));
+    switch (id)
+    {
+    case MESSAGE_MORE_DATA:
+        p->more_data.source = (Source)(uintptr_t)(value + 1);
+        break;
+    case MESSAGE_MORE_SPACE:
+        p->more_space.sink = (Sink)(uintptr_t)(value + 1);
+        break;
+    case MESSAGE_USB_SUSPENDED:
+        p->suspended.has_left_suspend = (bool)(value & 1);
+        break;
+    case MESSAGE_USB_ENUMERATED:
+    case MESSAGE_USB_DECONFIGURED:
+        p->config.config_value = (uint16)value;
+        break;
+    case MESSAGE_USB_ALT_INTERFACE:
+        p->alt.interface = (uint16)(value & 1);
+        p->alt.altsetting = (uint16)(value >> 1);
+        break;
+    default:
+        p->value = value;
+        break;
+    }
+    return p;
+}
+
+static void *copy_payload(uint16 id, const void *payload)
+{
+    void *p = NULL;
+    if (payload)
+    {
+        p = host_malloc(sizeof(PAYLOAD));
+        memcpy(p, payload, sizeof(PAYLOAD));
+    }
+    UNUSED(id);
+    return p;
+}
+
+static uint32 payload_value(uint16 id, Message m)
+{
+    const PAYLOAD *p = (const PAYLOAD *)m;
+
+    if (!p)
+    {
+        return 0;
+    }
+    switch (id)
+    {
+    case MESSAGE_MORE_DATA:
+        return (uint32)(uintptr_t)p->more_data.source;
+    case MESSAGE_MORE_SPACE:
+        return (uint32)(uintptr_t)p->more_space.sink;
+    case MESSAGE_USB_SUSPENDED:
+        return (uint32)p->suspended.has_left_suspend;
+    case MESSAGE_USB_ENUMERATED:
+    case MESSAGE_USB_DECONFIGURED:
+        return p->config.config_value;
+    case MESSAGE_USB_ALT_INTERFACE:
+        return ((uint32)p->alt.interface << 16) | p->alt.altsetting;
+    default:
+        return p->value;
+    }
+}
+
+static void record(DELIVERY_LOG *log, Task t, MessageId id, Message m)
+{
+    DELIVERY *d;
+
+    if (log->count == MAX_LOG)
+    {
+        fprintf(stderr, "delivery log full\n");
+        abort();
+    }
+    d = &log->entries[log->count++];
+    d->task = (int)(t - tasks);
+    d->id = id;
+    d->value = payload_value(id, m);
+}
+
+static void host_handler(Task t, MessageId id, Message m)
+{
+    record(current_log, t, id, m);
+}
+
+/* ------------------------------------------------------------------------
+ * Model of the original queue: one list in due order, walked by every call
+ * ------------------------------------------------------------------------ */
+
+static AppMessage *list_queue;
+
+static MulticastSet list_set_copy(const Task *tlist)
+{
+    unsigned count = 0;
+    MulticastSet set;
+
+    while (tlist[count])
+    {
+        count++;
+    }
+    set = host_malloc(sizeof(struct MulticastSetData) + count * sizeof(Task));
+    set->refs = 1;
+    set->count = (uint8)count;
+    memcpy(set->tasks, tlist, (count + 1) * sizeof(Task));
+    return set;
+}
+
+static void list_free(AppMessage *a)
+{
+    host_free(a->message);
+    if (a->multicast)
+    {
+        host_free(a->t.set);
+    }
+    host_free(a);
+}
+
+static void list_send(const Task *task, bool multicast, uint16 id,
+                      void *message, uint32 delay, const void *c,
+                      CONDITION_WIDTH c_width)
+{
+    AppMessage *a = host_calloc(1, sizeof(*a));
+    AppMessage **p = &list_queue, *prev = NULL;
+
+    if (multicast)
+    {
+        a->t.set = list_set_copy(task);
+        a->multicast = a->t.set->count;
+    }
+    else
+    {
+        a->t.task = *task;
+    }
+    a->id = id;
+    a->message = message;
+    a->condition_addr = c;
+    a->c_width = (uint8)c_width;
+    a->due = delay + host_now;
+
+    while (*p && VM_DIFF(a->due, (*p)->due) >= 0)
+    {
+        prev = *p;
+        p = &prev->next;
+    }
+    if (prev && similar(prev, a))
+    {
+        list_free(a);
+        return;
+    }
+    a->next = *p;
+    *p = a;
+}
+
+static bool list_already(Task task, uint16 id, void *message)
+{
+    AppMessage *p;
+    AppMessage temp;
+
+    temp.multicast = 0;
+    temp.t.task = task;
+    temp.id = id;
+    temp.message = message;
+    for (p = list_queue; p; p = p->next)
+    {
+        if (similar(p, &temp) || replace(p, &temp))
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static void list_send_filtered(Task task, uint16 id, void *message)
+{
+    if (list_already(task, id, message))
+    {
+        host_free(message);
+    }
+    else
+    {
+        list_send(&task, FALSE, id, message, D_IMMEDIATE, NULL,
+                  CONDITION_WIDTH_UNUSED);
+    }
+}
+
+/** Block a task out of a multicast message the way the original did */
+static bool list_invalidate(AppMessage *a, Task task)
+{
+    Task *tptr;
+    bool valid_tasks = FALSE;
+
+    for (tptr = a->t.set->tasks; *tptr; tptr++)
+    {
+        if (*tptr == task)
+        {
+            *tptr = (Task)INVALIDATED_TASK;
+        }
+        if (*tptr != (Task)INVALIDATED_TASK)
+        {
+            valid_tasks = TRUE;
+        }
+    }
+    return valid_tasks;
+}
+
+static bool list_is_for_task(const AppMessage *a, Task task)
+{
+    const Task *tptr;
+
+    if (!a->multicast)
+    {
+        return a->t.task == task;
+    }
+    for (tptr = a->t.set->tasks; *tptr; tptr++)
+    {
+        if (*tptr == task)
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static bool list_cancel_first(Task task, uint16 id)
+{
+    AppMessage **p = &list_queue;
+
+    while (*p)
+    {
+        AppMessage *a = *p;
+        bool valid_tasks = TRUE;
+
+        if (a->id == id)
+        {
+            if (a->multicast)
+            {
+                valid_tasks = list_invalidate(a, task);
+            }
+            if ((!a->multicast && a->t.task == task) || !valid_tasks)
+            {
+                *p = a->next;
+                list_free(a);
+                return TRUE;
+            }
+        }
+        p = &(*p)->next;
+    }
+    return FALSE;
+}
+
+static uint16 list_cancel_all(Task task, uint16 id)
+{
+    uint16 count = 0;
+    while (list_cancel_first(task, id))
+    {
+        count++;
+    }
+    return count;
+}
+
+static uint16 list_flush(Task task)
+{
+    AppMessage **p = &list_queue;
+    uint16 count = 0;
+
+    while (*p)
+    {
+        AppMessage *a = *p;
+        bool valid_tasks = TRUE;
+
+        if (a->multicast)
+        {
+            valid_tasks = list_invalidate(a, task);
+        }
+        if ((!a->multicast && a->t.task == task) || !valid_tasks)
+        {
+            *p = a->next;
+            list_free(a);
+            ++count;
+        }
+        else
+        {
+            p = &(*p)->next;
+        }
+    }
+    return count;
+}
+
+static uint16 list_pending_for_task(Task task, int32 *first_due)
+{
+    AppMessage *p;
+    uint16 count = 0;
+
+    for (p = list_queue; p; p = p->next)
+    {
+        if (list_is_for_task(p, task))
+        {
+            if (!count && first_due)
+            {
+                *first_due = VM_DIFF(p->due, host_now);
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+static bool list_pending_first(Task task, uint16 id, int32 *first_due)
+{
+    AppMessage *p;
+
+    for (p = list_queue; p; p = p->next)
+    {
+        if (list_is_for_task(p, task) && p->id == id)
+        {
+            if (first_due)
+            {
+                *first_due = VM_DIFF(p->due, host_now);
+            }
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static uint32 list_next(void)
+{
+    AppMessage *a;
+    AppMessage **p = &list_queue;
+
+    while ((a = *p) != NULL)
+    {
+        if (a->condition_addr == NULL ||
+            get_message_condition_value(a->condition_addr,
+                                        (CONDITION_WIDTH)a->c_width) == 0)
+        {
+            break;
+        }
+        p = &a->next;
+    }
+    if (!a)
+    {
+        return (uint32)-1;
+    }
+    if (VM_DIFF(a->due, host_now) > 0)
+    {
+        return (uint32)VM_DIFF(a->due, host_now);
+    }
+    *p = a->next;
+    if (a->multicast)
+    {
+        Task *tptr;
+        for (tptr = a->t.set->tasks; *tptr; tptr++)
+        {
+            if (*tptr != (Task)INVALIDATED_TASK)
+            {
+                record(&list_log, *tptr, a->id, a->message);
+            }
+        }
+    }
+    else
+    {
+        record(&list_log, a->t.task, a->id, a->message);
+    }
+    list_free(a);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------
+ * Driving both queues
+ * ------------------------------------------------------------------------ */
+
+static unsigned failures;
+
+#define CHECK(cond, ...) \
+    do { if (!(cond)) { fprintf(stderr, __VA_ARGS__); failures++; } } while (0)
+
+static uint32 rnd_state = 12345;
+
+static uint32 rnd(uint32 n)
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return (rnd_state >> 8) % n;
+}
+
+static Task random_task(void)
+{
+    return &tasks[rnd(NUM_TASKS)];
+}
+
+static const uint16 ids[] =
+{
+    1, 2, 3,
+    MESSAGE_MORE_DATA, MESSAGE_MORE_SPACE, MESSAGE_PSFL_FAULT,
+    MESSAGE_USB_SUSPENDED, MESSAGE_USB_ENUMERATED, MESSAGE_USB_DECONFIGURED,
+    MESSAGE_USB_ATTACHED, MESSAGE_USB_DETACHED, MESSAGE_USB_ALT_INTERFACE
+};
+
+static uint16 random_id(void)
+{
+    return ids[rnd(ARRAY_DIM(ids))];
+}
+
+static uint32 random_delay(uint32 max)
+{
+    static const uint32 delays[] = { 0, 0, 0, 1, 2, 5, 10, 20 };
+    uint32 d = delays[rnd(ARRAY_DIM(delays))];
+    return (max > 20 && rnd(4) == 0) ? rnd(max) : d;
+}
+
+static void compare_logs(const char *when)
+{
+    unsigned i;
+
+    CHECK(queue_log.count == list_log.count,
+          "%s: %u deliveries, list made %u\n", when, queue_log.count,
+          list_log.count);
+    for (i = 0; i < queue_log.count && i < list_log.count; i++)
+    {
+        const DELIVERY *q = &queue_log.entries[i], *l = &list_log.entries[i];
+        if (q->task != l->task || q->id != l->id || q->value != l->value)
+        {
+            CHECK(FALSE, "%s: delivery %u is (%d, 0x%x, %u), list gave "
+                  "(%d, 0x%x, %u)\n", when, i, q->task, q->id, q->value,
+                  l->task, l->id, l->value);
+            break;
+        }
+    }
+    queue_log.count = list_log.count = 0;
+}
+
+static void deliver_due(void)
+{
+    while (vm_message_next() == 0)
+    {
+    }
+    while (list_next() == 0)
+    {
+    }
+}
+
+static void send_both(Task *tlist, bool multicast, uint16 id, uint32 delay,
+                      const void *c, CONDITION_WIDTH c_width)
+{
+    void *payload = make_payload(id, rnd(4));
+    list_send(tlist, multicast, id, copy_payload(id, payload), delay, c,
+              c_width);
+    vm_message_send_later(tlist, multicast, id, payload, delay, c, c_width);
+}
+
+static void random_condition(const void **c, CONDITION_WIDTH *c_width)
+{
+    switch (rnd(3))
+    {
+    case 0:
+        *c = &cond16[0];
+        *c_width = CONDITION_WIDTH_16BIT;
+        break;
+    case 1:
+        *c = &cond16[1];
+        *c_width = CONDITION_WIDTH_16BIT;
+        break;
+    default:
+        *c = &cond32;
+        *c_width = CONDITION_WIDTH_32BIT;
+        break;
+    }
+}
+
+static void random_tlist(Task *tlist)
+{
+    unsigned n = 2 + rnd(3), i;
+    for (i = 0; i < n; i++)
+    {
+        tlist[i] = random_task();
+    }
+    tlist[n] = NULL;
+}
+
+static void random_op(uint32 max_delay)
+{
+    Task task = random_task();
+    uint16 id = random_id();
+    Task tlist[8];
+    const void *c;
+    CONDITION_WIDTH c_width;
+    int32 due_q = 0, due_l = 0;
+    unsigned op = rnd(100);
+
+    if (op < 30)
+    {
+        send_both(&task, FALSE, id, random_delay(max_delay), NULL,
+                  CONDITION_WIDTH_UNUSED);
+    }
+    else if (op < 40)
+    {
+        random_condition(&c, &c_width);
+        send_both(&task, FALSE, id, D_IMMEDIATE, c, c_width);
+    }
+    else if (op < 46)
+    {
+        random_tlist(tlist);
+        if (rnd(3) == 0)
+        {
+            random_condition(&c, &c_width);
+            send_both(tlist, TRUE, id, D_IMMEDIATE, c, c_width);
+        }
+        else
+        {
+            send_both(tlist, TRUE, id, random_delay(max_delay), NULL,
+                      CONDITION_WIDTH_UNUSED);
+        }
+    }
+    else if (op < 50)
+    {
+        /* One set shared by several messages */
+        MulticastSet set;
+        void *payload;
+        unsigned n = 1 + rnd(3);
+
+        random_tlist(tlist);
+        set = MessageMulticastSetCreate(tlist);
+        while (n--)
+        {
+            uint32 delay = random_delay(max_delay);
+            payload = make_payload(id, rnd(4));
+            list_send(tlist, TRUE, id, copy_payload(id, payload), delay,
+                      NULL, CONDITION_WIDTH_UNUSED);
+            MessageSendMulticastSetLater(set, id, payload, delay);
+        }
+        MessageMulticastSetRelease(set);
+    }
+    else if (op < 65)
+    {
+        /* A message from P0, filtered against the queue */
+        void *payload = make_payload(id, rnd(4));
+        list_send_filtered(task, id, copy_payload(id, payload));
+        trap_api_send_message_to_task_filtered(task, id, payload, FALSE);
+    }
+    else if (op < 72)
+    {
+        bool q = MessageCancelFirst(task, id);
+        bool l = list_cancel_first(task, id);
+        CHECK(q == l, "MessageCancelFirst gave %d, list gave %d\n", q, l);
+    }
+    else if (op < 75)
+    {
+        uint16 q = MessageCancelAll(task, id);
+        uint16 l = list_cancel_all(task, id);
+        CHECK(q == l, "MessageCancelAll gave %u, list gave %u\n", q, l);
+    }
+    else if (op < 77)
+    {
+        uint16 q = MessageFlushTask(task);
+        uint16 l = list_flush(task);
+        CHECK(q == l, "MessageFlushTask gave %u, list gave %u\n", q, l);
+    }
+    else if (op < 82)
+    {
+        uint16 q = MessagesPendingForTask(task, &due_q);
+        uint16 l = list_pending_for_task(task, &due_l);
+        CHECK(q == l && (!q || due_q == due_l),
+              "MessagesPendingForTask gave %u (%d), list gave %u (%d)\n",
+              q, due_q, l, due_l);
+    }
+    else if (op < 87)
+    {
+        bool q = MessagePendingFirst(task, id, &due_q);
+        bool l = list_pending_first(task, id, &due_l);
+        CHECK(q == l && (!q || due_q == due_l),
+              "MessagePendingFirst gave %d (%d), list gave %d (%d)\n",
+              q, due_q, l, due_l);
+    }
+    else if (op < 93)
+    {
+        switch (rnd(3))
+        {
+        case 0:
+            cond16[0] = (uint16)rnd(2);
+            break;
+        case 1:
+            cond16[1] = (uint16)rnd(2);
+            break;
+        default:
+            cond32 = rnd(2) ? 0x10000u : 0;
+            break;
+        }
+    }
+    else
+    {
+        host_now += rnd(8);
+        deliver_due();
+        compare_logs("delivery");
+    }
+}
+
+static void drain(const char *when)
+{
+    int i;
+
+    cond16[0] = cond16[1] = 0;
+    cond32 = 0;
+    for (i = 0; i < 10000 && (vm_message_next() != (uint32)-1 ||
+                              list_next() != (uint32)-1); i++)
+    {
+        host_now += 50;
+        deliver_due();
+    }
+    compare_logs(when);
+    CHECK(vm_message_next() == (uint32)-1, "%s: queue not empty\n", when);
+}
+
+static void test_random(void)
+{
+    unsigned run, i;
+
+    for (run = 0; run < 200; run++)
+    {
+        /* Some runs cross the wrap of the millisecond clock */
+        host_now = (run & 1) ? 0xffffff00u + rnd(0x100) : rnd(1000);
+        /* Half the runs are short of memory to copy shared sets */
+        host_fail_xpmalloc = (run & 2) != 0;
+        for (i = 0; i < 2000; i++)
+        {
+            random_op(100);
+        }
+        drain("random run");
+    }
+    host_fail_xpmalloc = FALSE;
+    printf("random: %u runs of 2000 operations, %u shared sets not copied\n",
+           run, host_xpmalloc_failures);
+}
+
+static void test_stress(void)
+{
+    unsigned i, pending, most = 0;
+    uint16 b, longest = 0;
+
+    host_largest_alloc = 0;
+    host_now = 0xfffff000u;
+    for (i = 0; i < 4000; i++)
+    {
+        /* Mostly sends, with delays long enough for the queue to build up */
+        if (rnd(10) < 8)
+        {
+            Task task = random_task();
+            send_both(&task, FALSE, (uint16)(1 + rnd(40)),
+                      random_delay(20000), NULL, CONDITION_WIDTH_UNUSED);
+        }
+        else
+        {
+            random_op(20000);
+        }
+
+        for (pending = 0, b = 0; b < NUM_TASKS; b++)
+        {
+            pending += MessagesPendingForTask(&tasks[b], NULL);
+        }
+        most = pending > most ? pending : most;
+    }
+
+    for (b = 0; b < VM_MESSAGE_INDEX_BUCKETS; b++)
+    {
+        const AppMessage *p;
+        uint16 n = 0;
+        for (p = vm_message_bucket_first(b); p; p = vm_message_bucket_next(b, p))
+        {
+            n++;
+        }
+        longest = n > longest ? n : longest;
+    }
+    drain("stress");
+
+    CHECK(most > 200, "stress only reached %u pending messages\n", most);
+    CHECK(host_largest_alloc <= LARGEST_POOL_SIZE,
+          "queue allocated %u bytes, more than the largest pool\n",
+          (unsigned)host_largest_alloc);
+    printf("stress: up to %u messages pending, longest bucket %u, largest "
+           "allocation %u bytes\n", most, longest,
+           (unsigned)host_largest_alloc);
+}
+
+/* ------------------------------------------------------------------------
+ * Benchmark
+ * ------------------------------------------------------------------------ */
+
+static double seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct
+{
+    double send_cancel;
+    double pending;
+    double deliver;
+} TIMES;
+
+static void fill(unsigned pending, bool use_list)
+{
+    unsigned i;
+    for (i = 0; i < pending; i++)
+    {
+        Task task = &tasks[i % NUM_TASKS];
+        uint16 id = (uint16)(100 + i % 50);
+        uint32 delay = 100000 + rnd(100000);
+        if (use_list)
+        {
+            list_send(&task, FALSE, id, NULL, delay, NULL,
+                      CONDITION_WIDTH_UNUSED);
+        }
+        else
+        {
+            MessageSendLater(task, id, NULL, delay);
+        }
+    }
+}
+
+static TIMES bench(unsigned pending, bool use_list)
+{
+    const unsigned reps = 20000;
+    unsigned i;
+    TIMES t;
+    double start;
+    volatile unsigned sink = 0;
+
+    rnd_state = 1;
+    fill(pending, use_list);
+
+    /* Send a message that is cancelled before it is due, as timers are */
+    start = seconds();
+    for (i = 0; i < reps; i++)
+    {
+        Task task = &tasks[i % NUM_TASKS];
+        uint16 id = (uint16)(100 + i % 50);
+        uint32 delay = 100000 + rnd(100000);
+        if (use_list)
+        {
+            list_send(&task, FALSE, id, NULL, delay, NULL,
+                      CONDITION_WIDTH_UNUSED);
+            sink += list_cancel_first(task, id);
+        }
+        else
+        {
+            MessageSendLater(task, id, NULL, delay);
+            sink += MessageCancelFirst(task, id);
+        }
+    }
+    t.send_cancel = (seconds() - start) / reps;
+
+    /* Ask whether a message is pending */
+    start = seconds();
+    for (i = 0; i < reps; i++)
+    {
+        Task task = &tasks[i % NUM_TASKS];
+        uint16 id = (uint16)(100 + (i * 7) % 60);
+        sink += use_list ? list_pending_first(task, id, NULL) :
+                           MessagePendingFirst(task, id, NULL);
+    }
+    t.pending = (seconds() - start) / reps;
+
+    /* Send a message for immediate delivery and deliver it */
+    start = seconds();
+    for (i = 0; i < reps; i++)
+    {
+        Task task = &tasks[i % NUM_TASKS];
+        if (use_list)
+        {
+            list_send(&task, FALSE, 1, NULL, D_IMMEDIATE, NULL,
+                      CONDITION_WIDTH_UNUSED);
+            sink += list_next();
+        }
+        else
+        {
+            MessageSendLater(task, 1, NULL, D_IMMEDIATE);
+            sink += vm_message_next();
+        }
+    }
+    t.deliver = (seconds() - start) / reps;
+
+    /* Empty the queue without recording deliveries */
+    for (i = 0; i < NUM_TASKS; i++)
+    {
+        if (use_list)
+        {
+            list_flush(&tasks[i]);
+        }
+        else
+        {
+            MessageFlushTask(&tasks[i]);
+        }
+    }
+    queue_log.count = list_log.count = 0;
+    UNUSED(sink);
+    return t;
+}
+
+static void benchmark(void)
+{
+    static const unsigned sizes[] = { 10, 50, 200, 500 };
+    unsigned i;
+
+    host_now = 0;
+    printf("\nns per operation       send+cancel         pending"
+           "         deliver\n");
+    printf("pending            list    queue     list    queue"
+           "     list    queue\n");
+    for (i = 0; i < ARRAY_DIM(sizes); i++)
+    {
+        TIMES l = bench(sizes[i], TRUE);
+        TIMES q = bench(sizes[i], FALSE);
+        printf("%7u        %8.0f %8.0f %8.0f %8.0f %8.0f %8.0f\n", sizes[i],
+               l.send_cancel * 1e9, q.send_cancel * 1e9,
+               l.pending * 1e9, q.pending * 1e9,
+               l.deliver * 1e9, q.deliver * 1e9);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned i;
+
+    for (i = 0; i < NUM_TASKS; i++)
+    {
+        tasks[i].handler = host_handler;
+    }
+
+    test_random();
+    test_stress();
+    if (argc < 2 || strcmp(argv[1], "--no-benchmark") != 0)
+    {
+        benchmark();
+    }
+
+    if (failures)
+    {
+        printf("FAILED: %u checks\n", failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}